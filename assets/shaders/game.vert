@@ -4,23 +4,26 @@
 layout(location = 0) in vec4 vertex_position;
 layout(location = 1) in vec2 vertex_texcoords;
 layout(location = 2) in vec4 vertex_color;
-layout(location = 3) in vec3 vertex_normal;
 
 layout(location = 0) uniform vec2 screen_resolution;
 
 out vec3 vp_pos;
 out vec2 vp_texcoords;
 out vec4 vp_color;
-out vec3 vp_normal;
 out float vp_z;
 
+vec3 srgb_to_linear(vec3 c)
+{
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
 void main()
 {
     gl_Position = vertex_position;
 
     vp_pos = vec3(vertex_position.xy, vertex_position.w);
     vp_texcoords = vertex_texcoords;
-    vp_color = vertex_color;
-    vp_normal = vertex_normal;
+    // Vertex colors arrive as sRGB with straight alpha
+    vp_color = vec4(srgb_to_linear(vertex_color.rgb) * vertex_color.a, vertex_color.a);
     vp_z = vertex_position.w;
 }
@@ -1,7 +1,7 @@
 #version 330 core
 #extension GL_ARB_explicit_uniform_location : require
 
-layout(location = 1) uniform vec4 features;
+layout(location = 1) uniform vec2 features;
 
 layout(location = 2) uniform sampler2D albedo_map;
 layout(location = 3) uniform vec4 albedo_factor;
@@ -9,21 +9,36 @@ layout(location = 3) uniform vec4 albedo_factor;
 layout(location = 4) uniform sampler2D emissive_map;
 layout(location = 5) uniform vec3 emissive_factor;
 
+#ifdef ALPHA_MASK
 layout(location = 6) uniform float alpha_cutoff;
+#endif
 
+#ifdef PARALLAX_MAPPING
 layout(location = 7) uniform sampler2D displacement_map;
 layout(location = 8) uniform float displacement_factor;
+#endif
 
 in vec3 vp_pos;
 in vec2 vp_texcoords;
 in vec4 vp_color;
-in vec3 vp_normal;
 in float vp_z;
 
+// Flat face normal, derived from screen-space derivatives instead of a vertex attribute
+vec3 vp_normal;
+
+vec3 face_normal()
+{
+    vec3 n = normalize(cross(dFdx(vp_pos), dFdy(vp_pos)));
+
+    // JK disables backface culling. Make all of the normals face the viewer.
+    return (dot(n, vp_pos) > 0.0) ? -n : n;
+}
+
 layout(location = 0) out vec4 out_color;
 layout(location = 1) out vec4 out_emissive;
 layout(location = 2) out vec4 out_depth_nrm;
 
+#ifdef PARALLAX_MAPPING
 mat3 construct_tbn()
 {
     vec3 n = normalize(vp_normal);
@@ -80,37 +95,45 @@ vec3 parallax_mapping(vec2 tc)
 
     return vec3(adj_tc, adj_vp_z);
 }
+#endif
 
 void main()
 {
+    vp_normal = face_normal();
+
     vec2 adj_texcoords = vp_texcoords;
     float adj_vp_z = vp_z;
 
-    if(displacement_factor != 0.0) {
-        vec3 pmapv = parallax_mapping(vp_texcoords);
-        adj_texcoords = pmapv.xy;
-        adj_vp_z += pmapv.z;
-    }
+#ifdef PARALLAX_MAPPING
+    vec3 pmapv = parallax_mapping(vp_texcoords);
+    adj_texcoords = pmapv.xy;
+    adj_vp_z += pmapv.z;
+#endif
 
     vec4 albedo_map_sample = texture(albedo_map, adj_texcoords);
     albedo_map_sample = mix(vec4(1.0), albedo_map_sample, features.x);
 
-    if(features.z > 0.5) {
-        if(albedo_map_sample.a < alpha_cutoff) {
-            discard;
-        }
-
-        albedo_map_sample.a = 1.0;
+#ifdef ALPHA_MASK
+    if(albedo_map_sample.a < alpha_cutoff) {
+        discard;
     }
 
-    vec4 posterized_vertex_color = vec4(ceil(vp_color * 64.0)) / 64.0;
-    vec4 vertex_color = mix(vp_color, posterized_vertex_color, features.w);
+    albedo_map_sample.a = 1.0;
+#endif
+
+#ifdef POSTERIZE_LIGHTING
+    vec4 vertex_color = vec4(ceil(vp_color * 64.0)) / 64.0;
+#else
+    vec4 vertex_color = vp_color;
+#endif
 
     vec4 albedo = albedo_map_sample * vertex_color * albedo_factor;
 
+#ifdef ALPHA_TEST
     if(albedo.a < 0.99999f) {
         discard;
     }
+#endif
 
     vec3 emissive_map_sample = texture(emissive_map, adj_texcoords).rgb;
     emissive_map_sample = mix(vec3(1.0), emissive_map_sample, features.y);
@@ -1,7 +1,7 @@
 #version 330 core
 #extension GL_ARB_explicit_uniform_location : require
 
-layout(location = 1) uniform vec4 features;
+layout(location = 1) uniform vec2 features;
 
 layout(location = 2) uniform sampler2D albedo_map;
 layout(location = 3) uniform vec4 albedo_factor;
@@ -9,18 +9,45 @@ layout(location = 3) uniform vec4 albedo_factor;
 layout(location = 4) uniform sampler2D emissive_map;
 layout(location = 5) uniform vec3 emissive_factor;
 
+#ifdef ALPHA_MASK
 layout(location = 6) uniform float alpha_cutoff;
+#endif
 
+#ifdef PARALLAX_MAPPING
 layout(location = 7) uniform sampler2D displacement_map;
 layout(location = 8) uniform float displacement_factor;
+#endif
 
 in vec3 vp_pos;
 in vec2 vp_texcoords;
 in vec4 vp_color;
-in vec3 vp_normal;
+
+// Flat face normal, derived from screen-space derivatives instead of a vertex attribute
+vec3 vp_normal;
+
+vec3 face_normal()
+{
+    vec3 n = normalize(cross(dFdx(vp_pos), dFdy(vp_pos)));
+
+    // JK disables backface culling. Make all of the normals face the viewer.
+    return (dot(n, vp_pos) > 0.0) ? -n : n;
+}
 
 layout(location = 0) out vec4 out_color;
 
+#ifdef WEIGHTED_OIT
+layout(location = 1) out float out_weight;
+layout(location = 2) out vec4 out_emissive;
+
+float oit_depth_weight()
+{
+    // Nearer fragments dominate the weighted average. Clamp to keep 16-bit float sums in range.
+    float d = 1.0 - gl_FragCoord.z;
+    return clamp(3e3 * d * d * d, 1e-2, 3e3);
+}
+#endif
+
+#ifdef PARALLAX_MAPPING
 mat3 construct_tbn()
 {
     vec3 n = normalize(vp_normal);
@@ -73,28 +100,34 @@ vec2 parallax_mapping(vec2 tc)
 
     return adj_tc;
 }
+#endif
 
 void main()
 {
+    vp_normal = face_normal();
+
     vec2 adj_texcoords = vp_texcoords;
 
-    if(displacement_factor != 0.0) {
-        adj_texcoords = parallax_mapping(vp_texcoords);
-    }
+#ifdef PARALLAX_MAPPING
+    adj_texcoords = parallax_mapping(vp_texcoords);
+#endif
 
     vec4 albedo_map_sample = texture(albedo_map, adj_texcoords);
     albedo_map_sample = mix(vec4(1.0), albedo_map_sample, features.x);
 
-    if(features.z > 0.5) {
-        if(albedo_map_sample.a < alpha_cutoff) {
-            discard;
-        }
-
-        albedo_map_sample.a = 1.0;
+#ifdef ALPHA_MASK
+    if(albedo_map_sample.a < alpha_cutoff) {
+        discard;
     }
 
-    vec4 posterized_vertex_color = vec4(ceil(vp_color * 64.0)) / 64.0;
-    vec4 vertex_color = mix(vp_color, posterized_vertex_color, features.w);
+    albedo_map_sample.a = 1.0;
+#endif
+
+#ifdef POSTERIZE_LIGHTING
+    vec4 vertex_color = vec4(ceil(vp_color * 64.0)) / 64.0;
+#else
+    vec4 vertex_color = vp_color;
+#endif
 
     vec4 albedo = albedo_map_sample * vertex_color * albedo_factor;
 
@@ -102,5 +135,18 @@ void main()
     emissive_map_sample = mix(vec3(1.0), emissive_map_sample, features.y);
     vec3 emissive = emissive_map_sample * emissive_factor;
 
+#ifdef WEIGHTED_OIT
+    // Color is accumulated additively. Alpha is blended multiplicatively into revealage. Albedo
+    // is already premultiplied by alpha, so only the weight sum is scaled by it: the composite
+    // divides by the sum and blends by coverage, leaving one layer at albedo.
+    float depth_weight = oit_depth_weight();
+    out_color = vec4(albedo.rgb * depth_weight, albedo.a);
+    out_weight = albedo.a * depth_weight;
+
+    // Emitted light does not depend on coverage, so it is summed without a weight. Unlike sorted
+    // blending, light from a layer is not dimmed by the layers in front of it.
+    out_emissive = vec4(emissive, 0.0);
+#else
     out_color = vec4(emissive + albedo.rgb, albedo.a);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 330 core
+#extension GL_ARB_explicit_uniform_location : require
+
+layout(location = 0) uniform sampler2D accum_image;
+layout(location = 1) uniform sampler2D weight_image;
+layout(location = 2) uniform sampler2D emissive_image;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    ivec2 tc = ivec2(gl_FragCoord.xy);
+
+    vec4 accum = texelFetch(accum_image, tc, 0);
+    float weight = texelFetch(weight_image, tc, 0).r;
+    vec3 emissive = texelFetch(emissive_image, tc, 0).rgb;
+
+    // Alpha holds the fraction of the background left visible through all layers
+    float revealage = accum.a;
+    if(revealage >= 1.0 && all(equal(emissive, vec3(0.0)))) {
+        discard;
+    }
+
+    // Premultiplied, so that fully transparent layers still add their emitted light
+    float coverage = 1.0 - revealage;
+    out_color = vec4((accum.rgb / max(weight, 1e-5)) * coverage + emissive, coverage);
+}
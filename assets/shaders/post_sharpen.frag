@@ -0,0 +1,56 @@
+#version 330 core
+#extension GL_ARB_explicit_uniform_location : require
+
+layout(location = 0) uniform sampler2D image;
+layout(location = 1) uniform float sharpness;
+
+layout(location = 0) out vec4 out_color;
+
+// Robust contrast adaptive sharpening in the style of FidelityFX Super Resolution 1 (RCAS). The
+// sharpening lobe is limited so that no output exceeds the range of its neighbors.
+
+const float rcas_limit = 0.25 - (1.0 / 16.0);
+
+ivec2 src_max;
+
+vec3 fetch(ivec2 p)
+{
+    return texelFetch(image, clamp(p, ivec2(0), src_max), 0).rgb;
+}
+
+// The scene is HDR. Sharpen in a reversibly tonemapped space.
+vec3 tonemap(vec3 c)
+{
+    return c / (1.0 + max(c.r, max(c.g, c.b)));
+}
+
+vec3 inverse_tonemap(vec3 c)
+{
+    return c / max(1.0 / 65504.0, 1.0 - max(c.r, max(c.g, c.b)));
+}
+
+void main()
+{
+    src_max = textureSize(image, 0) - ivec2(1);
+    ivec2 sc = ivec2(gl_FragCoord.xy);
+
+    //   b
+    // d e f
+    //   h
+    vec3 b = tonemap(fetch(sc + ivec2(0, 1)));
+    vec3 d = tonemap(fetch(sc + ivec2(-1, 0)));
+    vec3 e = tonemap(fetch(sc));
+    vec3 f = tonemap(fetch(sc + ivec2(1, 0)));
+    vec3 h = tonemap(fetch(sc + ivec2(0, -1)));
+
+    vec3 min4 = min(min(b, d), min(f, h));
+    vec3 max4 = max(max(b, d), max(f, h));
+
+    vec3 hit_min = min4 / (4.0 * max4 + (1.0 / 65504.0));
+    vec3 hit_max = (1.0 - max4) / (4.0 * min4 - 4.0 - (1.0 / 65504.0));
+    vec3 lobe3 = max(-hit_min, hit_max);
+    float lobe = max(-rcas_limit, min(max(lobe3.r, max(lobe3.g, lobe3.b)), 0.0)) * sharpness;
+
+    vec3 c = (lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0);
+    out_color = vec4(inverse_tonemap(c), 1.0);
+}
@@ -0,0 +1,155 @@
+#version 330 core
+#extension GL_ARB_explicit_uniform_location : require
+
+layout(location = 0) uniform sampler2D scene_image;
+
+in vec2 vp_texcoords;
+
+layout(location = 0) out vec4 out_color;
+
+// Edge adaptive spatial upscaling in the style of FidelityFX Super Resolution 1 (EASU). A 12-tap
+// Lanczos-2 kernel is rotated to follow the local gradient and stretched along edges. The result
+// is clamped to the nearest 2x2 texels to prevent ringing.
+
+ivec2 src_max;
+
+vec3 fetch(ivec2 p)
+{
+    return texelFetch(scene_image, clamp(p, ivec2(0), src_max), 0).rgb;
+}
+
+float luma(vec3 c)
+{
+    return (c.b * 0.5) + (c.r * 0.5 + c.g);
+}
+
+// Accumulates gradient direction and edge strength around one of the 4 nearest texels
+void accumulate_direction(inout vec2 dir,
+                          inout float len,
+                          float w,
+                          float l_up,
+                          float l_left,
+                          float l_center,
+                          float l_right,
+                          float l_down)
+{
+    float dc = l_right - l_center;
+    float cb = l_center - l_left;
+    float dir_x = l_right - l_left;
+    float len_x = max(abs(dc), abs(cb));
+    len_x = (len_x > 0.0) ? clamp(abs(dir_x) / len_x, 0.0, 1.0) : 0.0;
+
+    float ec = l_down - l_center;
+    float ca = l_center - l_up;
+    float dir_y = l_down - l_up;
+    float len_y = max(abs(ec), abs(ca));
+    len_y = (len_y > 0.0) ? clamp(abs(dir_y) / len_y, 0.0, 1.0) : 0.0;
+
+    dir += vec2(dir_x, dir_y) * w;
+    len += ((len_x * len_x) + (len_y * len_y)) * w;
+}
+
+void accumulate_tap(inout vec3 acc_color,
+                    inout float acc_weight,
+                    vec2 offset,
+                    vec2 dir,
+                    vec2 len2,
+                    float lob,
+                    float clp,
+                    vec3 color)
+{
+    // Rotate into the edge frame and stretch along the edge
+    vec2 v = vec2(dot(offset, dir), dot(offset, vec2(-dir.y, dir.x))) * len2;
+    float d2 = min(dot(v, v), clp);
+
+    // Polynomial approximation of Lanczos-2 with an adjustable window
+    float wb = (2.0 / 5.0) * d2 - 1.0;
+    float wa = lob * d2 - 1.0;
+    wb = (25.0 / 16.0) * wb * wb - (25.0 / 16.0 - 1.0);
+    float w = wb * wa * wa;
+
+    acc_color += color * w;
+    acc_weight += w;
+}
+
+void main()
+{
+    ivec2 src_size = textureSize(scene_image, 0);
+    src_max = src_size - ivec2(1);
+
+    vec2 pp = vp_texcoords * vec2(src_size) - vec2(0.5);
+    vec2 fp = floor(pp);
+    vec2 f = pp - fp;
+    ivec2 o = ivec2(fp);
+
+    // Footprint:
+    //     b c
+    //   e f g h
+    //   i j k l
+    //     n p
+    vec3 b = fetch(o + ivec2(0, -1));
+    vec3 c = fetch(o + ivec2(1, -1));
+    vec3 e = fetch(o + ivec2(-1, 0));
+    vec3 ff = fetch(o + ivec2(0, 0));
+    vec3 g = fetch(o + ivec2(1, 0));
+    vec3 h = fetch(o + ivec2(2, 0));
+    vec3 i = fetch(o + ivec2(-1, 1));
+    vec3 j = fetch(o + ivec2(0, 1));
+    vec3 k = fetch(o + ivec2(1, 1));
+    vec3 l = fetch(o + ivec2(2, 1));
+    vec3 n = fetch(o + ivec2(0, 2));
+    vec3 p = fetch(o + ivec2(1, 2));
+
+    float lb = luma(b);
+    float lc = luma(c);
+    float le = luma(e);
+    float lf = luma(ff);
+    float lg = luma(g);
+    float lh = luma(h);
+    float li = luma(i);
+    float lj = luma(j);
+    float lk = luma(k);
+    float ll = luma(l);
+    float ln = luma(n);
+    float lp = luma(p);
+
+    // Bilinear blend of the gradient at the 4 nearest texels
+    vec2 dir = vec2(0.0);
+    float len = 0.0;
+    accumulate_direction(dir, len, (1.0 - f.x) * (1.0 - f.y), lb, le, lf, lg, lj);
+    accumulate_direction(dir, len, f.x * (1.0 - f.y), lc, lf, lg, lh, lk);
+    accumulate_direction(dir, len, (1.0 - f.x) * f.y, lf, li, lj, lk, ln);
+    accumulate_direction(dir, len, f.x * f.y, lg, lj, lk, ll, lp);
+
+    float dir_len2 = dot(dir, dir);
+    dir = (dir_len2 < (1.0 / 32768.0)) ? vec2(1.0, 0.0) : dir * inversesqrt(dir_len2);
+
+    len = len * 0.5;
+    len *= len;
+
+    // Stretch the kernel along edges, and shrink it across them
+    float stretch = 1.0 / max(abs(dir.x), abs(dir.y));
+    vec2 len2 = vec2(1.0 + (stretch - 1.0) * len, 1.0 - 0.5 * len);
+    float lob = 0.5 - 0.29 * len;
+    float clp = 1.0 / lob;
+
+    vec3 acc_color = vec3(0.0);
+    float acc_weight = 0.0;
+    accumulate_tap(acc_color, acc_weight, vec2(0.0, -1.0) - f, dir, len2, lob, clp, b);
+    accumulate_tap(acc_color, acc_weight, vec2(1.0, -1.0) - f, dir, len2, lob, clp, c);
+    accumulate_tap(acc_color, acc_weight, vec2(-1.0, 1.0) - f, dir, len2, lob, clp, i);
+    accumulate_tap(acc_color, acc_weight, vec2(0.0, 1.0) - f, dir, len2, lob, clp, j);
+    accumulate_tap(acc_color, acc_weight, vec2(0.0, 0.0) - f, dir, len2, lob, clp, ff);
+    accumulate_tap(acc_color, acc_weight, vec2(-1.0, 0.0) - f, dir, len2, lob, clp, e);
+    accumulate_tap(acc_color, acc_weight, vec2(1.0, 1.0) - f, dir, len2, lob, clp, k);
+    accumulate_tap(acc_color, acc_weight, vec2(2.0, 1.0) - f, dir, len2, lob, clp, l);
+    accumulate_tap(acc_color, acc_weight, vec2(2.0, 0.0) - f, dir, len2, lob, clp, h);
+    accumulate_tap(acc_color, acc_weight, vec2(1.0, 0.0) - f, dir, len2, lob, clp, g);
+    accumulate_tap(acc_color, acc_weight, vec2(1.0, 2.0) - f, dir, len2, lob, clp, p);
+    accumulate_tap(acc_color, acc_weight, vec2(0.0, 2.0) - f, dir, len2, lob, clp, n);
+
+    vec3 min4 = min(min(ff, g), min(j, k));
+    vec3 max4 = max(max(ff, g), max(j, k));
+
+    out_color = vec4(clamp(acc_color / acc_weight, min4, max4), 1.0);
+}
@@ -4,9 +4,9 @@
 
 namespace jkgm {
     enum class build { release, debug };
-    enum class architecture { x86 };
-    enum class platform { windows };
-    enum class platform_family { win32 };
+    enum class architecture { x86, x64 };
+    enum class platform { windows, gnu_linux };
+    enum class platform_family { win32, posix };
 
     class build_traits {
     public:
@@ -20,12 +20,16 @@ namespace jkgm {
 
 #ifdef ARCHITECTURE_X86
         static constexpr jkgm::architecture architecture = jkgm::architecture::x86;
+#elif ARCHITECTURE_X64
+        static constexpr jkgm::architecture architecture = jkgm::architecture::x64;
 #else
 #error "build_traits does not support this architecture type"
 #endif
 
 #ifdef PLATFORM_WINDOWS
         static constexpr jkgm::platform platform = jkgm::platform::windows;
+#elif PLATFORM_LINUX
+        static constexpr jkgm::platform platform = jkgm::platform::gnu_linux;
 #else
 #error "build_traits does not support this platform type"
 #endif
@@ -34,8 +38,10 @@ namespace jkgm {
         static constexpr bool is_debug = (build == jkgm::build::debug);
 
         static constexpr bool is_windows = (platform == jkgm::platform::windows);
+        static constexpr bool is_linux = (platform == jkgm::platform::gnu_linux);
 
-        static constexpr platform_family family = platform_family::win32;
+        static constexpr platform_family family =
+            is_windows ? platform_family::win32 : platform_family::posix;
     };
 
     template <class T>
@@ -44,6 +50,12 @@ namespace jkgm {
         static constexpr bool enabled = (build_traits::family == platform_family::win32);
     };
 
+    template <class T>
+    struct posix_version {
+        using type = T;
+        static constexpr bool enabled = (build_traits::family == platform_family::posix);
+    };
+
     namespace detail {
         template <class... T>
         struct count_enabled;
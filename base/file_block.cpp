@@ -59,6 +59,49 @@ namespace jkgm {
             }
         };
 
+        template <>
+        struct helper_impl<platform_family::posix> {
+            static auto open_output(fs::path const &filename)
+            {
+                return posix::open_file(filename, posix::open_mode::write_truncate);
+            }
+
+            static auto open_input(fs::path const &filename)
+            {
+                return posix::open_file(filename, posix::open_mode::read);
+            }
+
+            static size_t write_some(int fd, span<char const> src)
+            {
+                return posix::write_fd(fd, src);
+            }
+
+            static void set_position(int fd, size_t offset)
+            {
+                posix::seek_fd(fd, static_cast<int64_t>(offset), posix::seek_origin::begin);
+            }
+
+            static size_t position(int fd)
+            {
+                return posix::seek_fd(fd, 0, posix::seek_origin::current);
+            }
+
+            static size_t read_some(int fd, span<char> dest)
+            {
+                return posix::read_fd(fd, dest);
+            }
+
+            static void seek(int fd, int offset)
+            {
+                posix::seek_fd(fd, offset, posix::seek_origin::current);
+            }
+
+            static size_t size(int fd)
+            {
+                return posix::get_file_size(fd);
+            }
+        };
+
         using helper = helper_impl<build_traits::family>;
     }
 }
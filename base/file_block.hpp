@@ -4,12 +4,14 @@
 #include "filesystem.hpp"
 #include "input_block.hpp"
 #include "output_block.hpp"
+#include "posix.hpp"
 #include "win32.hpp"
 #include <memory>
 
 namespace jkgm {
     namespace detail {
-        using fb_s_type = specialization_t<win32_version<win32::unique_handle>>;
+        using fb_s_type = specialization_t<win32_version<win32::unique_handle>,
+                                           posix_version<posix::unique_fd>>;
     }
 
     class file_output_block : public output_block {
@@ -0,0 +1,309 @@
+#include "job_system.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace jkgm {
+    namespace {
+        constexpr size_t no_queue = std::numeric_limits<size_t>::max();
+
+        thread_local job_system const *current_job_system = nullptr;
+        thread_local size_t current_queue_index = no_queue;
+    }
+}
+
+jkgm::detail::task_node::task_node(std::function<void()> fn)
+    : fn(std::move(fn))
+{
+}
+
+jkgm::task::task(std::shared_ptr<detail::task_node> node)
+    : node(std::move(node))
+{
+}
+
+bool jkgm::task::is_finished() const
+{
+    return node->finished;
+}
+
+jkgm::job_system::job_system(size_t num_workers)
+{
+    if(num_workers == 0U) {
+        num_workers = std::max(1U, std::thread::hardware_concurrency()) - 1U;
+    }
+
+    // One queue per worker, plus one shared by threads outside of the system
+    for(size_t i = 0; i <= num_workers; ++i) {
+        queues.push_back(std::make_unique<worker_queue>());
+    }
+
+    for(size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back([this, i] { worker_main(i); });
+    }
+}
+
+jkgm::job_system::~job_system()
+{
+    {
+        std::lock_guard<std::mutex> lk(sleep_lock);
+        stopping = true;
+    }
+
+    sleep_cv.notify_all();
+
+    for(auto &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t jkgm::job_system::get_num_workers() const
+{
+    return workers.size();
+}
+
+void jkgm::job_system::enqueue(std::shared_ptr<detail::task_node> node)
+{
+    size_t queue_index = current_queue_index;
+    if(current_job_system != this || queue_index == no_queue) {
+        queue_index = next_queue++ % queues.size();
+    }
+
+    auto &q = *queues[queue_index];
+
+    {
+        std::lock_guard<std::mutex> lk(q.lock);
+        q.tasks.push_back(std::move(node));
+        ++num_queued;
+    }
+
+    // Workers increment num_sleeping before testing num_queued, and this thread increments
+    // num_queued before testing num_sleeping. Either the worker sees the new task, or this thread
+    // sees the worker and takes sleep_lock so the notification cannot fall between the worker's
+    // test and its wait.
+    if(num_sleeping > 0U) {
+        {
+            std::lock_guard<std::mutex> lk(sleep_lock);
+        }
+
+        sleep_cv.notify_one();
+    }
+}
+
+std::shared_ptr<jkgm::detail::task_node> jkgm::job_system::pop_local(size_t queue_index)
+{
+    auto &q = *queues[queue_index];
+
+    std::lock_guard<std::mutex> lk(q.lock);
+    if(q.tasks.empty()) {
+        return nullptr;
+    }
+
+    // Most recently pushed work is most likely to still be in cache
+    auto rv = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    --num_queued;
+    return rv;
+}
+
+std::shared_ptr<jkgm::detail::task_node> jkgm::job_system::steal(size_t thief_index)
+{
+    size_t start = (thief_index == no_queue) ? next_queue.load() : (thief_index + 1U);
+    for(size_t i = 0; i < queues.size(); ++i) {
+        auto &q = *queues[(start + i) % queues.size()];
+
+        std::lock_guard<std::mutex> lk(q.lock);
+        if(q.tasks.empty()) {
+            continue;
+        }
+
+        // Steal the oldest work, which tends to be the largest remaining subdivision
+        auto rv = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        --num_queued;
+        return rv;
+    }
+
+    return nullptr;
+}
+
+bool jkgm::job_system::run_one(size_t queue_index)
+{
+    std::shared_ptr<detail::task_node> node;
+    if(queue_index != no_queue) {
+        node = pop_local(queue_index);
+    }
+
+    if(!node) {
+        node = steal(queue_index);
+    }
+
+    if(!node) {
+        return false;
+    }
+
+    execute(node);
+    return true;
+}
+
+void jkgm::job_system::execute(std::shared_ptr<detail::task_node> const &node)
+{
+    // Dependencies finished before this task was queued, so error is not written concurrently
+    if(!node->error) {
+        try {
+            node->fn();
+        }
+        catch(...) {
+            node->error = std::current_exception();
+        }
+    }
+
+    node->fn = nullptr;
+
+    std::vector<std::shared_ptr<detail::task_node>> successors;
+
+    {
+        std::lock_guard<std::mutex> lk(node->successor_lock);
+        node->finished = true;
+        successors.swap(node->successors);
+    }
+
+    for(auto &succ : successors) {
+        if(node->error) {
+            std::lock_guard<std::mutex> lk(succ->successor_lock);
+            if(!succ->error) {
+                succ->error = node->error;
+            }
+        }
+
+        if(--succ->num_pending_dependencies == 0U) {
+            enqueue(std::move(succ));
+        }
+    }
+}
+
+void jkgm::job_system::worker_main(size_t queue_index)
+{
+    current_job_system = this;
+    current_queue_index = queue_index;
+    TRACE_THREAD_NAME("worker " + std::to_string(queue_index));
+
+    while(true) {
+        if(run_one(queue_index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(sleep_lock);
+        ++num_sleeping;
+        sleep_cv.wait(lk, [&] { return stopping || num_queued > 0U; });
+        --num_sleeping;
+        if(stopping && num_queued == 0U) {
+            return;
+        }
+    }
+}
+
+jkgm::task jkgm::job_system::submit(std::function<void()> fn, std::vector<task> const &dependencies)
+{
+    auto node = std::make_shared<detail::task_node>(std::move(fn));
+
+    for(auto const &dep : dependencies) {
+        std::lock_guard<std::mutex> lk(dep.node->successor_lock);
+        if(!dep.node->finished) {
+            ++node->num_pending_dependencies;
+            dep.node->successors.push_back(node);
+        }
+        else if(dep.node->error) {
+            // Dependencies that are still running may also write the error
+            std::lock_guard<std::mutex> node_lk(node->successor_lock);
+            if(!node->error) {
+                node->error = dep.node->error;
+            }
+        }
+    }
+
+    // Release the submission guard. The task is runnable once no dependencies remain.
+    if(--node->num_pending_dependencies == 0U) {
+        enqueue(node);
+    }
+
+    return task(std::move(node));
+}
+
+void jkgm::job_system::wait_until_finished(task const &t)
+{
+    size_t queue_index = (current_job_system == this) ? current_queue_index : no_queue;
+    while(!t.is_finished()) {
+        if(!run_one(queue_index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void jkgm::job_system::wait(task const &t)
+{
+    wait_until_finished(t);
+    if(t.node->error) {
+        std::rethrow_exception(t.node->error);
+    }
+}
+
+void jkgm::job_system::wait(std::vector<task> const &tasks)
+{
+    // Every task must finish before rethrowing, since tasks may refer to the caller's stack
+    for(auto const &t : tasks) {
+        wait_until_finished(t);
+    }
+
+    for(auto const &t : tasks) {
+        if(t.node->error) {
+            std::rethrow_exception(t.node->error);
+        }
+    }
+}
+
+void jkgm::job_system::parallel_for(size_t begin,
+                                    size_t end,
+                                    size_t grain_size,
+                                    std::function<void(size_t, size_t)> const &fn)
+{
+    if(begin >= end) {
+        return;
+    }
+
+    grain_size = std::max<size_t>(1U, grain_size);
+    if((end - begin) <= grain_size) {
+        fn(begin, end);
+        return;
+    }
+
+    std::vector<task> tasks;
+    tasks.reserve((end - begin + grain_size - 1U) / grain_size);
+
+    for(size_t first = begin; first < end; first += grain_size) {
+        size_t last = std::min(end, first + grain_size);
+        tasks.push_back(submit([&fn, first, last] { fn(first, last); }));
+    }
+
+    wait(tasks);
+}
+
+void jkgm::job_system::post_to_main_thread(std::function<void()> fn)
+{
+    std::lock_guard<std::mutex> lk(main_thread_lock);
+    main_thread_tasks.push_back(std::move(fn));
+}
+
+void jkgm::job_system::run_main_thread_tasks()
+{
+    std::deque<std::function<void()>> pending;
+
+    {
+        std::lock_guard<std::mutex> lk(main_thread_lock);
+        pending.swap(main_thread_tasks);
+    }
+
+    for(auto &fn : pending) {
+        fn();
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jkgm {
+    class job_system;
+    class task;
+
+    namespace detail {
+        class task_node {
+            friend class jkgm::job_system;
+            friend class jkgm::task;
+
+        private:
+            std::function<void()> fn;
+
+            // Counts unfinished dependencies, plus one while the task is being submitted
+            std::atomic<size_t> num_pending_dependencies = 1U;
+
+            std::mutex successor_lock;
+            std::vector<std::shared_ptr<task_node>> successors;
+            std::atomic<bool> finished = false;
+
+            // Set if fn or a dependency threw. Dependent tasks inherit it and do not run.
+            std::exception_ptr error;
+
+        public:
+            explicit task_node(std::function<void()> fn);
+        };
+    }
+
+    class task {
+        friend class job_system;
+
+    private:
+        std::shared_ptr<detail::task_node> node;
+
+        explicit task(std::shared_ptr<detail::task_node> node);
+
+    public:
+        bool is_finished() const;
+    };
+
+    // Work-stealing scheduler. Each worker owns a deque: the owner pushes and pops work at the
+    // back, and idle workers steal from the front of other deques. Each deque has its own lock,
+    // so workers never contend on a single queue.
+    class job_system {
+    private:
+        struct worker_queue {
+            std::mutex lock;
+            std::deque<std::shared_ptr<detail::task_node>> tasks;
+        };
+
+        std::vector<std::unique_ptr<worker_queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::atomic<size_t> num_queued = 0U;
+        std::atomic<size_t> next_queue = 0U;
+        std::atomic<bool> stopping = false;
+
+        // Workers register here before sleeping. Submitters take sleep_lock only if one may be
+        // asleep.
+        std::atomic<size_t> num_sleeping = 0U;
+        std::mutex sleep_lock;
+        std::condition_variable sleep_cv;
+
+        std::mutex main_thread_lock;
+        std::deque<std::function<void()>> main_thread_tasks;
+
+        void enqueue(std::shared_ptr<detail::task_node> node);
+        std::shared_ptr<detail::task_node> pop_local(size_t queue_index);
+        std::shared_ptr<detail::task_node> steal(size_t thief_index);
+        bool run_one(size_t queue_index);
+        void execute(std::shared_ptr<detail::task_node> const &node);
+        void wait_until_finished(task const &t);
+        void worker_main(size_t queue_index);
+
+    public:
+        // Spawns num_workers threads. Zero selects one fewer than the number of hardware threads.
+        // The thread that waits on a task also executes work, so a system with no workers still
+        // completes all work.
+        explicit job_system(size_t num_workers = 0U);
+        ~job_system();
+
+        job_system(job_system const &) = delete;
+        job_system &operator=(job_system const &) = delete;
+
+        size_t get_num_workers() const;
+
+        // Schedules fn to run after all dependencies have finished
+        task submit(std::function<void()> fn, std::vector<task> const &dependencies = {});
+
+        // Blocks until t has finished. The calling thread executes other work while it waits.
+        // Rethrows the exception thrown by the task or by any task it depends on.
+        void wait(task const &t);
+
+        // Blocks until every task has finished, then rethrows the first exception in order
+        void wait(std::vector<task> const &tasks);
+
+        // Calls fn(first, last) over [begin, end), split into ranges of at most grain_size
+        void parallel_for(size_t begin,
+                          size_t end,
+                          size_t grain_size,
+                          std::function<void(size_t, size_t)> const &fn);
+
+        // Queues work that must run on the main thread, such as GL calls. It runs during the
+        // next call to run_main_thread_tasks.
+        void post_to_main_thread(std::function<void()> fn);
+        void run_main_thread_tasks();
+    };
+}
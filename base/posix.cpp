@@ -0,0 +1,105 @@
+#include "posix.hpp"
+#include <system_error>
+
+#ifdef PLATFORM_LINUX
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jkgm {
+    namespace {
+        [[noreturn]] void throw_errno()
+        {
+            throw std::system_error(errno, std::generic_category());
+        }
+    }
+}
+
+void jkgm::posix::unique_fd_traits::destroy(int fd)
+{
+    try {
+        posix::close_fd(fd);
+    }
+    catch(std::system_error const & /*e*/) {
+        // Errors closing at handle destruction are unrecoverable
+    }
+}
+
+void jkgm::posix::close_fd(int fd)
+{
+    if(::close(fd) != 0) {
+        throw_errno();
+    }
+}
+
+size_t jkgm::posix::get_file_size(int fd)
+{
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+        throw_errno();
+    }
+
+    return static_cast<size_t>(st.st_size);
+}
+
+jkgm::posix::unique_fd jkgm::posix::open_file(fs::path const &name, open_mode mode)
+{
+    int fd = -1;
+    switch(mode) {
+    case open_mode::read:
+        fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+        break;
+
+    case open_mode::write_truncate:
+        fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        break;
+    }
+
+    if(fd < 0) {
+        throw_errno();
+    }
+
+    return unique_fd(fd);
+}
+
+size_t jkgm::posix::read_fd(int fd, span<char> buffer)
+{
+    for(;;) {
+        auto res = ::read(fd, buffer.data(), buffer.size());
+        if(res >= 0) {
+            return static_cast<size_t>(res);
+        }
+
+        if(errno != EINTR) {
+            throw_errno();
+        }
+    }
+}
+
+size_t jkgm::posix::seek_fd(int fd, int64_t distance, seek_origin origin)
+{
+    auto res = ::lseek(fd, distance, (origin == seek_origin::begin) ? SEEK_SET : SEEK_CUR);
+    if(res < 0) {
+        throw_errno();
+    }
+
+    return static_cast<size_t>(res);
+}
+
+size_t jkgm::posix::write_fd(int fd, span<char const> buffer)
+{
+    for(;;) {
+        auto res = ::write(fd, buffer.data(), buffer.size());
+        if(res >= 0) {
+            return static_cast<size_t>(res);
+        }
+
+        if(errno != EINTR) {
+            throw_errno();
+        }
+    }
+}
+
+#endif // PLATFORM_LINUX
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "filesystem.hpp"
+#include "span.hpp"
+#include "unique_handle.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace jkgm::posix {
+    enum class open_mode { read, write_truncate };
+
+    enum class seek_origin { begin, current };
+
+    struct unique_fd_traits {
+        using value_type = int;
+
+        static inline int create(int fd)
+        {
+            return fd;
+        }
+
+        static void destroy(int fd);
+    };
+
+    using unique_fd = jkgm::unique_handle<unique_fd_traits>;
+
+    void close_fd(int fd);
+    size_t get_file_size(int fd);
+    unique_fd open_file(fs::path const &name, open_mode mode);
+    size_t read_fd(int fd, span<char> buffer);
+    size_t seek_fd(int fd, int64_t distance, seek_origin origin);
+    size_t write_fd(int fd, span<char const> buffer);
+}
@@ -0,0 +1,171 @@
+#include "trace.hpp"
+#include "file_stream.hpp"
+#include <algorithm>
+
+namespace jkgm {
+    namespace {
+        auto const trace_epoch = std::chrono::steady_clock::now();
+
+        std::atomic<bool> trace_enabled = false;
+
+        thread_local std::shared_ptr<detail::trace_ring> current_trace_ring;
+
+        detail::trace_ring &get_current_trace_ring()
+        {
+            if(!current_trace_ring) {
+                current_trace_ring = get_global<trace_registry>()->register_thread();
+            }
+
+            return *current_trace_ring;
+        }
+
+        void append_trace_time(std::string &buf, int64_t ns)
+        {
+            // Chrome expects microseconds. Keep the nanoseconds as a fixed fraction.
+            buf.append(std::to_string(ns / 1000));
+            buf.push_back('.');
+
+            auto frac = std::to_string(ns % 1000);
+            buf.append(3U - frac.size(), '0');
+            buf.append(frac);
+        }
+    }
+}
+
+jkgm::detail::trace_ring::trace_ring(int thread_id, size_t capacity)
+    : thread_name("thread " + std::to_string(thread_id))
+    , thread_id(thread_id)
+    , slots(std::make_unique<slot[]>(capacity))
+    , capacity(capacity)
+{
+}
+
+jkgm::trace_registry::trace_registry(global_constructor_protector_tag tag)
+    : global(tag)
+{
+}
+
+std::shared_ptr<jkgm::detail::trace_ring> jkgm::trace_registry::register_thread()
+{
+    std::lock_guard<std::mutex> lk(rings_lock);
+    rings.push_back(std::make_shared<detail::trace_ring>(static_cast<int>(rings.size()) + 1,
+                                                         trace_ring_capacity));
+    return rings.back();
+}
+
+void jkgm::trace_registry::set_thread_name(detail::trace_ring &ring, std::string const &name)
+{
+    std::lock_guard<std::mutex> lk(rings_lock);
+    ring.thread_name = name;
+}
+
+void jkgm::trace_registry::write_chrome_trace(output_stream &os, std::chrono::nanoseconds window)
+{
+    std::lock_guard<std::mutex> lk(rings_lock);
+
+    int64_t cutoff = get_trace_time() - window.count();
+
+    std::string buf = "{\"traceEvents\":[\n";
+    bool first = true;
+    std::vector<trace_event> events;
+
+    for(auto const &ring : rings) {
+        buf.append(first ? "" : ",\n");
+        first = false;
+
+        buf.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        buf.append(std::to_string(ring->thread_id));
+        buf.append(",\"args\":{\"name\":\"");
+        buf.append(ring->thread_name);
+        buf.append("\"}}");
+
+        uint64_t end = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = (end > ring->capacity) ? (end - ring->capacity) : 0U;
+
+        events.clear();
+        for(uint64_t i = begin; i < end; ++i) {
+            auto const &em = ring->slots[i % ring->capacity];
+            events.push_back(trace_event{em.name.load(std::memory_order_relaxed),
+                                         em.begin_time.load(std::memory_order_relaxed),
+                                         em.end_time.load(std::memory_order_relaxed)});
+        }
+
+        // The owner may have wrapped around while the ring was copied. Slots up to and including
+        // the one it is currently writing are no longer trustworthy.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = ring->head.load(std::memory_order_acquire);
+        uint64_t first_valid =
+            ((after + 1U) > ring->capacity) ? (after + 1U - ring->capacity) : 0U;
+        size_t num_stale = static_cast<size_t>(std::min<uint64_t>(
+            (first_valid > begin) ? (first_valid - begin) : 0U, events.size()));
+
+        for(size_t i = num_stale; i < events.size(); ++i) {
+            auto const &em = events[i];
+            if(em.end_time < cutoff) {
+                continue;
+            }
+
+            buf.append(",\n{\"name\":\"");
+            buf.append(em.name);
+            buf.append("\",\"cat\":\"jkgm\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+            buf.append(std::to_string(ring->thread_id));
+            buf.append(",\"ts\":");
+            append_trace_time(buf, em.begin_time);
+            buf.append(",\"dur\":");
+            append_trace_time(buf, em.end_time - em.begin_time);
+            buf.push_back('}');
+        }
+
+        os.write(make_span(buf));
+        buf.clear();
+    }
+
+    buf.append("\n]}\n");
+    os.write(make_span(buf));
+}
+
+void jkgm::set_trace_enabled(bool enabled)
+{
+    trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool jkgm::is_trace_enabled()
+{
+    return trace_enabled.load(std::memory_order_relaxed);
+}
+
+int64_t jkgm::get_trace_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                trace_epoch)
+        .count();
+}
+
+void jkgm::set_trace_thread_name(std::string const &name)
+{
+    get_global<trace_registry>()->set_thread_name(get_current_trace_ring(), name);
+}
+
+void jkgm::record_trace_event(char const *name, int64_t begin_time, int64_t end_time)
+{
+    auto &ring = get_current_trace_ring();
+
+    // Single producer: only this thread advances head
+    uint64_t h = ring.head.load(std::memory_order_relaxed);
+
+    // Pairs with the fence in write_chrome_trace. A reader that sees any part of this event also
+    // sees the head that came before it, and so knows the slot may be torn.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto &em = ring.slots[h % ring.capacity];
+    em.name.store(name, std::memory_order_relaxed);
+    em.begin_time.store(begin_time, std::memory_order_relaxed);
+    em.end_time.store(end_time, std::memory_order_relaxed);
+    ring.head.store(h + 1U, std::memory_order_release);
+}
+
+void jkgm::write_chrome_trace(fs::path const &filename, std::chrono::nanoseconds window)
+{
+    auto fs = make_file_output_stream(filename);
+    get_global<trace_registry>()->write_chrome_trace(*fs, window);
+}
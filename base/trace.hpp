@@ -0,0 +1,115 @@
+#pragma once
+
+#include "filesystem.hpp"
+#include "global.hpp"
+#include "output_stream.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    namespace detail {
+        // Fixed-capacity ring of completed scopes. Only the owning thread writes. Readers copy the
+        // ring and discard any slots that were overwritten while they were copying.
+        class trace_ring {
+        public:
+            struct slot {
+                std::atomic<char const *> name = nullptr;
+                std::atomic<int64_t> begin_time = 0;
+                std::atomic<int64_t> end_time = 0;
+            };
+
+            std::string thread_name;
+            int thread_id;
+            std::unique_ptr<slot[]> slots;
+            size_t capacity;
+            std::atomic<uint64_t> head = 0U;
+
+            trace_ring(int thread_id, size_t capacity);
+        };
+    }
+
+    // Completed CPU scope. Times are in nanoseconds since the trace epoch.
+    struct trace_event {
+        char const *name = nullptr;
+        int64_t begin_time = 0;
+        int64_t end_time = 0;
+    };
+
+    class trace_registry : public global {
+    private:
+        std::mutex rings_lock;
+        std::vector<std::shared_ptr<detail::trace_ring>> rings;
+
+    public:
+        explicit trace_registry(global_constructor_protector_tag tag);
+
+        std::shared_ptr<detail::trace_ring> register_thread();
+        void set_thread_name(detail::trace_ring &ring, std::string const &name);
+
+        // Writes all events that ended within the last window as Chrome trace_event JSON
+        void write_chrome_trace(output_stream &os, std::chrono::nanoseconds window);
+    };
+
+    constexpr size_t trace_ring_capacity = 65536U;
+
+#ifdef ENABLE_TRACE
+    constexpr bool trace_compiled_in = true;
+#else
+    constexpr bool trace_compiled_in = false;
+#endif
+
+    // Recording is off until enabled, so instrumented builds cost one load per scope when idle
+    void set_trace_enabled(bool enabled);
+    bool is_trace_enabled();
+
+    int64_t get_trace_time();
+    void set_trace_thread_name(std::string const &name);
+    void record_trace_event(char const *name, int64_t begin_time, int64_t end_time);
+
+    // Writes the last window of recorded events from all threads to the named file
+    void write_chrome_trace(fs::path const &filename, std::chrono::nanoseconds window);
+
+    class trace_scope {
+    private:
+        char const *name;
+        int64_t begin_time = 0;
+
+    public:
+        // name must outlive the trace, such as a string literal
+        explicit trace_scope(char const *name)
+            : name(is_trace_enabled() ? name : nullptr)
+        {
+            if(this->name) {
+                begin_time = get_trace_time();
+            }
+        }
+
+        ~trace_scope()
+        {
+            if(name) {
+                record_trace_event(name, begin_time, get_trace_time());
+            }
+        }
+
+        trace_scope(trace_scope const &) = delete;
+        trace_scope(trace_scope &&) = delete;
+        trace_scope &operator=(trace_scope const &) = delete;
+        trace_scope &operator=(trace_scope &&) = delete;
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_TRACE
+#define TRACE_SCOPE(name) ::jkgm::trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) ::jkgm::set_trace_thread_name(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+#endif
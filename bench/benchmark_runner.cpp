@@ -0,0 +1,62 @@
+#include "benchmark_runner.hpp"
+#include "base/log.hpp"
+#include <algorithm>
+
+jkgm::benchmark_runner::benchmark_runner(size_t min_iterations, clock::duration min_duration)
+    : min_iterations(min_iterations)
+    , min_duration(min_duration)
+{
+}
+
+void jkgm::benchmark_runner::add_result(std::string const &name,
+                                        size_t items_per_iteration,
+                                        std::vector<double> iteration_times)
+{
+    std::sort(iteration_times.begin(), iteration_times.end());
+
+    double total = 0.0;
+    for(double em : iteration_times) {
+        total += em;
+    }
+
+    benchmark_result rv;
+    rv.name = name;
+    rv.iterations = iteration_times.size();
+    rv.items_per_iteration = items_per_iteration;
+    rv.mean_time = total / static_cast<double>(iteration_times.size());
+    rv.median_time = iteration_times[iteration_times.size() / 2U];
+    rv.min_time = iteration_times.front();
+
+    LOG_INFO(name,
+             ": ",
+             static_cast<int>(rv.median_time / 1000.0),
+             " us median over ",
+             rv.iterations,
+             " iterations");
+
+    results.push_back(std::move(rv));
+}
+
+json::json jkgm::benchmark_runner::to_json() const
+{
+    json::json rv = json::json::array();
+    for(auto const &em : results) {
+        json::json j;
+        j["name"] = em.name;
+        j["iterations"] = em.iterations;
+        j["items_per_iteration"] = em.items_per_iteration;
+        j["mean_ns"] = em.mean_time;
+        j["median_ns"] = em.median_time;
+        j["min_ns"] = em.min_time;
+
+        double items_per_second = 0.0;
+        if(em.median_time > 0.0) {
+            items_per_second = static_cast<double>(em.items_per_iteration) * 1.0e9 / em.median_time;
+        }
+
+        j["items_per_second"] = items_per_second;
+        rv.push_back(std::move(j));
+    }
+
+    return rv;
+}
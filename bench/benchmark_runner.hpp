@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common/json_incl.hpp"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    class benchmark_result {
+    public:
+        std::string name;
+        size_t iterations = 0U;
+
+        // Work done by one iteration, e.g. triangles or bytes, for throughput
+        size_t items_per_iteration = 0U;
+
+        // Times are in nanoseconds per iteration
+        double mean_time = 0.0;
+        double median_time = 0.0;
+        double min_time = 0.0;
+    };
+
+    // Runs each benchmark for at least a minimum number of iterations and a minimum duration,
+    // after one untimed warm-up iteration
+    class benchmark_runner {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        size_t min_iterations;
+        clock::duration min_duration;
+        std::vector<benchmark_result> results;
+
+        void add_result(std::string const &name,
+                        size_t items_per_iteration,
+                        std::vector<double> iteration_times);
+
+    public:
+        benchmark_runner(size_t min_iterations, clock::duration min_duration);
+
+        // Setup receives the iteration index and is not timed
+        template <class SetupFnT, class FnT>
+        void run(std::string const &name,
+                 size_t items_per_iteration,
+                 SetupFnT const &setup,
+                 FnT const &fn)
+        {
+            setup(size_t(0U));
+            fn();
+
+            std::vector<double> iteration_times;
+            clock::duration total = clock::duration::zero();
+            for(size_t i = 0; i < min_iterations || total < min_duration; ++i) {
+                setup(i);
+
+                auto begin = clock::now();
+                fn();
+                auto elapsed = clock::now() - begin;
+
+                total += elapsed;
+                iteration_times.push_back(
+                    std::chrono::duration<double, std::nano>(elapsed).count());
+            }
+
+            add_result(name, items_per_iteration, std::move(iteration_times));
+        }
+
+        template <class FnT>
+        void run(std::string const &name, size_t items_per_iteration, FnT const &fn)
+        {
+            run(
+                name, items_per_iteration, [](size_t) {}, fn);
+        }
+
+        json::json to_json() const;
+    };
+}
@@ -0,0 +1,554 @@
+#include "base/file_block.hpp"
+#include "base/file_stream.hpp"
+#include "base/job_system.hpp"
+#include "base/log.hpp"
+#include "base/md5.hpp"
+#include "base/memory_block.hpp"
+#include "base/range.hpp"
+#include "base/std_output_log_backend.hpp"
+#include "benchmark_runner.hpp"
+#include "common/capture_file.hpp"
+#include "compile/gob_virtual_container.hpp"
+#include "compile/raw_material.hpp"
+#include "core/execute_buffer_translator.hpp"
+#include "core/triangle_batch.hpp"
+#include "core/triangle_buffer.hpp"
+#include "math/color_conv.hpp"
+#include "program/options.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace jkgm {
+    namespace {
+        constexpr size_t num_synthetic_triangles = 4096U;
+        constexpr size_t num_synthetic_materials = 64U;
+        constexpr size_t num_ingest_vertices = 4096U;
+        constexpr size_t num_ingest_draws = 256U;
+        constexpr size_t triangles_per_ingest_draw = 32U;
+        constexpr size_t md5_buffer_size = 4U * 1024U * 1024U;
+        constexpr size_t num_gob_entries = 2048U;
+        constexpr size_t gob_entry_size = 4096U;
+        constexpr size_t num_job_items = 1U << 20;
+        constexpr size_t job_grain_size = 4096U;
+        constexpr size_t num_empty_jobs = 4096U;
+
+        // Materials for benchmarks. Every material is opaque and uses the default shader.
+        class bench_materials : public execute_buffer_materials {
+        public:
+            size_t get_material_shader_variant(material_instance_id /*id*/) override
+            {
+                return 0U;
+            }
+
+            bool get_material_has_alpha(material_instance_id /*id*/) override
+            {
+                return false;
+            }
+        };
+
+        class game_batches {
+        public:
+            job_system jobs;
+            triangle_batch world;
+            sorted_triangle_batch world_transparent;
+            triangle_batch gun;
+            sorted_triangle_batch gun_transparent;
+
+            game_batches()
+                : world_transparent(&jobs, transparency_sort_mode::partition, false)
+                , gun_transparent(&jobs, transparency_sort_mode::partition, false)
+            {
+            }
+
+            game_triangle_batches get()
+            {
+                return game_triangle_batches{&world, &world_transparent, &gun, &gun_transparent};
+            }
+
+            void clear()
+            {
+                world.clear();
+                world_transparent.clear();
+                gun.clear();
+                gun_transparent.clear();
+            }
+        };
+
+        // Small triangles scattered through the view volume, like a level's translucent surfaces
+        std::vector<triangle> make_synthetic_scene(std::mt19937 *rng)
+        {
+            std::uniform_real_distribution<float> screen_dist(-1.0f, 1.0f);
+            std::uniform_real_distribution<float> depth_dist(1.0f, 100.0f);
+            std::uniform_real_distribution<float> extent_dist(-0.05f, 0.05f);
+            std::uniform_int_distribution<size_t> material_dist(1U, num_synthetic_materials);
+            std::uniform_int_distribution<int> alpha_dist(64, 255);
+
+            auto make_vertex = [&](float cx, float cy, float w) {
+                return triangle_vertex(make_point((cx + extent_dist(*rng)) * w,
+                                                  (cy + extent_dist(*rng)) * w,
+                                                  -w,
+                                                  w),
+                                       make_point(screen_dist(*rng), screen_dist(*rng)),
+                                       color_rgba8(uint8_t(0xFFU),
+                                                   uint8_t(0xFFU),
+                                                   uint8_t(0xFFU),
+                                                   static_cast<uint8_t>(alpha_dist(*rng))));
+            };
+
+            std::vector<triangle> rv;
+            rv.reserve(num_synthetic_triangles);
+            for(size_t i = 0; i < num_synthetic_triangles; ++i) {
+                float cx = screen_dist(*rng);
+                float cy = screen_dist(*rng);
+                float w = depth_dist(*rng);
+                rv.emplace_back(make_vertex(cx, cy, w),
+                                make_vertex(cx, cy, w),
+                                make_vertex(cx, cy, w),
+                                material_instance_id(material_dist(*rng)),
+                                /*shader variant*/ 0U,
+                                /*alpha test*/ true);
+
+                // Numbered the way the execute buffer translator numbers them
+                auto first_vertex = static_cast<uint32_t>(i * 3U);
+                rv.back().source_vertices = {first_vertex, first_vertex + 1U, first_vertex + 2U};
+            }
+
+            return rv;
+        }
+
+        // The translucent world triangles of every game frame in a renderer capture
+        std::vector<std::vector<triangle>> load_captured_scenes(std::string const &capture_path)
+        {
+            capture_reader reader(make_file_input_stream(capture_path));
+            auto const &header = reader.get_header();
+
+            bench_materials materials;
+            game_batches batches;
+            execute_buffer_translator translator(&materials, batches.get());
+
+            std::vector<std::vector<triangle>> rv;
+            while(auto rec = reader.read_record()) {
+                if(rec->type == capture_record_type::execute_game && rec->chunks.size() == 3U) {
+                    auto const &vertices = rec->chunks[0];
+                    translator.translate(
+                        make_span(reinterpret_cast<d3d::tl_vertex const *>(vertices.data()),
+                                  vertices.size() / sizeof(d3d::tl_vertex)),
+                        make_span(rec->chunks[1]),
+                        header.internal_screen_scale,
+                        header.internal_screen_offset);
+                }
+                else if(rec->type == capture_record_type::present_game) {
+                    rv.emplace_back(batches.world_transparent.begin(),
+                                    batches.world_transparent.end());
+                    translator.reset();
+                    batches.clear();
+                }
+            }
+
+            return rv;
+        }
+
+        void run_sort_benchmarks(benchmark_runner *runner,
+                                 std::string const &scene_name,
+                                 std::vector<std::vector<triangle>> const &scenes)
+        {
+            if(scenes.empty()) {
+                return;
+            }
+
+            size_t total_triangles = 0U;
+            for(auto const &scene : scenes) {
+                total_triangles += scene.size();
+            }
+
+            size_t items = total_triangles / scenes.size();
+
+            job_system jobs;
+            auto run_sort = [&](std::string const &name, triangle_batch *tb) {
+                runner->run(
+                    str(format("sort.", scene_name, ".", name)),
+                    items,
+                    [&](size_t iteration) {
+                        tb->clear();
+                        for(auto const &tri : scenes[iteration % scenes.size()]) {
+                            tb->insert(tri);
+                        }
+                    },
+                    [&] { tb->sort(); });
+            };
+
+            triangle_batch material_batch;
+            run_sort("material", &material_batch);
+
+            sorted_triangle_batch partition_batch(&jobs, transparency_sort_mode::partition, false);
+            run_sort("partition", &partition_batch);
+
+            sorted_triangle_batch bucketed_batch(&jobs, transparency_sort_mode::bucketed, false);
+            run_sort("bucketed", &bucketed_batch);
+
+            sorted_triangle_batch temporal_batch(&jobs, transparency_sort_mode::partition, true);
+            run_sort("partition_temporal", &temporal_batch);
+        }
+
+        // Runs a fixed workload with increasing worker counts, up to the hardware thread count.
+        // Empty tasks measure submission and scheduling overhead.
+        void run_job_system_benchmarks(benchmark_runner *runner)
+        {
+            std::vector<float> items(num_job_items);
+            for(size_t i = 0; i < items.size(); ++i) {
+                items[i] = static_cast<float>(i);
+            }
+
+            auto kernel = [&](size_t first, size_t last) {
+                for(size_t i = first; i < last; ++i) {
+                    items[i] = std::sqrt(items[i] * 1.5f + 1.0f);
+                }
+            };
+
+            size_t max_workers = std::max(2U, std::thread::hardware_concurrency()) - 1U;
+            for(size_t num_workers = 1U;; num_workers *= 2U) {
+                num_workers = std::min(num_workers, max_workers);
+
+                job_system jobs(num_workers);
+                runner->run(str(format("jobs.parallel_for.workers_", num_workers)),
+                            items.size(),
+                            [&] { jobs.parallel_for(0U, items.size(), job_grain_size, kernel); });
+
+                std::vector<task> tasks;
+                tasks.reserve(num_empty_jobs);
+                runner->run(str(format("jobs.submit.workers_", num_workers)),
+                            num_empty_jobs,
+                            [&](size_t) { tasks.clear(); },
+                            [&] {
+                                for(size_t i = 0; i < num_empty_jobs; ++i) {
+                                    tasks.push_back(jobs.submit([] {}));
+                                }
+
+                                jobs.wait(tasks);
+                            });
+
+                if(num_workers >= max_workers) {
+                    break;
+                }
+            }
+        }
+
+        // Execute buffer with a material and blend change before every run of triangles
+        std::tuple<std::vector<d3d::tl_vertex>, std::vector<char>>
+            make_synthetic_execute_buffer(std::mt19937 *rng)
+        {
+            std::uniform_real_distribution<float> x_dist(0.0f, 640.0f);
+            std::uniform_real_distribution<float> y_dist(0.0f, 480.0f);
+            std::uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+            std::uniform_int_distribution<uint32_t> color_dist;
+            std::uniform_int_distribution<uint16_t> index_dist(0U, num_ingest_vertices - 1U);
+            std::uniform_int_distribution<uint32_t> material_dist(1U, num_synthetic_materials);
+
+            std::vector<d3d::tl_vertex> vertices;
+            for(size_t i = 0; i < num_ingest_vertices; ++i) {
+                vertices.push_back(d3d::tl_vertex{x_dist(*rng),
+                                                  y_dist(*rng),
+                                                  unit_dist(*rng),
+                                                  0.1f + unit_dist(*rng),
+                                                  color_dist(*rng) | 0xFF000000U,
+                                                  0U,
+                                                  unit_dist(*rng),
+                                                  unit_dist(*rng)});
+            }
+
+            std::vector<char> commands;
+            auto append = [&](auto const &value) {
+                auto bytes = make_span(&value, 1).as_const_bytes();
+                commands.insert(commands.end(), bytes.begin(), bytes.end());
+            };
+
+            for(size_t i = 0; i < num_ingest_draws; ++i) {
+                append(d3d::instruction{d3d::opcode::state_render, sizeof(d3d::state), 2U});
+                append(d3d::state{d3d::render_state::texture_handle, material_dist(*rng)});
+                append(d3d::state{d3d::render_state::alpha_blend_enable, (i % 4U == 0U) ? 1U : 0U});
+
+                append(d3d::instruction{d3d::opcode::triangle,
+                                        sizeof(d3d::triangle_indices),
+                                        static_cast<uint16_t>(triangles_per_ingest_draw)});
+                for(size_t j = 0; j < triangles_per_ingest_draw; ++j) {
+                    append(d3d::triangle_indices{
+                        index_dist(*rng), index_dist(*rng), index_dist(*rng), 0U});
+                }
+            }
+
+            append(d3d::instruction{d3d::opcode::exit, 0U, 0U});
+
+            return std::make_tuple(std::move(vertices), std::move(commands));
+        }
+
+        void run_ingest_benchmarks(benchmark_runner *runner, std::mt19937 *rng)
+        {
+            auto [vertices, commands] = make_synthetic_execute_buffer(rng);
+            size_t num_triangles = num_ingest_draws * triangles_per_ingest_draw;
+
+            bench_materials materials;
+            game_batches batches;
+            execute_buffer_translator translator(&materials, batches.get());
+
+            auto scr_scale = make_size(2.0f / 640.0f, 2.0f / 480.0f);
+            auto scr_offset = make_direction(0.0f, 0.0f);
+
+            runner->run(
+                "ingest.translate",
+                num_triangles,
+                [&](size_t) {
+                    translator.reset();
+                    batches.clear();
+                },
+                [&] {
+                    translator.translate(
+                        make_span(vertices), make_span(commands), scr_scale, scr_offset);
+                });
+
+            std::vector<triangle_buffer_vertex> buffer(
+                batches.world.size() * 3U,
+                triangle_buffer_vertex{
+                    point<4, float>::zero(), point<2, float>::zero(), color_rgba8::zero()});
+            runner->run("ingest.pack", batches.world.size(), [&] {
+                pack_triangle_buffer(batches.world, make_span(buffer));
+            });
+        }
+
+        void run_color_benchmarks(benchmark_runner *runner, std::mt19937 *rng)
+        {
+            std::uniform_int_distribution<uint16_t> pixel_dist;
+
+            std::vector<uint16_t> src(640U * 480U);
+            for(auto &em : src) {
+                em = pixel_dist(*rng);
+            }
+
+            std::vector<color_rgba8> dest(src.size(), color_rgba8::zero());
+
+            runner->run("color.rgb565_to_srgb_a8", src.size(), [&] {
+                for(size_t i = 0; i < src.size(); ++i) {
+                    dest[i] = rgb565_to_srgb_a8(src[i]);
+                }
+            });
+
+            runner->run("color.rgba5551_to_srgb_a8", src.size(), [&] {
+                for(size_t i = 0; i < src.size(); ++i) {
+                    dest[i] = rgba5551_to_srgb_a8(src[i]);
+                }
+            });
+
+            runner->run("color.rgb565_key_to_srgb_a8", src.size(), [&] {
+                for(size_t i = 0; i < src.size(); ++i) {
+                    dest[i] = rgb565_key_to_srgb_a8(src[i], src[i] == 0xF81FU);
+                }
+            });
+        }
+
+        void run_md5_benchmark(benchmark_runner *runner, std::mt19937 *rng)
+        {
+            std::vector<char> src(md5_buffer_size);
+            for(auto &em : src) {
+                em = static_cast<char>((*rng)());
+            }
+
+            md5_hasher hasher;
+            runner->run("md5", src.size(), [&] {
+                hasher.clear();
+                hasher.add(make_span(src));
+                hasher.finish();
+            });
+        }
+
+        // Writes a GOB with evenly sized entries, laid out like JK's resource archives
+        void write_synthetic_gob(fs::path const &filename)
+        {
+            struct gob_header {
+                char magic[4];
+                uint32_t first_index_offset;
+                uint32_t unknown;
+                uint32_t index_count;
+            };
+
+            struct gob_entry {
+                uint32_t chunk_offset;
+                uint32_t chunk_length;
+                char chunk_name[128];
+            };
+
+            auto os = make_file_output_block(filename);
+
+            gob_header header{{'G', 'O', 'B', ' '},
+                              static_cast<uint32_t>(sizeof(gob_header)),
+                              0U,
+                              static_cast<uint32_t>(num_gob_entries)};
+            os->write(make_span(&header, 1).as_const_bytes());
+
+            size_t data_offset = sizeof(gob_header) + (num_gob_entries * sizeof(gob_entry));
+            for(size_t i = 0; i < num_gob_entries; ++i) {
+                gob_entry entry;
+                std::memset(&entry, 0, sizeof(entry));
+                entry.chunk_offset = static_cast<uint32_t>(data_offset + (i * gob_entry_size));
+                entry.chunk_length = static_cast<uint32_t>(gob_entry_size);
+                std::snprintf(entry.chunk_name,
+                              sizeof(entry.chunk_name),
+                              "MAT\\BENCH%04d.MAT",
+                              static_cast<int>(i));
+                os->write(make_span(&entry, 1).as_const_bytes());
+            }
+
+            std::vector<char> contents(gob_entry_size, 'x');
+            for(size_t i = 0; i < num_gob_entries; ++i) {
+                os->write(make_span(contents));
+            }
+        }
+
+        // An 8-bit, single cel 64x64 material with a full mipmap chain
+        void write_synthetic_material(memory_block *mb)
+        {
+            memory_output_block os(mb);
+            auto write_u32 = [&](uint32_t value) {
+                os.write(make_span(&value, 1).as_const_bytes());
+            };
+
+            os.write(make_span("MAT ", 4));
+            write_u32(0x32U); // version
+            write_u32(2U); // type
+            write_u32(1U); // record count
+            write_u32(1U); // texture count
+            write_u32(0U); // transparency
+            write_u32(8U); // bitdepth
+            for(int i = 0; i < 12; ++i) {
+                write_u32(0U);
+            }
+
+            // Cel record
+            write_u32(8U);
+            write_u32(0U);
+            for(int i = 0; i < 4; ++i) {
+                float f = 0.0f;
+                os.write(make_span(&f, 1).as_const_bytes());
+            }
+
+            for(int i = 0; i < 3; ++i) {
+                write_u32(0U);
+            }
+
+            write_u32(0U);
+
+            // Texture record
+            uint32_t dim = 64U;
+            uint32_t mipmap_count = 7U;
+            write_u32(dim);
+            write_u32(dim);
+            write_u32(0U);
+            write_u32(0U);
+            write_u32(0U);
+            write_u32(mipmap_count);
+            for(uint32_t i = 0; i < mipmap_count; ++i) {
+                std::vector<char> data((dim >> i) * (dim >> i), 'x');
+                os.write(make_span(data));
+            }
+        }
+
+        void run_file_format_benchmarks(benchmark_runner *runner)
+        {
+            auto gob_path = fs::temp_directory_path() / "jkgm_bench.gob";
+            write_synthetic_gob(gob_path);
+
+            runner->run("gob.index", num_gob_entries, [&] {
+                gob_virtual_container container(gob_path);
+            });
+
+            gob_virtual_container container(gob_path);
+            std::vector<char> buffer(gob_entry_size);
+            runner->run("gob.read", num_gob_entries * gob_entry_size, [&] {
+                for(auto const &file : container) {
+                    file.open()->read(make_span(buffer));
+                }
+            });
+
+            fs::remove(gob_path);
+
+            memory_block mat_mb;
+            write_synthetic_material(&mat_mb);
+            runner->run("mat.parse", mat_mb.size(), [&] {
+                memory_input_block is(&mat_mb);
+                raw_material mat(&is);
+            });
+        }
+
+        class bench_program {
+        private:
+            options opts;
+
+            std::string output_path;
+            std::string capture_path;
+            bool quick = false;
+
+        public:
+            bench_program()
+            {
+                opts.insert(make_value_option("output", output_path));
+                opts.insert(make_value_option("capture", capture_path));
+                opts.insert(make_switch_option("quick", quick));
+            }
+
+            int start(range<char **> const &args)
+            {
+                try {
+                    opts.load_from_arg_list(args);
+                    return run();
+                }
+                catch(std::exception const &e) {
+                    LOG_ERROR("Exception thrown: ", e.what());
+                    return EXIT_FAILURE;
+                }
+            }
+
+            int run()
+            {
+                // Quick runs only check that every benchmark still works
+                benchmark_runner runner(quick ? 1U : 10U,
+                                        quick ? std::chrono::milliseconds(0)
+                                              : std::chrono::milliseconds(500));
+
+                // Fixed seed, so that results are comparable between runs
+                std::mt19937 rng(0x4A4B474DU);
+
+                run_sort_benchmarks(&runner, "synthetic", {make_synthetic_scene(&rng)});
+                if(!capture_path.empty()) {
+                    run_sort_benchmarks(&runner, "captured", load_captured_scenes(capture_path));
+                }
+
+                run_ingest_benchmarks(&runner, &rng);
+                run_color_benchmarks(&runner, &rng);
+                run_md5_benchmark(&runner, &rng);
+                run_file_format_benchmarks(&runner);
+                run_job_system_benchmarks(&runner);
+
+                if(!output_path.empty()) {
+                    json::json doc;
+                    doc["benchmarks"] = runner.to_json();
+
+                    auto os = make_file_output_stream(output_path);
+                    os->write(make_span(doc.dump(4)));
+                }
+
+                return EXIT_SUCCESS;
+            }
+        };
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jkgm::emplace_log_backend<jkgm::std_output_log_backend>(
+        {jkgm::log_level::error, jkgm::log_level::warning, jkgm::log_level::info});
+
+    jkgm::bench_program program;
+    return program.start(jkgm::make_range(argv + 1, argv + argc));
+}
@@ -0,0 +1,202 @@
+#include "capture_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace jkgm {
+    namespace {
+        // "JKGC", little endian
+        constexpr uint32_t capture_magic = 0x43474B4AU;
+        constexpr uint32_t capture_version = 1U;
+
+        // Guards against allocating for a corrupt record
+        constexpr uint32_t max_chunks = 16U;
+        constexpr uint32_t max_chunk_size = 256U * 1024U * 1024U;
+
+        struct capture_file_header {
+            uint32_t magic;
+            uint32_t version;
+            int32_t screen_width;
+            int32_t screen_height;
+            int32_t internal_screen_width;
+            int32_t internal_screen_height;
+            int32_t display_area_start_x;
+            int32_t display_area_start_y;
+            int32_t display_area_width;
+            int32_t display_area_height;
+            float internal_screen_scale_x;
+            float internal_screen_scale_y;
+            float internal_screen_offset_x;
+            float internal_screen_offset_y;
+        };
+
+        static_assert(sizeof(capture_file_header) == 56U);
+
+        void write_u32(output_stream *os, uint32_t value)
+        {
+            os->write(make_span(&value, 1).as_const_bytes());
+        }
+
+        uint32_t read_u32(input_stream *is)
+        {
+            uint32_t rv = 0U;
+            is->read(make_span(&rv, 1).as_bytes());
+            return rv;
+        }
+    }
+}
+
+jkgm::capture_writer::capture_writer(std::unique_ptr<output_stream> os,
+                                     capture_header const &header)
+    : os(std::move(os))
+{
+    capture_file_header fh;
+    fh.magic = capture_magic;
+    fh.version = capture_version;
+    fh.screen_width = get<x>(header.screen_res);
+    fh.screen_height = get<y>(header.screen_res);
+    fh.internal_screen_width = get<x>(header.internal_screen_res);
+    fh.internal_screen_height = get<y>(header.internal_screen_res);
+    fh.display_area_start_x = get<x>(header.display_area.start);
+    fh.display_area_start_y = get<y>(header.display_area.start);
+    fh.display_area_width = get<x>(header.display_area.size());
+    fh.display_area_height = get<y>(header.display_area.size());
+    fh.internal_screen_scale_x = get<x>(header.internal_screen_scale);
+    fh.internal_screen_scale_y = get<y>(header.internal_screen_scale);
+    fh.internal_screen_offset_x = get<x>(header.internal_screen_offset);
+    fh.internal_screen_offset_y = get<y>(header.internal_screen_offset);
+
+    this->os->write(make_span(&fh, 1).as_const_bytes());
+}
+
+void jkgm::capture_writer::write_record(capture_record_type type,
+                                        std::initializer_list<span<char const>> chunks)
+{
+    write_u32(os.get(), static_cast<uint32_t>(type));
+    write_u32(os.get(), static_cast<uint32_t>(chunks.size()));
+    for(auto const &chunk : chunks) {
+        write_u32(os.get(), static_cast<uint32_t>(chunk.size()));
+        os->write(chunk);
+    }
+}
+
+void jkgm::capture_writer::write_if_changed(capture_record_type type,
+                                            std::vector<char> *last,
+                                            span<char const> contents)
+{
+    if(last->size() == contents.size() &&
+       std::equal(contents.begin(), contents.end(), last->begin())) {
+        return;
+    }
+
+    last->assign(contents.begin(), contents.end());
+    write_record(type, {contents});
+}
+
+void jkgm::capture_writer::write_execute_game(span<char const> vertices,
+                                              span<char const> instructions,
+                                              span<char const> viewport)
+{
+    write_record(capture_record_type::execute_game, {vertices, instructions, viewport});
+}
+
+void jkgm::capture_writer::write_texture_load(capture_texture_info const &info,
+                                              span<char const> pixels)
+{
+    write_record(capture_record_type::texture_load,
+                 {make_span(&info, 1).as_const_bytes(), pixels});
+}
+
+void jkgm::capture_writer::write_present_game(span<char const> hud)
+{
+    write_if_changed(capture_record_type::hud, &last_hud, hud);
+    write_record(capture_record_type::present_game, {});
+}
+
+void jkgm::capture_writer::write_present_menu(span<char const> palette, span<char const> source)
+{
+    write_if_changed(capture_record_type::menu_palette, &last_menu_palette, palette);
+    write_if_changed(capture_record_type::menu_source, &last_menu_source, source);
+    write_record(capture_record_type::present_menu, {});
+}
+
+jkgm::capture_reader::capture_reader(std::unique_ptr<input_stream> is)
+    : is(std::move(is))
+{
+    capture_file_header fh;
+    this->is->read(make_span(&fh, 1).as_bytes());
+
+    if(fh.magic != capture_magic) {
+        throw std::runtime_error("File is not a renderer capture");
+    }
+
+    if(fh.version != capture_version) {
+        throw std::runtime_error("Renderer capture version is not supported");
+    }
+
+    header.screen_res = make_size(fh.screen_width, fh.screen_height);
+    header.internal_screen_res =
+        make_size(fh.internal_screen_width, fh.internal_screen_height);
+    header.display_area =
+        make_box(make_point(fh.display_area_start_x, fh.display_area_start_y),
+                 make_size(fh.display_area_width, fh.display_area_height));
+    header.internal_screen_scale =
+        make_size(fh.internal_screen_scale_x, fh.internal_screen_scale_y);
+    header.internal_screen_offset =
+        make_direction(fh.internal_screen_offset_x, fh.internal_screen_offset_y);
+}
+
+jkgm::capture_header const &jkgm::capture_reader::get_header() const
+{
+    return header;
+}
+
+std::optional<jkgm::capture_record> jkgm::capture_reader::read_record()
+{
+    // A capture may end at any record boundary, including when the game was closed mid-frame
+    uint32_t type = 0U;
+    auto type_bytes = make_span(&type, 1).as_bytes();
+    size_t amt = is->read_some(type_bytes);
+    if(amt == 0U) {
+        return std::nullopt;
+    }
+
+    if(amt < type_bytes.size()) {
+        is->read(type_bytes.subspan(amt, span_to_end));
+    }
+
+    capture_record rv;
+    rv.type = static_cast<capture_record_type>(type);
+
+    uint32_t num_chunks = read_u32(is.get());
+    if(num_chunks > max_chunks) {
+        throw std::runtime_error("Renderer capture record is corrupt");
+    }
+
+    rv.chunks.resize(num_chunks);
+    for(auto &chunk : rv.chunks) {
+        uint32_t chunk_size = read_u32(is.get());
+        if(chunk_size > max_chunk_size) {
+            throw std::runtime_error("Renderer capture record is corrupt");
+        }
+
+        chunk.resize(chunk_size);
+        if(chunk_size > 0U) {
+            is->read(make_span(chunk));
+        }
+    }
+
+    return rv;
+}
+
+jkgm::capture_texture_info jkgm::get_capture_texture_info(capture_record const &rec)
+{
+    if(rec.type != capture_record_type::texture_load || rec.chunks.size() != 2U ||
+       rec.chunks[0].size() != sizeof(capture_texture_info)) {
+        throw std::runtime_error("Renderer capture texture record is corrupt");
+    }
+
+    capture_texture_info rv;
+    std::memcpy(&rv, rec.chunks[0].data(), sizeof(capture_texture_info));
+    return rv;
+}
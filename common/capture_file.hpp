@@ -0,0 +1,110 @@
+#pragma once
+
+#include "base/input_stream.hpp"
+#include "base/output_stream.hpp"
+#include "base/span.hpp"
+#include "math/box.hpp"
+#include "math/direction.hpp"
+#include "math/size.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace jkgm {
+    // Renderer inputs, in the order JK issued them. Each record holds a list of byte chunks.
+    enum class capture_record_type : uint32_t {
+        // Vertices (D3DTLVERTEX), instructions, and the viewport (D3DVIEWPORT)
+        execute_game = 1,
+
+        // capture_texture_info, then the 16-bit source pixels
+        texture_load = 2,
+
+        // HUD backbuffer contents (RGB565) at the internal screen resolution
+        hud = 3,
+
+        // Presents a game frame with the most recent HUD
+        present_game = 4,
+
+        // 256 RGBA8 menu palette colors
+        menu_palette = 5,
+
+        // 640x480 indexed menu pixels, or nothing when JK has not provided a menu source
+        menu_source = 6,
+
+        // Presents a menu frame with the most recent palette and source
+        present_menu = 7
+    };
+
+    // Screen geometry in effect while the capture was recorded. Replays need it to place
+    // pretransformed vertices exactly as the renderer did.
+    class capture_header {
+    public:
+        size<2, int> screen_res = make_size(0, 0);
+        size<2, int> internal_screen_res = make_size(0, 0);
+        box<2, int> display_area = make_box(make_point(0, 0), make_size(0, 0));
+        size<2, float> internal_screen_scale = make_size(0.0f, 0.0f);
+        direction<2, float> internal_screen_offset = make_direction(0.0f, 0.0f);
+    };
+
+    struct capture_texture_info {
+        uint32_t material_id;
+        uint32_t width;
+        uint32_t height;
+        uint32_t has_alpha;
+    };
+
+    static_assert(sizeof(capture_texture_info) == 16U);
+
+    class capture_record {
+    public:
+        capture_record_type type = capture_record_type::present_game;
+        std::vector<std::vector<char>> chunks;
+    };
+
+    // Records renderer inputs to a stream. HUD and menu contents rarely change between frames,
+    // so they are only written when they differ from the previous frame.
+    //
+    // Not thread safe. JK makes every captured call from its own thread.
+    class capture_writer {
+    private:
+        std::unique_ptr<output_stream> os;
+        std::vector<char> last_hud;
+        std::vector<char> last_menu_palette;
+        std::vector<char> last_menu_source;
+
+        void write_record(capture_record_type type, std::initializer_list<span<char const>> chunks);
+        void write_if_changed(capture_record_type type,
+                              std::vector<char> *last,
+                              span<char const> contents);
+
+    public:
+        capture_writer(std::unique_ptr<output_stream> os, capture_header const &header);
+
+        void write_execute_game(span<char const> vertices,
+                                span<char const> instructions,
+                                span<char const> viewport);
+        void write_texture_load(capture_texture_info const &info, span<char const> pixels);
+        void write_present_game(span<char const> hud);
+        void write_present_menu(span<char const> palette, span<char const> source);
+    };
+
+    // Reads a capture written by capture_writer. Throws when the stream is not a capture, or was
+    // written by an incompatible version.
+    class capture_reader {
+    private:
+        std::unique_ptr<input_stream> is;
+        capture_header header;
+
+    public:
+        explicit capture_reader(std::unique_ptr<input_stream> is);
+
+        capture_header const &get_header() const;
+
+        // Returns nothing at the end of the capture
+        std::optional<capture_record> read_record();
+    };
+
+    capture_texture_info get_capture_texture_info(capture_record const &rec);
+}
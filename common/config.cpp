@@ -4,6 +4,7 @@
 #include "base/memory_block.hpp"
 #include "error_reporter.hpp"
 #include "json_incl.hpp"
+#include <algorithm>
 
 std::unique_ptr<jkgm::config> jkgm::load_config_file()
 {
@@ -61,6 +62,171 @@ std::unique_ptr<jkgm::config> jkgm::load_config_file()
             j.at("enable_posterized_lighting").get_to(rv->enable_posterized_lighting);
         }
 
+        if(j.contains("enable_render_thread")) {
+            j.at("enable_render_thread").get_to(rv->enable_render_thread);
+        }
+
+        if(j.contains("transparency_mode")) {
+            auto em = j.at("transparency_mode").get<std::string>();
+            if(em == "sorted") {
+                rv->transparency_mode = transparency_mode::sorted;
+            }
+            else if(em == "weighted_blended") {
+                rv->transparency_mode = transparency_mode::weighted_blended;
+            }
+            else {
+                LOG_WARNING("Unknown transparency_mode '", em, "' was ignored");
+            }
+        }
+
+        if(j.contains("transparency_sort")) {
+            auto em = j.at("transparency_sort").get<std::string>();
+            if(em == "partition") {
+                rv->transparency_sort = transparency_sort_mode::partition;
+            }
+            else if(em == "bucketed") {
+                rv->transparency_sort = transparency_sort_mode::bucketed;
+            }
+            else {
+                LOG_WARNING("Unknown transparency_sort mode '", em, "' was ignored");
+            }
+        }
+
+        if(j.contains("enable_temporal_transparency_sort")) {
+            j.at("enable_temporal_transparency_sort")
+                .get_to(rv->enable_temporal_transparency_sort);
+        }
+
+        if(j.contains("render_scale")) {
+            j.at("render_scale").get_to(rv->render_scale);
+        }
+
+        if(j.contains("enable_dynamic_render_scale")) {
+            j.at("enable_dynamic_render_scale").get_to(rv->enable_dynamic_render_scale);
+        }
+
+        if(j.contains("min_render_scale")) {
+            j.at("min_render_scale").get_to(rv->min_render_scale);
+        }
+
+        if(j.contains("target_frame_time")) {
+            j.at("target_frame_time").get_to(rv->target_frame_time);
+        }
+
+        if(j.contains("upscale_sharpness")) {
+            j.at("upscale_sharpness").get_to(rv->upscale_sharpness);
+        }
+
+        if(j.contains("quality")) {
+            auto em = j.at("quality").get<std::string>();
+            if(em == "manual") {
+                rv->quality = quality_mode::manual;
+            }
+            else if(em == "auto") {
+                rv->quality = quality_mode::automatic;
+            }
+            else {
+                LOG_WARNING("Unknown quality mode '", em, "' was ignored");
+            }
+        }
+
+        if(j.contains("max_frame_rate")) {
+            j.at("max_frame_rate").get_to(rv->max_frame_rate);
+        }
+
+        if(j.contains("max_frames_in_flight")) {
+            j.at("max_frames_in_flight").get_to(rv->max_frames_in_flight);
+            if(rv->max_frames_in_flight < 0 || rv->max_frames_in_flight > 3) {
+                LOG_WARNING("max_frames_in_flight must be between 0 and 3");
+                rv->max_frames_in_flight = std::clamp(rv->max_frames_in_flight, 0, 3);
+            }
+        }
+
+        if(j.contains("background_mode")) {
+            auto em = j.at("background_mode").get<std::string>();
+            if(em == "none") {
+                rv->background_mode = background_mode::none;
+            }
+            else if(em == "throttle") {
+                rv->background_mode = background_mode::throttle;
+            }
+            else if(em == "pause") {
+                rv->background_mode = background_mode::pause;
+            }
+            else {
+                LOG_WARNING("Unknown background_mode '", em, "' was ignored");
+            }
+        }
+
+        if(j.contains("background_frame_rate")) {
+            j.at("background_frame_rate").get_to(rv->background_frame_rate);
+        }
+
+        if(j.contains("enable_gpu_profiler")) {
+            j.at("enable_gpu_profiler").get_to(rv->enable_gpu_profiler);
+        }
+
+        if(j.contains("enable_gpu_profiler_overlay")) {
+            j.at("enable_gpu_profiler_overlay").get_to(rv->enable_gpu_profiler_overlay);
+        }
+
+        if(j.contains("gpu_profiler_csv_path")) {
+            auto const &em = j["gpu_profiler_csv_path"];
+            if(!em.is_null()) {
+                rv->gpu_profiler_csv_path = em;
+            }
+        }
+
+        if(j.contains("enable_frame_statistics")) {
+            j.at("enable_frame_statistics").get_to(rv->enable_frame_statistics);
+        }
+
+        if(j.contains("enable_frame_statistics_overlay")) {
+            j.at("enable_frame_statistics_overlay").get_to(rv->enable_frame_statistics_overlay);
+        }
+
+        if(j.contains("enable_level_load_report")) {
+            j.at("enable_level_load_report").get_to(rv->enable_level_load_report);
+        }
+
+        if(j.contains("level_load_report_path")) {
+            auto const &em = j["level_load_report_path"];
+            if(!em.is_null()) {
+                rv->level_load_report_path = em;
+            }
+        }
+
+        if(j.contains("enable_frame_time_report")) {
+            j.at("enable_frame_time_report").get_to(rv->enable_frame_time_report);
+        }
+
+        if(j.contains("hitch_threshold_ms")) {
+            j.at("hitch_threshold_ms").get_to(rv->hitch_threshold_ms);
+        }
+
+        if(j.contains("enable_cpu_trace")) {
+            j.at("enable_cpu_trace").get_to(rv->enable_cpu_trace);
+        }
+
+        if(j.contains("cpu_trace_seconds")) {
+            j.at("cpu_trace_seconds").get_to(rv->cpu_trace_seconds);
+        }
+
+        if(j.contains("cpu_trace_path")) {
+            j.at("cpu_trace_path").get_to(rv->cpu_trace_path);
+        }
+
+        if(j.contains("capture_path")) {
+            auto const &em = j["capture_path"];
+            if(!em.is_null()) {
+                rv->capture_path = em;
+            }
+        }
+
+        if(j.contains("capture_frames")) {
+            j.at("capture_frames").get_to(rv->capture_frames);
+        }
+
         if(j.contains("command")) {
             j.at("command").get_to(rv->command);
         }
@@ -6,6 +6,46 @@
 #include <tuple>
 
 namespace jkgm {
+    enum class transparency_sort_mode {
+        // Recursive pivot partitioning. Exact for separable scenes, but quadratic when many
+        // triangles are mutually ambiguous.
+        partition,
+
+        // Depth order with a bounded occlusion fix-up between neighbors. Always O(n log n).
+        bucketed
+    };
+
+    enum class transparency_mode {
+        // Translucent world geometry is sorted on the CPU and blended in order
+        sorted,
+
+        // Translucent world geometry is blended in any order using weighted blended
+        // order-independent transparency. The sort is skipped entirely.
+        weighted_blended
+    };
+
+    enum class quality_mode {
+        // Quality options are used as written in jkgm.json
+        manual,
+
+        // Quality options are chosen by a short GPU benchmark the first time the game runs on
+        // new hardware. The choice is stored in jkgm_quality.json. The benchmark picks bloom,
+        // SSAO, anisotropy and render scale. Parallax stays enabled unless nothing else fits.
+        automatic
+    };
+
+    enum class background_mode {
+        // Rendering continues at full rate and quality
+        none,
+
+        // While unfocused, frames are drawn at background_frame_rate without SSAO or bloom.
+        // While minimized or hidden, frames are not drawn at all.
+        throttle,
+
+        // While unfocused, minimized or hidden, frames are not drawn at all
+        pause
+    };
+
     class config {
     public:
         std::tuple<int, int> resolution = std::make_tuple(640, 480);
@@ -18,6 +58,34 @@ namespace jkgm {
         bool enable_parallax = true;
         bool enable_texture_filtering = true;
         bool enable_posterized_lighting = false;
+        bool enable_render_thread = false;
+        jkgm::transparency_mode transparency_mode = jkgm::transparency_mode::sorted;
+        transparency_sort_mode transparency_sort = transparency_sort_mode::partition;
+        bool enable_temporal_transparency_sort = false;
+        float render_scale = 1.0f;
+        bool enable_dynamic_render_scale = false;
+        float min_render_scale = 0.5f;
+        float target_frame_time = 16.6f;
+        float upscale_sharpness = 0.8f;
+        quality_mode quality = quality_mode::manual;
+        float max_frame_rate = 0.0f;
+        int max_frames_in_flight = 0;
+        jkgm::background_mode background_mode = jkgm::background_mode::throttle;
+        float background_frame_rate = 15.0f;
+        bool enable_gpu_profiler = false;
+        bool enable_gpu_profiler_overlay = false;
+        std::optional<std::string> gpu_profiler_csv_path;
+        bool enable_frame_statistics = false;
+        bool enable_frame_statistics_overlay = false;
+        bool enable_level_load_report = false;
+        std::optional<std::string> level_load_report_path;
+        bool enable_frame_time_report = false;
+        float hitch_threshold_ms = 50.0f;
+        bool enable_cpu_trace = false;
+        float cpu_trace_seconds = 10.0f;
+        std::string cpu_trace_path = "jkgm_trace.json";
+        std::optional<std::string> capture_path;
+        int capture_frames = 600;
         std::string command = "jk.exe";
         std::string data_path = "jkgm";
         std::optional<std::string> log_path;
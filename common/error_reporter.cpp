@@ -1,5 +1,8 @@
 #include "error_reporter.hpp"
 #include "base/log.hpp"
+
+#ifdef PLATFORM_WINDOWS
+
 #include "base/system_string.hpp"
 #include <Windows.h>
 
@@ -23,6 +26,23 @@ namespace {
     }
 }
 
+#else
+
+namespace {
+    // Tools built for other platforms run headless
+    void error_dialog(std::string_view message)
+    {
+        LOG_ERROR(message);
+    }
+
+    void warning_dialog(std::string_view message)
+    {
+        LOG_WARNING(message);
+    }
+}
+
+#endif // PLATFORM_WINDOWS
+
 void jkgm::report_error_message(std::string_view msg)
 {
     error_dialog(msg);
@@ -10,13 +10,9 @@ jkgm::image::image(size<2, int> dimensions)
     data.resize(volume(dimensions), color_rgba8::zero());
 }
 
-std::unique_ptr<jkgm::image> jkgm::load_image(input_stream *is)
+std::unique_ptr<jkgm::image> jkgm::load_image(span<char const> encoded)
 {
-    memory_block mb;
-    memory_output_block mob(&mb);
-    is->copy_to(&mob);
-
-    auto dat_span = make_span(mb).as_unsigned_const_bytes();
+    auto dat_span = encoded.as_unsigned_const_bytes();
 
     int width, height, channels;
     unsigned char *data = stbi_load_from_memory(
@@ -39,6 +35,15 @@ std::unique_ptr<jkgm::image> jkgm::load_image(input_stream *is)
     return rv;
 }
 
+std::unique_ptr<jkgm::image> jkgm::load_image(input_stream *is)
+{
+    memory_block mb;
+    memory_output_block mob(&mb);
+    is->copy_to(&mob);
+
+    return load_image(make_span(mb));
+}
+
 void jkgm::store_image_png(output_stream *os, image const &img)
 {
     auto write_func = [](void *context, void *data, int size) {
@@ -2,8 +2,10 @@
 
 #include "base/input_stream.hpp"
 #include "base/output_stream.hpp"
+#include "base/span.hpp"
 #include "math/color.hpp"
 #include "math/size.hpp"
+#include <memory>
 #include <vector>
 
 namespace jkgm {
@@ -15,6 +17,7 @@ namespace jkgm {
         explicit image(size<2, int> dimensions);
     };
 
+    std::unique_ptr<image> load_image(span<char const> encoded);
     std::unique_ptr<image> load_image(input_stream *is);
     void store_image_png(output_stream *os, image const &img);
 }
\ No newline at end of file
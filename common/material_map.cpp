@@ -3,6 +3,7 @@
 #include "base/log.hpp"
 #include "base/memory_block.hpp"
 #include "base/string_search.hpp"
+#include "base/trace.hpp"
 #include "error_reporter.hpp"
 #include "json_incl.hpp"
 
@@ -23,6 +24,8 @@ void jkgm::material_map::add_metadata(fs::path const &metadata_file)
               metadata_file.generic_string(),
               ")");
 
+    pack_names.push_back(doc["name"]);
+
     for(auto const &em : doc["materials"]) {
         auto mat = std::make_unique<material>();
 
@@ -81,6 +84,8 @@ void jkgm::material_map::add_metadata(fs::path const &metadata_file)
 
 void jkgm::material_map::create_map(fs::path const &materials_dir)
 {
+    TRACE_SCOPE("material_map::create_map");
+
     LOG_DEBUG("Loading material map...");
     // Search for metadata.json files in subdirectories
     for(fs::directory_iterator dir_iter(materials_dir); dir_iter != fs::directory_iterator();
@@ -114,4 +119,9 @@ std::optional<jkgm::material const *> jkgm::material_map::get_material(md5 const
     }
 
     return std::nullopt;
-}
\ No newline at end of file
+}
+
+std::vector<std::string> const &jkgm::material_map::get_pack_names() const
+{
+    return pack_names;
+}
@@ -10,6 +10,7 @@ namespace jkgm {
     private:
         std::vector<std::unique_ptr<material>> materials;
         std::unordered_map<md5, size_t> signature_map;
+        std::vector<std::string> pack_names;
 
         void add_metadata(fs::path const &metadata_file);
 
@@ -17,5 +18,8 @@ namespace jkgm {
         void create_map(fs::path const &materials_dir);
 
         std::optional<material const *> get_material(md5 const &sig) const;
+
+        // Names of the loaded material packs, in load order
+        std::vector<std::string> const &get_pack_names() const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "quality_profile.hpp"
+#include "base/file_stream.hpp"
+#include "base/log.hpp"
+#include "base/memory_block.hpp"
+#include "json_incl.hpp"
+
+namespace jkgm {
+    namespace {
+        constexpr char const *quality_profile_filename = "jkgm_quality.json";
+    }
+}
+
+jkgm::quality_settings jkgm::get_configured_quality_settings(config const &conf)
+{
+    quality_settings rv;
+    rv.max_anisotropy = conf.max_anisotropy;
+    rv.enable_bloom = conf.enable_bloom;
+    rv.enable_ssao = conf.enable_ssao;
+    rv.enable_parallax = conf.enable_parallax;
+    rv.render_scale = conf.render_scale;
+    return rv;
+}
+
+std::optional<jkgm::quality_settings>
+    jkgm::load_quality_profile(quality_profile const &expected)
+{
+    quality_profile stored;
+
+    try {
+        auto fs = make_file_input_stream(quality_profile_filename);
+
+        memory_block mb;
+        memory_output_block mob(&mb);
+        fs->copy_to(&mob);
+
+        auto j = json::json::parse(mb.str());
+        j.at("hardware").get_to(stored.hardware_signature);
+        j.at("resolution").get_to(stored.resolution);
+        j.at("target_frame_time").get_to(stored.target_frame_time);
+
+        auto const &sj = j.at("settings");
+        sj.at("max_anisotropy").get_to(stored.settings.max_anisotropy);
+        sj.at("enable_bloom").get_to(stored.settings.enable_bloom);
+        sj.at("enable_ssao").get_to(stored.settings.enable_ssao);
+        sj.at("enable_parallax").get_to(stored.settings.enable_parallax);
+        sj.at("render_scale").get_to(stored.settings.render_scale);
+    }
+    catch(std::exception const &e) {
+        LOG_INFO("No stored quality profile: ", e.what());
+        return std::nullopt;
+    }
+
+    if(stored.hardware_signature != expected.hardware_signature) {
+        LOG_INFO("Stored quality profile was chosen for different hardware");
+        return std::nullopt;
+    }
+
+    if(stored.resolution != expected.resolution ||
+       stored.target_frame_time != expected.target_frame_time) {
+        LOG_INFO("Stored quality profile was chosen for a different resolution or target");
+        return std::nullopt;
+    }
+
+    return stored.settings;
+}
+
+void jkgm::save_quality_profile(quality_profile const &profile)
+{
+    json::json j;
+    j["hardware"] = profile.hardware_signature;
+    j["resolution"] = profile.resolution;
+    j["target_frame_time"] = profile.target_frame_time;
+    j["settings"] = {{"max_anisotropy", profile.settings.max_anisotropy},
+                     {"enable_bloom", profile.settings.enable_bloom},
+                     {"enable_ssao", profile.settings.enable_ssao},
+                     {"enable_parallax", profile.settings.enable_parallax},
+                     {"render_scale", profile.settings.render_scale}};
+
+    try {
+        auto fs = make_file_output_stream(quality_profile_filename);
+        fs->write(make_span(j.dump(4)));
+    }
+    catch(std::exception const &e) {
+        LOG_WARNING("Failed to write ", quality_profile_filename, ": ", e.what());
+    }
+}
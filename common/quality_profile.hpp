@@ -0,0 +1,34 @@
+#pragma once
+
+#include "config.hpp"
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace jkgm {
+    // The subset of options that trade image quality for GPU time
+    class quality_settings {
+    public:
+        float max_anisotropy = 2.0f;
+        bool enable_bloom = true;
+        bool enable_ssao = true;
+        bool enable_parallax = true;
+        float render_scale = 1.0f;
+    };
+
+    quality_settings get_configured_quality_settings(config const &conf);
+
+    // Quality settings chosen for one combination of hardware, resolution and frame-time target
+    class quality_profile {
+    public:
+        std::string hardware_signature;
+        std::tuple<int, int> resolution = std::make_tuple(0, 0);
+        float target_frame_time = 0.0f;
+        quality_settings settings;
+    };
+
+    // Returns the stored profile if it was chosen for the same hardware, resolution and target
+    // as expected. Otherwise the benchmark must be run again.
+    std::optional<quality_settings> load_quality_profile(quality_profile const &expected);
+    void save_quality_profile(quality_profile const &profile);
+}
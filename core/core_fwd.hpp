@@ -0,0 +1,8 @@
+#pragma once
+
+#include "base/id.hpp"
+#include <cstddef>
+
+namespace jkgm {
+    MAKE_ID_TYPE(material_instance, size_t);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+namespace jkgm::d3d {
+    // Layouts and constants of the Direct3D execute buffer structures JK writes, so they can be
+    // decoded without the Windows SDK
+
+    struct tl_vertex {
+        float sx;
+        float sy;
+        float sz;
+        float rhw;
+        uint32_t color;
+        uint32_t specular;
+        float tu;
+        float tv;
+    };
+
+    struct instruction {
+        uint8_t opcode;
+        uint8_t size;
+        uint16_t count;
+    };
+
+    struct process_vertices {
+        uint32_t flags;
+        uint16_t start;
+        uint16_t dest;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct state {
+        uint32_t type;
+        uint32_t arg;
+    };
+
+    struct triangle_indices {
+        uint16_t v1;
+        uint16_t v2;
+        uint16_t v3;
+        uint16_t flags;
+    };
+
+    static_assert(sizeof(tl_vertex) == 32U);
+    static_assert(sizeof(instruction) == 4U);
+    static_assert(sizeof(process_vertices) == 16U);
+    static_assert(sizeof(state) == 8U);
+    static_assert(sizeof(triangle_indices) == 8U);
+
+    namespace opcode {
+        constexpr uint8_t triangle = 3U;
+        constexpr uint8_t state_render = 8U;
+        constexpr uint8_t process_vertices = 9U;
+        constexpr uint8_t exit = 11U;
+    }
+
+    namespace process_vertices_flags {
+        constexpr uint32_t copy = 2U;
+    }
+
+    namespace render_state {
+        constexpr uint32_t texture_handle = 1U;
+        constexpr uint32_t antialias = 2U;
+        constexpr uint32_t texture_perspective = 4U;
+        constexpr uint32_t wrap_u = 5U;
+        constexpr uint32_t wrap_v = 6U;
+        constexpr uint32_t z_enable = 7U;
+        constexpr uint32_t fill_mode = 8U;
+        constexpr uint32_t shade_mode = 9U;
+        constexpr uint32_t mono_enable = 11U;
+        constexpr uint32_t z_write_enable = 14U;
+        constexpr uint32_t alpha_test_enable = 15U;
+        constexpr uint32_t texture_mag = 17U;
+        constexpr uint32_t texture_min = 18U;
+        constexpr uint32_t src_blend = 19U;
+        constexpr uint32_t dest_blend = 20U;
+        constexpr uint32_t texture_map_blend = 21U;
+        constexpr uint32_t cull_mode = 22U;
+        constexpr uint32_t z_func = 23U;
+        constexpr uint32_t alpha_func = 25U;
+        constexpr uint32_t dither_enable = 26U;
+        constexpr uint32_t alpha_blend_enable = 27U;
+        constexpr uint32_t fog_enable = 28U;
+        constexpr uint32_t specular_enable = 29U;
+        constexpr uint32_t subpixel = 31U;
+        constexpr uint32_t subpixel_x = 32U;
+        constexpr uint32_t stippled_alpha = 33U;
+    }
+}
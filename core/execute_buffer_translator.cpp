@@ -0,0 +1,223 @@
+#include "execute_buffer_translator.hpp"
+#include "base/format.hpp"
+#include "base/log.hpp"
+#include "common/error_reporter.hpp"
+#include <stdexcept>
+
+namespace jkgm {
+    namespace {
+        point<4, float> d3dtl_to_point(size<2, float> const &scr_scale,
+                                       direction<2, float> const &screen_offset,
+                                       d3d::tl_vertex const &p)
+        {
+            // Reassign w for full-screen overlay vertices
+            float w = 1.0f;
+            if(p.rhw != 0.0f) {
+                w = 1.0f / p.rhw;
+            }
+
+            // Convert pretransformed vertex to phony view space
+            return make_point(w * ((p.sx * get<x>(scr_scale)) - 1.0f + get<x>(screen_offset)),
+                              w * ((-p.sy * get<y>(scr_scale)) + 1.0f - get<y>(screen_offset)),
+                              w * (-p.sz),
+                              w);
+        }
+
+        // Direct3D packs vertex colors as ARGB
+        color_rgba8 d3d_to_color_rgba8(uint32_t c)
+        {
+            return color_rgba8(static_cast<uint8_t>((c >> 16) & 0xFFU),
+                               static_cast<uint8_t>((c >> 8) & 0xFFU),
+                               static_cast<uint8_t>(c & 0xFFU),
+                               static_cast<uint8_t>((c >> 24) & 0xFFU));
+        }
+
+        template <class T>
+        T const &get_payload(span<char const> cmd_span, size_t size)
+        {
+            if(size < sizeof(T) || cmd_span.size() < size) {
+                throw std::runtime_error("Execute buffer instruction is truncated");
+            }
+
+            return *(T const *)cmd_span.data();
+        }
+
+        d3d::tl_vertex const &get_vertex(span<d3d::tl_vertex const> vertices, uint16_t index)
+        {
+            if(index >= vertices.size()) {
+                throw std::runtime_error("Execute buffer triangle refers to a missing vertex");
+            }
+
+            return vertices.data()[index];
+        }
+    }
+}
+
+jkgm::execute_buffer_translator::execute_buffer_translator(execute_buffer_materials *materials,
+                                                           game_triangle_batches const &batches)
+    : materials(materials)
+    , batches(batches)
+    , current_triangle_batch(batches.world)
+{
+}
+
+void jkgm::execute_buffer_translator::update_current_batch()
+{
+    if(is_gun && is_transparent) {
+        current_triangle_batch = batches.gun_transparent;
+    }
+    else if(is_gun) {
+        current_triangle_batch = batches.gun;
+    }
+    else if(is_transparent) {
+        current_triangle_batch = batches.world_transparent;
+    }
+    else {
+        current_triangle_batch = batches.world;
+    }
+}
+
+void jkgm::execute_buffer_translator::translate(span<d3d::tl_vertex const> vertices,
+                                                span<char const> commands,
+                                                size<2, float> const &scr_scale,
+                                                direction<2, float> const &scr_offset)
+{
+    auto first_vertex = vertex_base;
+    vertex_base += static_cast<uint32_t>(vertices.size());
+
+    auto cmd_span = commands;
+    while(!cmd_span.empty()) {
+        auto const &inst = get_payload<d3d::instruction>(cmd_span, sizeof(d3d::instruction));
+        cmd_span = cmd_span.subspan(sizeof(d3d::instruction), span_to_end);
+
+        for(size_t i = 0; i < inst.count; ++i) {
+            switch(inst.opcode) {
+            case d3d::opcode::exit:
+                break;
+
+            case d3d::opcode::process_vertices: {
+                auto const &payload = get_payload<d3d::process_vertices>(cmd_span, inst.size);
+                if(payload.flags != d3d::process_vertices_flags::copy || payload.start != 0 ||
+                   payload.dest != 0) {
+                    report_unimplemented_function(str(format("Process vertices opcode: ",
+                                                             payload.flags,
+                                                             " ",
+                                                             payload.count,
+                                                             " ",
+                                                             payload.start,
+                                                             " ",
+                                                             payload.dest)));
+                }
+            } break;
+
+            case d3d::opcode::state_render: {
+                auto const &payload = get_payload<d3d::state>(cmd_span, inst.size);
+                switch(payload.type) {
+                case d3d::render_state::texture_handle:
+                    current_material = material_instance_id((size_t)payload.arg);
+                    current_shader_variant =
+                        materials->get_material_shader_variant(current_material);
+                    current_material_has_alpha =
+                        materials->get_material_has_alpha(current_material);
+                    break;
+
+                // Silently ignore some useless commands
+                case d3d::render_state::antialias:
+                case d3d::render_state::texture_perspective:
+                case d3d::render_state::fill_mode:
+                case d3d::render_state::texture_mag:
+                case d3d::render_state::texture_min:
+                case d3d::render_state::src_blend:
+                case d3d::render_state::wrap_u:
+                case d3d::render_state::wrap_v:
+                case d3d::render_state::dest_blend:
+                case d3d::render_state::alpha_func:
+                case d3d::render_state::dither_enable:
+                case d3d::render_state::fog_enable:
+                case d3d::render_state::subpixel:
+                case d3d::render_state::subpixel_x:
+                case d3d::render_state::texture_map_blend:
+                case d3d::render_state::stippled_alpha:
+                case d3d::render_state::shade_mode:
+                case d3d::render_state::z_enable:
+                case d3d::render_state::specular_enable:
+                case d3d::render_state::alpha_test_enable:
+                case d3d::render_state::cull_mode:
+                case d3d::render_state::z_func:
+                case d3d::render_state::mono_enable:
+                    break;
+
+                case d3d::render_state::alpha_blend_enable:
+                    is_transparent = (payload.arg != 0);
+                    update_current_batch();
+                    break;
+
+                case d3d::render_state::z_write_enable:
+                    if(!payload.arg) {
+                        // ACTUALLY means drawing the weapon overlay.
+                        is_gun = true;
+                        update_current_batch();
+                    }
+                    break;
+
+                default:
+                    LOG_WARNING("Ignored unknown state render opcode: ", (int)payload.type);
+                    break;
+                }
+            } break;
+
+            case d3d::opcode::triangle: {
+                auto const &payload = get_payload<d3d::triangle_indices>(cmd_span, inst.size);
+
+                auto const &v1 = get_vertex(vertices, payload.v1);
+                auto const &v2 = get_vertex(vertices, payload.v2);
+                auto const &v3 = get_vertex(vertices, payload.v3);
+
+                auto c1 = d3d_to_color_rgba8(v1.color);
+                auto c2 = d3d_to_color_rgba8(v2.color);
+                auto c3 = d3d_to_color_rgba8(v3.color);
+
+                triangle tri(
+                    triangle_vertex(d3dtl_to_point(scr_scale, scr_offset, v1),
+                                    make_point(v1.tu, v1.tv),
+                                    c1),
+                    triangle_vertex(d3dtl_to_point(scr_scale, scr_offset, v2),
+                                    make_point(v2.tu, v2.tv),
+                                    c2),
+                    triangle_vertex(d3dtl_to_point(scr_scale, scr_offset, v3),
+                                    make_point(v3.tu, v3.tv),
+                                    c3),
+                    current_material,
+                    current_shader_variant,
+                    /*alpha test*/ is_transparent || current_material_has_alpha ||
+                        get<a>(c1) < 0xFFU || get<a>(c2) < 0xFFU || get<a>(c3) < 0xFFU);
+                tri.source_vertices = {first_vertex + payload.v1,
+                                       first_vertex + payload.v2,
+                                       first_vertex + payload.v3};
+                current_triangle_batch->insert(tri);
+            } break;
+
+            default:
+                LOG_WARNING(
+                    "Unimplemented execute buffer opcode ", (int)inst.opcode, " was ignored");
+            }
+
+            if(cmd_span.size() < inst.size) {
+                throw std::runtime_error("Execute buffer instruction is truncated");
+            }
+
+            cmd_span = cmd_span.subspan(inst.size, span_to_end);
+        }
+    }
+}
+
+void jkgm::execute_buffer_translator::reset()
+{
+    is_gun = false;
+    is_transparent = false;
+    current_triangle_batch = batches.world;
+    current_material = material_instance_id(0U);
+    current_shader_variant = 0U;
+    current_material_has_alpha = false;
+    vertex_base = 0U;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "base/span.hpp"
+#include "core_fwd.hpp"
+#include "d3d_types.hpp"
+#include "math/direction.hpp"
+#include "math/size.hpp"
+#include "triangle_batch.hpp"
+
+namespace jkgm {
+    // Material properties that decide how a translated triangle is drawn
+    class execute_buffer_materials {
+    public:
+        virtual ~execute_buffer_materials() = default;
+
+        virtual size_t get_material_shader_variant(material_instance_id id) = 0;
+        virtual bool get_material_has_alpha(material_instance_id id) = 0;
+    };
+
+    // Batches that receive a game frame's triangles
+    struct game_triangle_batches {
+        triangle_batch *world;
+        triangle_batch *world_transparent;
+        triangle_batch *gun;
+        triangle_batch *gun_transparent;
+    };
+
+    // Decodes Direct3D execute buffers into triangle batches. Render state persists across
+    // execute buffers until reset() is called at the end of the frame.
+    class execute_buffer_translator {
+    private:
+        execute_buffer_materials *materials;
+        game_triangle_batches batches;
+
+        bool is_gun = false;
+        bool is_transparent = false;
+        triangle_batch *current_triangle_batch;
+
+        material_instance_id current_material = material_instance_id(0U);
+        size_t current_shader_variant = 0U;
+        bool current_material_has_alpha = false;
+
+        // Vertices in execute buffers translated earlier in the frame. Offsets triangle source
+        // vertices so that they are unique within the frame.
+        uint32_t vertex_base = 0U;
+
+        void update_current_batch();
+
+    public:
+        execute_buffer_translator(execute_buffer_materials *materials,
+                                  game_triangle_batches const &batches);
+
+        // Maps pretransformed vertices from screen space into the internal render target.
+        // Throws std::runtime_error if the buffer refers past its own end.
+        void translate(span<d3d::tl_vertex const> vertices,
+                       span<char const> commands,
+                       size<2, float> const &scr_scale,
+                       direction<2, float> const &scr_offset);
+
+        void reset();
+    };
+}
@@ -0,0 +1,49 @@
+#include "frame_pacing.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        constexpr int frames_per_stats_window = 600;
+    }
+}
+
+void jkgm::frame_pacing_accumulator::add_frame(double frame_time)
+{
+    if(num_frames == 0) {
+        min_frame_time = frame_time;
+        max_frame_time = frame_time;
+    }
+    else {
+        min_frame_time = std::min(min_frame_time, frame_time);
+        max_frame_time = std::max(max_frame_time, frame_time);
+    }
+
+    // Running mean and squared deviation. Frame times vary little around a large mean, which
+    // a plain sum of squares would lose to cancellation.
+    ++num_frames;
+    double delta = frame_time - mean;
+    mean += delta / static_cast<double>(num_frames);
+    sum_sq_deviation += delta * (frame_time - mean);
+}
+
+std::optional<jkgm::frame_pacing_stats> jkgm::frame_pacing_accumulator::take_stats()
+{
+    if(num_frames < frames_per_stats_window) {
+        return std::nullopt;
+    }
+
+    frame_pacing_stats rv;
+    rv.num_frames = num_frames;
+    rv.mean_frame_time = mean;
+    rv.frame_time_stddev =
+        std::sqrt(std::max(0.0, sum_sq_deviation / static_cast<double>(num_frames)));
+    rv.min_frame_time = min_frame_time;
+    rv.max_frame_time = max_frame_time;
+
+    num_frames = 0;
+    mean = 0.0;
+    sum_sq_deviation = 0.0;
+
+    return rv;
+}
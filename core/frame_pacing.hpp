@@ -0,0 +1,31 @@
+#pragma once
+
+#include <optional>
+
+namespace jkgm {
+    // Frame pacing over a reporting window, in microseconds
+    class frame_pacing_stats {
+    public:
+        int num_frames = 0;
+        double mean_frame_time = 0.0;
+        double frame_time_stddev = 0.0;
+        double min_frame_time = 0.0;
+        double max_frame_time = 0.0;
+    };
+
+    class frame_pacing_accumulator {
+    private:
+        int num_frames = 0;
+        double mean = 0.0;
+        double sum_sq_deviation = 0.0;
+        double min_frame_time = 0.0;
+        double max_frame_time = 0.0;
+
+    public:
+        // Adds the time between two consecutive frames, in microseconds
+        void add_frame(double frame_time);
+
+        // Returns pacing statistics once a full reporting window has been measured
+        std::optional<frame_pacing_stats> take_stats();
+    };
+}
@@ -0,0 +1,107 @@
+#include "frame_statistics.hpp"
+#include "base/format.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace jkgm {
+    namespace {
+        constexpr int frames_per_summary = 600;
+
+        // Applies fn to each pair of corresponding fields
+        template <class FnT>
+        void zip_fields(frame_statistics &a, frame_statistics const &b, FnT fn)
+        {
+            fn(a.world_triangles, b.world_triangles);
+            fn(a.world_transparent_triangles, b.world_transparent_triangles);
+            fn(a.gun_triangles, b.gun_triangles);
+            fn(a.gun_transparent_triangles, b.gun_transparent_triangles);
+            fn(a.num_material_switches, b.num_material_switches);
+            fn(a.num_opaque_draw_calls, b.num_opaque_draw_calls);
+            fn(a.num_opaque_triangles_drawn, b.num_opaque_triangles_drawn);
+            fn(a.num_transparent_draw_calls, b.num_transparent_draw_calls);
+            fn(a.num_transparent_triangles_drawn, b.num_transparent_triangles_drawn);
+            fn(a.num_vertices_streamed, b.num_vertices_streamed);
+            fn(a.num_texture_uploads, b.num_texture_uploads);
+            fn(a.texture_upload_bytes, b.texture_upload_bytes);
+            fn(a.num_texture_hashes, b.num_texture_hashes);
+            fn(a.num_buffer_growths, b.num_buffer_growths);
+            fn(a.num_batch_expansions, b.num_batch_expansions);
+            fn(a.sort_time, b.sort_time);
+            fn(a.frame_time, b.frame_time);
+        }
+    }
+}
+
+void jkgm::frame_statistics_accumulator::add_frame(frame_statistics const &stats)
+{
+    zip_fields(total, stats, [](auto &a, auto const &b) { a += b; });
+    zip_fields(max, stats, [](auto &a, auto const &b) { a = std::max(a, b); });
+    ++num_frames;
+}
+
+std::optional<jkgm::frame_statistics_summary> jkgm::frame_statistics_accumulator::take_summary()
+{
+    if(num_frames < frames_per_summary) {
+        return std::nullopt;
+    }
+
+    frame_statistics_summary rv;
+    rv.num_frames = num_frames;
+    rv.mean = total;
+    rv.max = max;
+
+    zip_fields(rv.mean, total, [&](auto &a, auto const &) {
+        a /= static_cast<std::remove_reference_t<decltype(a)>>(num_frames);
+    });
+
+    num_frames = 0;
+    total = frame_statistics();
+    max = frame_statistics();
+
+    return rv;
+}
+
+std::vector<std::string> jkgm::format_frame_statistics(frame_statistics const &stats)
+{
+    size_t num_triangles = stats.world_triangles + stats.world_transparent_triangles +
+                           stats.gun_triangles + stats.gun_transparent_triangles;
+
+    return {str(format("Frame ", static_cast<int>(stats.frame_time), " us")),
+            str(format("Sort ", static_cast<int>(stats.sort_time), " us")),
+            str(format("Triangles ",
+                       num_triangles,
+                       " (world ",
+                       stats.world_triangles,
+                       "/",
+                       stats.world_transparent_triangles,
+                       ", gun ",
+                       stats.gun_triangles,
+                       "/",
+                       stats.gun_transparent_triangles,
+                       ")")),
+            str(format("Draws ",
+                       stats.num_opaque_draw_calls + stats.num_transparent_draw_calls,
+                       ", material switches ",
+                       stats.num_material_switches)),
+            str(format("Opaque pass ",
+                       stats.num_opaque_triangles_drawn,
+                       " triangles in ",
+                       stats.num_opaque_draw_calls,
+                       " draws")),
+            str(format("Transparency pass ",
+                       stats.num_transparent_triangles_drawn,
+                       " triangles in ",
+                       stats.num_transparent_draw_calls,
+                       " draws")),
+            str(format("Vertices streamed ", stats.num_vertices_streamed)),
+            str(format("Texture uploads ",
+                       stats.num_texture_uploads,
+                       " (",
+                       stats.texture_upload_bytes / 1024U,
+                       " KB), hashes ",
+                       stats.num_texture_hashes)),
+            str(format("Buffer growths ",
+                       stats.num_buffer_growths,
+                       ", batch expansions ",
+                       stats.num_batch_expansions))};
+}
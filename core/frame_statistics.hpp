@@ -0,0 +1,53 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    // Renderer work for a single frame. Times are in microseconds.
+    class frame_statistics {
+    public:
+        size_t world_triangles = 0U;
+        size_t world_transparent_triangles = 0U;
+        size_t gun_triangles = 0U;
+        size_t gun_transparent_triangles = 0U;
+        size_t num_material_switches = 0U;
+        size_t num_opaque_draw_calls = 0U;
+        size_t num_opaque_triangles_drawn = 0U;
+        size_t num_transparent_draw_calls = 0U;
+        size_t num_transparent_triangles_drawn = 0U;
+        size_t num_vertices_streamed = 0U;
+        size_t num_texture_uploads = 0U;
+        size_t texture_upload_bytes = 0U;
+        size_t num_texture_hashes = 0U;
+        size_t num_buffer_growths = 0U;
+        size_t num_batch_expansions = 0U;
+        double sort_time = 0.0;
+        double frame_time = 0.0;
+    };
+
+    // Frame statistics over a reporting window
+    class frame_statistics_summary {
+    public:
+        int num_frames = 0;
+        frame_statistics mean;
+        frame_statistics max;
+    };
+
+    class frame_statistics_accumulator {
+    private:
+        int num_frames = 0;
+        frame_statistics total;
+        frame_statistics max;
+
+    public:
+        void add_frame(frame_statistics const &stats);
+
+        // Returns a summary once a full reporting window has been measured
+        std::optional<frame_statistics_summary> take_summary();
+    };
+
+    // Formats statistics as short lines for the on-screen overlay
+    std::vector<std::string> format_frame_statistics(frame_statistics const &stats);
+}
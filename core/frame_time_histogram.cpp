@@ -0,0 +1,139 @@
+#include "frame_time_histogram.hpp"
+#include "base/log.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        constexpr double bucket_width = 100.0;
+        constexpr size_t num_buckets = 5000U;
+
+        // Later hitches are counted but not annotated
+        constexpr size_t max_recorded_hitches = 64U;
+    }
+}
+
+jkgm::frame_time_histogram::frame_time_histogram(double hitch_threshold)
+    : hitch_threshold(hitch_threshold)
+    , buckets(num_buckets + 1U, 0U)
+{
+}
+
+void jkgm::frame_time_histogram::add_frame(size_t frame_index, frame_statistics const &stats)
+{
+    auto bucket = static_cast<size_t>(std::max(0.0, stats.frame_time) / bucket_width);
+    ++buckets[std::min(bucket, num_buckets)];
+
+    ++num_frames;
+    total_frame_time += stats.frame_time;
+    max_frame_time = std::max(max_frame_time, stats.frame_time);
+
+    if(stats.frame_time >= hitch_threshold) {
+        if(hitches.size() < max_recorded_hitches) {
+            hitches.push_back(frame_hitch{frame_index, stats});
+        }
+        else {
+            ++num_unrecorded_hitches;
+        }
+    }
+}
+
+void jkgm::frame_time_histogram::reset()
+{
+    std::fill(buckets.begin(), buckets.end(), 0U);
+    num_frames = 0U;
+    total_frame_time = 0.0;
+    max_frame_time = 0.0;
+    hitches.clear();
+    num_unrecorded_hitches = 0U;
+}
+
+size_t jkgm::frame_time_histogram::get_num_frames() const
+{
+    return num_frames;
+}
+
+double jkgm::frame_time_histogram::get_percentile(double fraction) const
+{
+    if(num_frames == 0U) {
+        return 0.0;
+    }
+
+    auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(num_frames)));
+    rank = std::max<size_t>(1U, std::min(rank, num_frames));
+
+    size_t seen = 0U;
+    for(size_t i = 0; i < num_buckets; ++i) {
+        seen += buckets[i];
+        if(seen >= rank) {
+            // Report the upper edge of the bucket, but never more than was actually observed
+            return std::min(static_cast<double>(i + 1U) * bucket_width, max_frame_time);
+        }
+    }
+
+    return max_frame_time;
+}
+
+std::vector<jkgm::frame_hitch> const &jkgm::frame_time_histogram::get_hitches() const
+{
+    return hitches;
+}
+
+size_t jkgm::frame_time_histogram::get_num_unrecorded_hitches() const
+{
+    return num_unrecorded_hitches;
+}
+
+void jkgm::frame_time_histogram::log_report(std::string_view reason) const
+{
+    if(num_frames == 0U) {
+        return;
+    }
+
+    LOG_INFO("Frame times at ",
+             reason,
+             " over ",
+             num_frames,
+             " frames: mean ",
+             static_cast<int>(total_frame_time / static_cast<double>(num_frames)),
+             " us, 50th ",
+             static_cast<int>(get_percentile(0.5)),
+             " us, 95th ",
+             static_cast<int>(get_percentile(0.95)),
+             " us, 99th ",
+             static_cast<int>(get_percentile(0.99)),
+             " us, 99.9th ",
+             static_cast<int>(get_percentile(0.999)),
+             " us, max ",
+             static_cast<int>(max_frame_time),
+             " us");
+
+    LOG_INFO(hitches.size() + num_unrecorded_hitches,
+             " hitches of at least ",
+             static_cast<int>(hitch_threshold),
+             " us");
+
+    for(auto const &hitch : hitches) {
+        auto const &em = hitch.stats;
+        LOG_INFO("Hitch at frame ",
+                 hitch.frame_index,
+                 ": ",
+                 static_cast<int>(em.frame_time),
+                 " us. Sort ",
+                 static_cast<int>(em.sort_time),
+                 " us, texture uploads ",
+                 em.num_texture_uploads,
+                 " (",
+                 em.texture_upload_bytes,
+                 " bytes), texture hashes ",
+                 em.num_texture_hashes,
+                 ", buffer growths ",
+                 em.num_buffer_growths,
+                 ", batch expansions ",
+                 em.num_batch_expansions);
+    }
+
+    if(num_unrecorded_hitches > 0U) {
+        LOG_INFO(num_unrecorded_hitches, " more hitches were not recorded");
+    }
+}
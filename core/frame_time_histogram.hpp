@@ -0,0 +1,46 @@
+#pragma once
+
+#include "frame_statistics.hpp"
+#include <string_view>
+#include <vector>
+
+namespace jkgm {
+    // A frame that took longer than the hitch threshold, with the work done in that frame
+    class frame_hitch {
+    public:
+        size_t frame_index = 0U;
+        frame_statistics stats;
+    };
+
+    // Distribution of frame times, in microseconds. Buckets are 100 us wide up to half a second.
+    // Longer frames share an overflow bucket, so percentiles above that are clamped.
+    class frame_time_histogram {
+    private:
+        double hitch_threshold;
+        std::vector<size_t> buckets;
+        size_t num_frames = 0U;
+        double total_frame_time = 0.0;
+        double max_frame_time = 0.0;
+        std::vector<frame_hitch> hitches;
+        size_t num_unrecorded_hitches = 0U;
+
+    public:
+        explicit frame_time_histogram(double hitch_threshold);
+
+        void add_frame(size_t frame_index, frame_statistics const &stats);
+        void reset();
+
+        size_t get_num_frames() const;
+
+        // Returns the frame time at or below which the given fraction of frames fall
+        double get_percentile(double fraction) const;
+
+        std::vector<frame_hitch> const &get_hitches() const;
+
+        // Hitches beyond the recorded ones, which are counted but not annotated
+        size_t get_num_unrecorded_hitches() const;
+
+        // Writes percentiles and hitches to the log
+        void log_report(std::string_view reason) const;
+    };
+}
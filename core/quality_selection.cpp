@@ -0,0 +1,76 @@
+#include "quality_selection.hpp"
+#include <algorithm>
+
+namespace jkgm {
+    namespace {
+        // Part of the target is reserved for the HUD, presentation and other unmeasured work
+        constexpr double frame_time_budget_fraction = 0.8;
+
+        constexpr float render_scale_step = 0.05f;
+
+        // Reducing the resolution of a tier below this scale loses more than dropping an option
+        constexpr float min_tier_render_scale = 0.75f;
+
+        struct quality_tier {
+            bool enable_bloom;
+            bool enable_ssao;
+            float max_anisotropy;
+            float min_render_scale;
+        };
+    }
+}
+
+jkgm::quality_settings jkgm::choose_quality_settings(quality_pass_times const &times,
+                                                     float min_render_scale,
+                                                     double target_frame_time)
+{
+    // Drop the more expensive effect first
+    bool drop_ssao_first = times.ssao >= times.bloom;
+    float tier_min_scale = std::max(min_tier_render_scale, min_render_scale);
+    quality_tier const tiers[] = {
+        {/*bloom*/ true, /*ssao*/ true, /*anisotropy*/ 16.0f, tier_min_scale},
+        {/*bloom*/ drop_ssao_first, /*ssao*/ !drop_ssao_first, /*anisotropy*/ 8.0f, tier_min_scale},
+        {/*bloom*/ false, /*ssao*/ false, /*anisotropy*/ 4.0f, min_render_scale}};
+
+    double budget = target_frame_time * frame_time_budget_fraction;
+
+    quality_settings rv;
+    rv.enable_parallax = true;
+
+    for(auto const &tier : tiers) {
+        for(int step = 0;; ++step) {
+            float scale = 1.0f - render_scale_step * static_cast<float>(step);
+            if(scale < tier.min_render_scale - 0.001f) {
+                break;
+            }
+
+            // Scene passes are fill bound and scale with pixel count. Bloom runs at the output
+            // resolution.
+            double scene_time = times.geometry + times.transparency;
+            if(tier.enable_ssao) {
+                scene_time += times.ssao;
+            }
+
+            double estimate = scene_time * static_cast<double>(scale * scale);
+            if(tier.enable_bloom) {
+                estimate += times.bloom;
+            }
+
+            if(estimate <= budget) {
+                rv.max_anisotropy = tier.max_anisotropy;
+                rv.enable_bloom = tier.enable_bloom;
+                rv.enable_ssao = tier.enable_ssao;
+                rv.render_scale = scale;
+                return rv;
+            }
+        }
+    }
+
+    // Nothing fits. Use the cheapest settings available.
+    rv.max_anisotropy = 1.0f;
+    rv.enable_bloom = false;
+    rv.enable_ssao = false;
+    rv.enable_parallax = false;
+    rv.render_scale = min_render_scale;
+    return rv;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common/quality_profile.hpp"
+
+namespace jkgm {
+    // Average GPU time of each benchmarked pass in milliseconds, measured at full render scale
+    // with every option enabled
+    class quality_pass_times {
+    public:
+        double geometry = 0.0;
+        double ssao = 0.0;
+        double transparency = 0.0;
+        double bloom = 0.0;
+    };
+
+    // Picks the richest settings whose estimated cost fits the frame-time target. Parallax is not
+    // measured on its own: its cost is part of the geometry and transparency passes, so it stays
+    // enabled unless even the cheapest settings miss the target.
+    quality_settings choose_quality_settings(quality_pass_times const &times,
+                                             float min_render_scale,
+                                             double target_frame_time);
+}
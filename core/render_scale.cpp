@@ -0,0 +1,86 @@
+#include "render_scale.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        // The scale changes in discrete steps. Each change reallocates the scene targets.
+        constexpr float scale_step = 0.05f;
+
+        // Frames to wait after a change. Timer results lag several frames behind submission.
+        constexpr int change_cooldown_frames = 30;
+
+        // Frame time is allowed to drift this far below the target before the scale grows
+        constexpr double headroom = 0.85;
+
+        constexpr double smoothing = 0.1;
+    }
+}
+
+jkgm::render_scale_controller::render_scale_controller(float min_scale,
+                                                       float max_scale,
+                                                       double target_frame_time)
+    : min_scale(std::min(min_scale, max_scale))
+    , max_scale(max_scale)
+    , target_frame_time(target_frame_time)
+    , scale(max_scale)
+{
+}
+
+float jkgm::render_scale_controller::get_scale() const
+{
+    return scale;
+}
+
+void jkgm::render_scale_controller::add_frame_time(double frame_time)
+{
+    if(has_frame_time) {
+        smoothed_frame_time += (frame_time - smoothed_frame_time) * smoothing;
+    }
+    else {
+        smoothed_frame_time = frame_time;
+        has_frame_time = true;
+    }
+
+    if(cooldown_frames > 0) {
+        --cooldown_frames;
+        return;
+    }
+
+    bool over_budget = smoothed_frame_time > target_frame_time;
+    bool under_budget = smoothed_frame_time < (target_frame_time * headroom);
+    if(!over_budget && !under_budget) {
+        return;
+    }
+
+    // Pixel count scales with the square of the render scale
+    auto ideal = scale * static_cast<float>(
+                             std::sqrt(target_frame_time / std::max(smoothed_frame_time, 0.001)));
+    auto next = std::round(ideal / scale_step) * scale_step;
+
+    // Always move at least one step in the needed direction
+    if(over_budget) {
+        next = std::min(next, scale - scale_step);
+    }
+    else {
+        next = std::max(next, scale + scale_step);
+    }
+
+    next = std::clamp(next, min_scale, max_scale);
+
+    if(next == scale) {
+        return;
+    }
+
+    scale = next;
+    cooldown_frames = change_cooldown_frames;
+
+    // Discard history measured at the previous scale
+    has_frame_time = false;
+}
+
+jkgm::size<2, int> jkgm::get_scaled_resolution(size<2, int> res, float scale)
+{
+    return make_size(std::max(1, static_cast<int>(std::lround(get<x>(res) * scale))),
+                     std::max(1, static_cast<int>(std::lround(get<y>(res) * scale))));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "math/size.hpp"
+
+namespace jkgm {
+    // Adjusts the 3D render scale to keep GPU frame time near a target. GPU time is assumed to
+    // be proportional to the number of pixels rendered.
+    class render_scale_controller {
+    private:
+        float min_scale;
+        float max_scale;
+        double target_frame_time;
+
+        float scale;
+        double smoothed_frame_time = 0.0;
+        bool has_frame_time = false;
+        int cooldown_frames = 0;
+
+    public:
+        render_scale_controller(float min_scale, float max_scale, double target_frame_time);
+
+        float get_scale() const;
+
+        // Reports the GPU time of one frame, in milliseconds
+        void add_frame_time(double frame_time);
+    };
+
+    // Returns the scaled resolution, clamped to at least one pixel
+    size<2, int> get_scaled_resolution(size<2, int> res, float scale);
+}
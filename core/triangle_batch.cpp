@@ -0,0 +1,1033 @@
+#include "triangle_batch.hpp"
+#include "base/hash_combine.hpp"
+#include "base/log.hpp"
+#include "base/trace.hpp"
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+// SSE2 is part of x86-64, and 32-bit MSVC enables it by default
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#else
+#error "The transparency sorter requires SSE2"
+#endif
+
+jkgm::triangle_vertex::triangle_vertex()
+    : pos(point<4, float>::zero())
+    , texcoords(point<2, float>::zero())
+    , color(color_rgba8::zero())
+{
+}
+
+jkgm::triangle_vertex::triangle_vertex(point<4, float> pos,
+                                       point<2, float> texcoords,
+                                       color_rgba8 color)
+    : pos(pos)
+    , texcoords(texcoords)
+    , color(color)
+{
+}
+
+jkgm::triangle::triangle() = default;
+
+jkgm::triangle::triangle(triangle_vertex v0,
+                         triangle_vertex v1,
+                         triangle_vertex v2,
+                         material_instance_id material,
+                         size_t shader_variant,
+                         bool alpha_test)
+    : v0(v0)
+    , v1(v1)
+    , v2(v2)
+    , material(material)
+    , shader_variant(shader_variant)
+    , alpha_test(alpha_test)
+{
+}
+
+jkgm::triangle_batch::triangle_batch()
+{
+    expand();
+}
+
+void jkgm::triangle_batch::expand()
+{
+    buffer.resize(buffer.size() + 10000U);
+}
+
+size_t jkgm::triangle_batch::size() const
+{
+    return num_triangles;
+}
+
+size_t jkgm::triangle_batch::capacity() const
+{
+    return buffer.size();
+}
+
+void jkgm::triangle_batch::clear()
+{
+    num_triangles = 0U;
+}
+
+void jkgm::triangle_batch::insert(triangle const &tri)
+{
+    if(num_triangles == buffer.size()) {
+        expand();
+        ++num_expansions;
+    }
+
+    buffer[num_triangles++] = tri;
+}
+
+size_t jkgm::triangle_batch::take_num_expansions()
+{
+    return std::exchange(num_expansions, 0U);
+}
+
+namespace jkgm {
+    namespace {
+        float nearest_depth(triangle const &tri)
+        {
+            return std::min(get<w>(tri.v0.pos), std::min(get<w>(tri.v1.pos), get<w>(tri.v2.pos)));
+        }
+    }
+}
+
+void jkgm::triangle_batch::sort()
+{
+    TRACE_SCOPE("triangle_batch::sort");
+
+    // Group into material runs, with each run ordered front to back
+    std::sort(begin(), end(), [](auto const &a, auto const &b) {
+        if(a.alpha_test != b.alpha_test) {
+            return b.alpha_test;
+        }
+
+        if(a.shader_variant != b.shader_variant) {
+            return a.shader_variant < b.shader_variant;
+        }
+
+        if(a.material != b.material) {
+            return a.material.get() < b.material.get();
+        }
+
+        return nearest_depth(a) < nearest_depth(b);
+    });
+
+    runs.clear();
+    for(size_t first = 0U; first < num_triangles;) {
+        auto const &tri = buffer[first];
+
+        size_t last = first + 1U;
+        while(last < num_triangles && buffer[last].alpha_test == tri.alpha_test &&
+              buffer[last].shader_variant == tri.shader_variant &&
+              buffer[last].material == tri.material) {
+            ++last;
+        }
+
+        runs.push_back(material_run{tri.alpha_test, nearest_depth(tri), first, last});
+        first = last;
+    }
+
+    // Draw runs roughly front to back so that early depth testing rejects occluded pixels of
+    // later runs. Alpha tested runs go last because discard prevents early depth testing.
+    std::sort(runs.begin(), runs.end(), [](auto const &a, auto const &b) {
+        if(a.alpha_test != b.alpha_test) {
+            return b.alpha_test;
+        }
+
+        return a.depth < b.depth;
+    });
+
+    sorted_buffer.resize(buffer.size());
+    auto out = sorted_buffer.begin();
+    for(auto const &run : runs) {
+        out = std::copy(buffer.begin() + run.first, buffer.begin() + run.last, out);
+    }
+
+    std::swap(buffer, sorted_buffer);
+}
+
+namespace jkgm {
+    namespace {
+        constexpr float dist_threshold = 0.001f;
+
+        // Ranges smaller than this are partitioned on the calling thread
+        constexpr size_t min_parallel_partition = 512U;
+
+        // Triangles per bucketed sorter fix-up. Fix-up cost is quadratic in this size, and it
+        // must not exceed the width of the predecessor masks.
+        constexpr size_t bucket_size = 16U;
+
+        // Bucketed sorter fix-ups per task
+        constexpr size_t buckets_per_task = 64U;
+
+        // Last frame's order is reused only if at least this fraction of triangles persist
+        constexpr float min_temporal_match_fraction = 0.9f;
+
+        // The repaired order is rejected if more than 1/max_temporal_repair_divisor of the
+        // triangles are out of order.
+        constexpr size_t max_temporal_repair_divisor = 8U;
+
+        constexpr size_t no_rank_slot = std::numeric_limits<size_t>::max();
+
+        // Keeps screen bounds finite for vertices at or behind the eye
+        constexpr float min_projected_depth = 1.0e-6f;
+
+        // Temporal repair finds overlapping triangles by binning them into this many cells along
+        // each axis of the screen
+        constexpr size_t repair_grid_size = 32U;
+
+        // Temporal repair compares each triangle with this many triangles drawn just before it in
+        // each cell, in addition to the nearest one
+        constexpr size_t repair_window_size = 8U;
+
+        // Reinsertion compares at most this many pairs per triangle in the batch before giving up
+        // and sorting from scratch
+        constexpr size_t max_repair_comparisons_per_triangle = 32U;
+
+        struct partition_context {
+            triangle_positions const *pos;
+            job_system *jobs;
+        };
+
+        using partition_function = void (*)(partition_context const &,
+                                             triangle_sort_entry *,
+                                             triangle_sort_entry *);
+
+        struct partition_range {
+            partition_function fn;
+            triangle_sort_entry *first;
+            triangle_sort_entry *last;
+        };
+
+        plane make_plane(point<3, float> const &origin, direction<3, float> const &n)
+        {
+            return plane{get<x>(n), get<y>(n), get<z>(n), dot(origin - point<3, float>::zero(), n)};
+        }
+
+        inline float evaluate_plane(plane const &p, point<3, float> const &v)
+        {
+            return get<x>(v) * p.nx + get<y>(v) * p.ny + get<z>(v) * p.nz - p.d;
+        }
+
+        inline __m128 evaluate_plane(plane const &p, __m128 vx, __m128 vy, __m128 vw)
+        {
+            auto rv = _mm_mul_ps(vx, _mm_set1_ps(p.nx));
+            rv = _mm_add_ps(rv, _mm_mul_ps(vy, _mm_set1_ps(p.ny)));
+            rv = _mm_add_ps(rv, _mm_mul_ps(vw, _mm_set1_ps(p.nz)));
+            return _mm_sub_ps(rv, _mm_set1_ps(p.d));
+        }
+
+        inline __m128 gather(std::vector<float> const &v, uint32_t const *idx)
+        {
+            return _mm_set_ps(v[idx[3]], v[idx[2]], v[idx[1]], v[idx[0]]);
+        }
+
+        // Classifies four triangles per step. fn receives the triangle indices and returns lane
+        // masks of triangles assigned to the first and last partitions; other triangles are
+        // ambiguous. Short final steps repeat the last index and discard the extra lanes.
+        template <class FnT>
+        void classify(triangle_sort_entry *first, triangle_sort_entry *last, FnT fn)
+        {
+            for(auto *it = first; it < last; it += 4) {
+                auto num_lanes = std::min<ptrdiff_t>(4, last - it);
+
+                uint32_t idx[4];
+                for(ptrdiff_t i = 0; i < 4; ++i) {
+                    idx[i] = it[std::min(i, num_lanes - 1)].index;
+                }
+
+                int first_mask = 0;
+                int last_mask = 0;
+                fn(idx, &first_mask, &last_mask);
+
+                for(ptrdiff_t i = 0; i < num_lanes; ++i) {
+                    if(first_mask & (1 << i)) {
+                        it[i].side = -1;
+                    }
+                    else if(last_mask & (1 << i)) {
+                        it[i].side = 1;
+                    }
+                    else {
+                        it[i].side = 0;
+                    }
+                }
+            }
+        }
+
+        std::tuple<triangle_sort_entry *, triangle_sort_entry *>
+            three_way_partition(triangle_sort_entry *first, triangle_sort_entry *last)
+        {
+            auto *split_it =
+                std::partition(first, last, [](auto const &em) { return em.side < 0; });
+            auto *split_jt =
+                std::partition(split_it, last, [](auto const &em) { return em.side == 0; });
+            return std::make_tuple(split_it, split_jt);
+        }
+
+        void run_partitions(partition_context const &ctx,
+                            std::initializer_list<partition_range> ranges)
+        {
+            // Partitions are disjoint and independent. Large partitions run as tasks while the
+            // calling thread processes the rest.
+            std::vector<task> tasks;
+            for(auto const &r : ranges) {
+                if(ctx.jobs && (r.last - r.first) >= (ptrdiff_t)min_parallel_partition) {
+                    tasks.push_back(ctx.jobs->submit([&ctx, r] { r.fn(ctx, r.first, r.last); }));
+                }
+                else {
+                    r.fn(ctx, r.first, r.last);
+                }
+            }
+
+            if(!tasks.empty()) {
+                ctx.jobs->wait(tasks);
+            }
+        }
+
+        void do_partition(partition_context const &ctx,
+                          triangle_sort_entry *it_begin,
+                          triangle_sort_entry *it_end);
+        void do_mid_partition(partition_context const &ctx,
+                              triangle_sort_entry *it_begin,
+                              triangle_sort_entry *it_end);
+        void do_fast_partition(partition_context const &ctx,
+                               triangle_sort_entry *it_begin,
+                               triangle_sort_entry *it_end);
+
+        point<3, float> get_vertex(triangle_positions const &pos, size_t tri, size_t vx)
+        {
+            return make_point(pos.x[vx][tri], pos.y[vx][tri], pos.w[vx][tri]);
+        }
+
+        direction<3, float> get_normal(triangle_positions const &pos, size_t tri)
+        {
+            return make_direction(pos.nx[tri], pos.ny[tri], pos.nz[tri]);
+        }
+
+        triangle_planes make_triangle_planes(triangle_positions const &pos, size_t tri)
+        {
+            auto v0 = get_vertex(pos, tri, 0);
+            auto v1 = get_vertex(pos, tri, 1);
+            auto v2 = get_vertex(pos, tri, 2);
+            auto normal = get_normal(pos, tri);
+
+            return triangle_planes{make_plane(v0, normalize(cross(v1 - v0, normal))),
+                                   make_plane(v1, normalize(cross(v2 - v1, normal))),
+                                   make_plane(v2, normalize(cross(v0 - v2, normal))),
+                                   make_plane(v0, normal)};
+        }
+
+        void do_partition(partition_context const &ctx,
+                          triangle_sort_entry *it_begin,
+                          triangle_sort_entry *it_end)
+        {
+            if(it_begin == it_end) {
+                return;
+            }
+
+            auto const &pos = *ctx.pos;
+
+            // Separate triangles into occluded-by, ambiguous, and occludes
+            auto a_planes = make_triangle_planes(pos, it_begin->index);
+            auto const &a_v0v1 = a_planes.v0v1;
+            auto const &a_v1v2 = a_planes.v1v2;
+            auto const &a_v2v0 = a_planes.v2v0;
+            auto const &a_face = a_planes.face;
+
+            it_begin->side = 0;
+
+            auto zero = _mm_setzero_ps();
+            auto near_threshold = _mm_set1_ps(-dist_threshold);
+            auto far_threshold = _mm_set1_ps(dist_threshold);
+
+            classify(it_begin + 1, it_end, [&](uint32_t const *idx, int *first, int *last) {
+                auto blocks_in_front = zero;
+                auto blocks_behind = zero;
+
+                for(size_t v = 0; v < 3; ++v) {
+                    auto bx = gather(pos.x[v], idx);
+                    auto by = gather(pos.y[v], idx);
+                    auto bw = gather(pos.w[v], idx);
+
+                    auto inside =
+                        _mm_and_ps(_mm_cmpgt_ps(evaluate_plane(a_v0v1, bx, by, bw), zero),
+                                   _mm_cmpgt_ps(evaluate_plane(a_v1v2, bx, by, bw), zero));
+                    inside = _mm_and_ps(inside,
+                                        _mm_cmpgt_ps(evaluate_plane(a_v2v0, bx, by, bw), zero));
+
+                    auto dist = evaluate_plane(a_face, bx, by, bw);
+
+                    blocks_in_front = _mm_or_ps(
+                        blocks_in_front, _mm_and_ps(inside, _mm_cmpgt_ps(dist, near_threshold)));
+                    blocks_behind = _mm_or_ps(
+                        blocks_behind, _mm_and_ps(inside, _mm_cmplt_ps(dist, far_threshold)));
+                }
+
+                // In front takes precedence over behind
+                *first = ~_mm_movemask_ps(blocks_in_front) & 0xF;
+                *last = ~_mm_movemask_ps(blocks_behind) & 0xF;
+            });
+
+            // Process each partition in order
+            auto [split_it, split_jt] = three_way_partition(it_begin, it_end);
+
+            int segs_remaining = ((it_begin != split_it) ? 1 : 0) +
+                                 ((split_it != split_jt) ? 1 : 0) + ((split_jt != it_end) ? 1 : 0);
+
+            if(segs_remaining <= 1) {
+                // All remaining triangles are ambiguous with this pivot.
+                do_partition(ctx, it_begin + 1, it_end);
+                return;
+            }
+
+            run_partitions(ctx,
+                           {{&do_partition, it_begin, split_it},
+                            {&do_partition, split_it, split_jt},
+                            {&do_partition, split_jt, it_end}});
+        }
+
+        void do_mid_partition(partition_context const &ctx,
+                              triangle_sort_entry *it_begin,
+                              triangle_sort_entry *it_end)
+        {
+            if(it_begin == it_end) {
+                return;
+            }
+
+            auto const &pos = *ctx.pos;
+
+            // Partition triangles by a triangle
+            auto a = it_begin->index;
+            auto a_face = make_plane(get_vertex(pos, a, 0), get_normal(pos, a));
+
+            it_begin->side = 0;
+
+            auto near_threshold = _mm_set1_ps(-dist_threshold);
+            auto far_threshold = _mm_set1_ps(dist_threshold);
+
+            classify(it_begin + 1, it_end, [&](uint32_t const *idx, int *first, int *last) {
+                auto in_front = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                auto behind = in_front;
+
+                for(size_t v = 0; v < 3; ++v) {
+                    auto dist = evaluate_plane(a_face,
+                                               gather(pos.x[v], idx),
+                                               gather(pos.y[v], idx),
+                                               gather(pos.w[v], idx));
+
+                    in_front = _mm_and_ps(in_front, _mm_cmpgt_ps(dist, near_threshold));
+                    behind = _mm_and_ps(behind, _mm_cmplt_ps(dist, far_threshold));
+                }
+
+                // In front takes precedence over behind
+                auto in_front_mask = _mm_movemask_ps(in_front);
+                *first = _mm_movemask_ps(behind) & ~in_front_mask;
+                *last = in_front_mask;
+            });
+
+            // Process each partition in order
+            auto [split_it, split_jt] = three_way_partition(it_begin, it_end);
+
+            int segs_remaining = ((it_begin != split_it) ? 1 : 0) +
+                                 ((split_it != split_jt) ? 1 : 0) + ((split_jt != it_end) ? 1 : 0);
+
+            if(segs_remaining <= 1) {
+                // All remaining triangles are ambiguous with this pivot.
+                do_partition(ctx, it_begin, it_end);
+                return;
+            }
+
+            run_partitions(ctx,
+                           {{&do_mid_partition, it_begin, split_it},
+                            {&do_partition, split_it, split_jt},
+                            {&do_mid_partition, split_jt, it_end}});
+        }
+
+        void do_fast_partition(partition_context const &ctx,
+                               triangle_sort_entry *it_begin,
+                               triangle_sort_entry *it_end)
+        {
+            if(it_begin == it_end) {
+                return;
+            }
+
+            auto const &pos = *ctx.pos;
+
+            // Partition triangles by the midpoint of the space.
+            // Note that the eye space depth coordinate is stored in W, not in Z.
+            auto space_start = _mm_set1_ps(std::numeric_limits<float>::max());
+            auto space_end = _mm_set1_ps(std::numeric_limits<float>::lowest());
+            for(auto *it = it_begin; it < it_end; it += 4) {
+                auto num_lanes = std::min<ptrdiff_t>(4, it_end - it);
+
+                uint32_t idx[4];
+                for(ptrdiff_t i = 0; i < 4; ++i) {
+                    idx[i] = it[std::min(i, num_lanes - 1)].index;
+                }
+
+                for(size_t v = 0; v < 3; ++v) {
+                    auto z = gather(pos.w[v], idx);
+                    space_start = _mm_min_ps(space_start, z);
+                    space_end = _mm_max_ps(space_end, z);
+                }
+            }
+
+            float start_lanes[4];
+            float end_lanes[4];
+            _mm_storeu_ps(start_lanes, space_start);
+            _mm_storeu_ps(end_lanes, space_end);
+
+            float space_midpoint = (*std::min_element(start_lanes, start_lanes + 4) +
+                                    *std::max_element(end_lanes, end_lanes + 4)) *
+                                   0.5f;
+            auto space_midpoint_near = _mm_set1_ps(space_midpoint + dist_threshold);
+            auto space_midpoint_far = _mm_set1_ps(space_midpoint - dist_threshold);
+
+            classify(it_begin, it_end, [&](uint32_t const *idx, int *first, int *last) {
+                auto is_near = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                auto is_far = is_near;
+
+                for(size_t v = 0; v < 3; ++v) {
+                    auto z = gather(pos.w[v], idx);
+                    is_near = _mm_and_ps(is_near, _mm_cmpgt_ps(z, space_midpoint_far));
+                    is_far = _mm_and_ps(is_far, _mm_cmplt_ps(z, space_midpoint_near));
+                }
+
+                // Triangles that straddle the threshold band are ambiguous
+                auto near_mask = _mm_movemask_ps(is_near);
+                auto far_mask = _mm_movemask_ps(is_far);
+                *first = near_mask & ~far_mask;
+                *last = far_mask & ~near_mask;
+            });
+
+            auto [split_it, split_jt] = three_way_partition(it_begin, it_end);
+
+            int segs_remaining = ((it_begin != split_it) ? 1 : 0) +
+                                 ((split_it != split_jt) ? 1 : 0) + ((split_jt != it_end) ? 1 : 0);
+
+            if(segs_remaining <= 1) {
+                // Remaining triangles can't be separated this way
+                do_mid_partition(ctx, it_begin, it_end);
+                return;
+            }
+
+            run_partitions(ctx,
+                           {{&do_fast_partition, it_begin, split_it},
+                            {&do_mid_partition, split_it, split_jt},
+                            {&do_fast_partition, split_jt, it_end}});
+        }
+
+        // Returns 1 if a vertex of b lies over a and in front of it, -1 if a vertex lies over a
+        // and behind it, or 0 if the triangles do not overlap or the result is inconsistent.
+        int compare_overlap(triangle_planes const &a, triangle_positions const &pos, size_t b)
+        {
+            bool in_front = false;
+            bool behind = false;
+
+            for(size_t v = 0; v < 3; ++v) {
+                auto pt = get_vertex(pos, b, v);
+                if(evaluate_plane(a.v0v1, pt) > 0.0f && evaluate_plane(a.v1v2, pt) > 0.0f &&
+                   evaluate_plane(a.v2v0, pt) > 0.0f) {
+                    auto dist = evaluate_plane(a.face, pt);
+                    in_front = in_front || (dist > dist_threshold);
+                    behind = behind || (dist < -dist_threshold);
+                }
+            }
+
+            if(in_front == behind) {
+                return 0;
+            }
+
+            return in_front ? 1 : -1;
+        }
+
+        size_t get_grid_cell(float ndc)
+        {
+            float cell = (ndc * 0.5f + 0.5f) * static_cast<float>(repair_grid_size);
+            cell = std::max(0.0f, std::min(cell, static_cast<float>(repair_grid_size - 1U)));
+            return static_cast<size_t>(cell);
+        }
+
+        void set_grid_cells(triangle_screen_bounds *bounds)
+        {
+            bounds->min_cell_x = static_cast<uint16_t>(get_grid_cell(bounds->min_x));
+            bounds->max_cell_x = static_cast<uint16_t>(get_grid_cell(bounds->max_x));
+            bounds->min_cell_y = static_cast<uint16_t>(get_grid_cell(bounds->min_y));
+            bounds->max_cell_y = static_cast<uint16_t>(get_grid_cell(bounds->max_y));
+        }
+
+        // Returns -1 if triangle a must be drawn before b, 1 if b must be drawn before a, or 0 if
+        // either order is acceptable or the overlap tests disagree.
+        int compare_draw_order(std::vector<triangle_planes> const &planes,
+                               triangle_positions const &pos,
+                               size_t a,
+                               size_t b)
+        {
+            auto b_over_a = compare_overlap(planes[a], pos, b);
+            auto a_over_b = compare_overlap(planes[b], pos, a);
+            bool a_first = (b_over_a > 0 || a_over_b < 0);
+            bool b_first = (b_over_a < 0 || a_over_b > 0);
+            if(a_first == b_first) {
+                return 0;
+            }
+
+            return a_first ? -1 : 1;
+        }
+
+        // Reorders a run of depth-sorted triangles so that each triangle is drawn after every
+        // triangle it overlaps from in front. Cycles are broken in depth order.
+        void fix_up_bucket(triangle_positions const &pos,
+                           triangle_sort_entry *first,
+                           triangle_sort_entry *last)
+        {
+            size_t num_tris = static_cast<size_t>(last - first);
+
+            std::array<triangle_planes, bucket_size> planes;
+            for(size_t i = 0; i < num_tris; ++i) {
+                planes[i] = make_triangle_planes(pos, first[i].index);
+            }
+
+            // Bit j of preds[i] is set when triangle j must be drawn before triangle i
+            std::array<uint32_t, bucket_size> preds = {};
+            for(size_t i = 0; i < num_tris; ++i) {
+                for(size_t j = i + 1; j < num_tris; ++j) {
+                    auto j_over_i = compare_overlap(planes[i], pos, first[j].index);
+                    auto i_over_j = compare_overlap(planes[j], pos, first[i].index);
+
+                    if(j_over_i < 0 || i_over_j > 0) {
+                        preds[i] |= (1U << j);
+                    }
+
+                    if(j_over_i > 0 || i_over_j < 0) {
+                        preds[j] |= (1U << i);
+                    }
+                }
+            }
+
+            std::array<triangle_sort_entry, bucket_size> ordered;
+            uint32_t placed = 0U;
+            for(size_t n = 0; n < num_tris; ++n) {
+                size_t next = num_tris;
+                size_t fallback = num_tris;
+                for(size_t i = 0; i < num_tris; ++i) {
+                    if(placed & (1U << i)) {
+                        continue;
+                    }
+
+                    fallback = std::min(fallback, i);
+                    if((preds[i] & ~placed) == 0U) {
+                        next = i;
+                        break;
+                    }
+                }
+
+                if(next == num_tris) {
+                    next = fallback;
+                }
+
+                ordered[n] = first[next];
+                placed |= (1U << next);
+            }
+
+            std::copy(ordered.begin(), ordered.begin() + num_tris, first);
+        }
+    }
+}
+
+jkgm::sorted_triangle_batch::sorted_triangle_batch(job_system *jobs,
+                                                   transparency_sort_mode mode,
+                                                   bool enable_temporal_sort)
+    : jobs(jobs)
+    , mode(mode)
+    , enable_temporal_sort(enable_temporal_sort)
+{
+}
+
+void jkgm::sorted_triangle_batch::sort_partition()
+{
+    partition_context ctx{&positions, jobs};
+    do_fast_partition(ctx, entries.data(), entries.data() + entries.size());
+}
+
+void jkgm::sorted_triangle_batch::sort_bucketed()
+{
+    // Draw back to front by farthest vertex. Eye space depth is stored in w.
+    std::sort(entries.begin(), entries.end(), [](auto const &a, auto const &b) {
+        if(a.depth != b.depth) {
+            return a.depth > b.depth;
+        }
+
+        return a.index < b.index;
+    });
+
+    size_t num_buckets = (entries.size() + bucket_size - 1U) / bucket_size;
+    auto fix_up_buckets = [&](size_t first_bucket, size_t last_bucket) {
+        for(size_t i = first_bucket; i < last_bucket; ++i) {
+            auto *first = entries.data() + (i * bucket_size);
+            auto *last = entries.data() + std::min(entries.size(), (i + 1U) * bucket_size);
+            fix_up_bucket(positions, first, last);
+        }
+    };
+
+    if(jobs) {
+        jobs->parallel_for(0U, num_buckets, buckets_per_task, fix_up_buckets);
+    }
+    else {
+        fix_up_buckets(0U, num_buckets);
+    }
+}
+
+bool jkgm::sorted_triangle_batch::seed_from_previous_order()
+{
+    if(previous_ranks.empty()) {
+        return false;
+    }
+
+    matched_entries.clear();
+    unmatched_entries.clear();
+
+    for(auto const &em : entries) {
+        auto it = previous_ranks.find(keys[em.index]);
+        if(it == previous_ranks.end()) {
+            unmatched_entries.push_back(em);
+        }
+        else {
+            matched_entries.emplace_back(it->second, em);
+        }
+    }
+
+    if(static_cast<float>(matched_entries.size()) <
+       static_cast<float>(entries.size()) * min_temporal_match_fraction) {
+        return false;
+    }
+
+    // Place persisting triangles by last frame's rank. Ranks are unique, except when two
+    // triangles share a key; later duplicates are treated as new triangles.
+    rank_slots.assign(previous_ranks.size(), no_rank_slot);
+    for(size_t i = 0; i < matched_entries.size(); ++i) {
+        auto rank = std::get<0>(matched_entries[i]);
+        if(rank_slots[rank] == no_rank_slot) {
+            rank_slots[rank] = i;
+        }
+        else {
+            unmatched_entries.push_back(std::get<1>(matched_entries[i]));
+        }
+    }
+
+    // Merge new triangles in by depth
+    std::sort(unmatched_entries.begin(), unmatched_entries.end(), [](auto const &a, auto const &b) {
+        return a.depth > b.depth;
+    });
+
+    auto unmatched_it = unmatched_entries.begin();
+    auto out_it = entries.begin();
+    for(auto slot : rank_slots) {
+        if(slot == no_rank_slot) {
+            continue;
+        }
+
+        auto const &em = std::get<1>(matched_entries[slot]);
+        while(unmatched_it != unmatched_entries.end() && unmatched_it->depth >= em.depth) {
+            *out_it++ = *unmatched_it++;
+        }
+
+        *out_it++ = em;
+    }
+
+    std::copy(unmatched_it, unmatched_entries.end(), out_it);
+    return true;
+}
+
+bool jkgm::sorted_triangle_batch::repair_order()
+{
+    planes.resize(num_triangles);
+    for(size_t i = 0; i < num_triangles; ++i) {
+        planes[i] = make_triangle_planes(positions, i);
+    }
+
+    entry_positions.resize(num_triangles);
+    for(size_t i = 0; i < entries.size(); ++i) {
+        entry_positions[entries[i].index] = static_cast<uint32_t>(i);
+    }
+
+    // Order only matters between triangles that overlap on screen. Find those pairs by binning
+    // projected bounds into a grid, and flag both triangles of any pair that is out of order.
+    // This covers new triangles and triangles that moved past a whole run of others.
+    screen_bounds.resize(num_triangles);
+    grid_cell_starts.assign((repair_grid_size * repair_grid_size) + 1U, 0U);
+    for(size_t i = 0; i < num_triangles; ++i) {
+        auto &bounds = screen_bounds[i];
+        bounds.min_x = bounds.min_y = bounds.min_depth = std::numeric_limits<float>::max();
+        bounds.max_x = bounds.max_y = bounds.max_depth = std::numeric_limits<float>::lowest();
+        for(size_t v = 0; v < 3; ++v) {
+            float inv_w = 1.0f / std::max(positions.w[v][i], min_projected_depth);
+            float sx = positions.x[v][i] * inv_w;
+            float sy = positions.y[v][i] * inv_w;
+            bounds.min_x = std::min(bounds.min_x, sx);
+            bounds.max_x = std::max(bounds.max_x, sx);
+            bounds.min_y = std::min(bounds.min_y, sy);
+            bounds.max_y = std::max(bounds.max_y, sy);
+            bounds.min_depth = std::min(bounds.min_depth, positions.w[v][i]);
+            bounds.max_depth = std::max(bounds.max_depth, positions.w[v][i]);
+        }
+
+        set_grid_cells(&bounds);
+        for(size_t y = bounds.min_cell_y; y <= bounds.max_cell_y; ++y) {
+            for(size_t x = bounds.min_cell_x; x <= bounds.max_cell_x; ++x) {
+                ++grid_cell_starts[(y * repair_grid_size) + x + 1U];
+            }
+        }
+    }
+
+    for(size_t i = 1; i < grid_cell_starts.size(); ++i) {
+        grid_cell_starts[i] += grid_cell_starts[i - 1U];
+    }
+
+    grid_cell_triangles.resize(grid_cell_starts.back());
+    grid_cell_fill.assign(grid_cell_starts.begin(), grid_cell_starts.end() - 1);
+
+    // Cells list their triangles in draw order
+    for(auto const &em : entries) {
+        auto const &bounds = screen_bounds[em.index];
+        for(size_t y = bounds.min_cell_y; y <= bounds.max_cell_y; ++y) {
+            for(size_t x = bounds.min_cell_x; x <= bounds.max_cell_x; ++x) {
+                grid_cell_triangles[grid_cell_fill[(y * repair_grid_size) + x]++] = em.index;
+            }
+        }
+    }
+
+    // A triangle can only need to move ahead of an earlier triangle that is partly nearer than
+    // its farthest vertex. In a correctly ordered cell that is rare, so most triangles are only
+    // compared with the nearest depth drawn so far. Otherwise a triangle is compared with the
+    // nearest triangle drawn before it and with a short window of its predecessors, which keeps
+    // each cell linear. Deeper conflicts almost always involve the nearest triangle as well.
+    auto flag_if_out_of_order = [&](uint32_t a, uint32_t b) {
+        auto const &ab = screen_bounds[a];
+        auto const &bb = screen_bounds[b];
+        if(ab.min_depth >= bb.max_depth || bb.min_x > ab.max_x || bb.max_x < ab.min_x ||
+           bb.min_y > ab.max_y || bb.max_y < ab.min_y) {
+            return;
+        }
+
+        if(compare_draw_order(planes, positions, a, b) > 0) {
+            repair_flags[a] = true;
+            repair_flags[b] = true;
+        }
+    };
+
+    repair_flags.assign(num_triangles, false);
+    for(size_t cell = 0; cell < (repair_grid_size * repair_grid_size); ++cell) {
+        auto const *cell_tris = grid_cell_triangles.data() + grid_cell_starts[cell];
+        size_t num_cell_tris = grid_cell_starts[cell + 1U] - grid_cell_starts[cell];
+
+        float nearest_drawn = std::numeric_limits<float>::max();
+        uint32_t nearest_tri = 0U;
+        for(size_t i = 0; i < num_cell_tris; ++i) {
+            auto const &b = screen_bounds[cell_tris[i]];
+            if(b.max_depth > nearest_drawn) {
+                size_t first_window = (i > repair_window_size) ? (i - repair_window_size) : 0U;
+                bool nearest_in_window = false;
+                for(size_t j = first_window; j < i; ++j) {
+                    nearest_in_window = nearest_in_window || (cell_tris[j] == nearest_tri);
+                    flag_if_out_of_order(cell_tris[j], cell_tris[i]);
+                }
+
+                if(!nearest_in_window) {
+                    flag_if_out_of_order(nearest_tri, cell_tris[i]);
+                }
+            }
+
+            if(b.min_depth < nearest_drawn) {
+                nearest_drawn = b.min_depth;
+                nearest_tri = cell_tris[i];
+            }
+        }
+    }
+
+    repair_triangles.clear();
+    for(auto const &em : entries) {
+        if(repair_flags[em.index]) {
+            repair_triangles.push_back(em.index);
+        }
+    }
+
+    if(repair_triangles.size() > (entries.size() / max_temporal_repair_divisor)) {
+        return false;
+    }
+
+    // Reinsert each triangle between the triangles it must follow and the triangles it must
+    // precede. Only triangles that share a grid cell with it can overlap it. Moving a triangle
+    // only changes its order relative to others, so earlier placements stay valid.
+    size_t comparisons_remaining = entries.size() * max_repair_comparisons_per_triangle;
+    repair_visits.assign(num_triangles, 0U);
+    for(size_t r = 0; r < repair_triangles.size(); ++r) {
+        auto tri = repair_triangles[r];
+        auto visit = static_cast<uint32_t>(r + 1U);
+        repair_visits[tri] = visit;
+
+        auto const &bounds = screen_bounds[tri];
+        size_t first_valid = 0U;
+        size_t last_valid = entries.size();
+        for(size_t y = bounds.min_cell_y; y <= bounds.max_cell_y; ++y) {
+            for(size_t x = bounds.min_cell_x; x <= bounds.max_cell_x; ++x) {
+                size_t cell = (y * repair_grid_size) + x;
+                for(auto i = grid_cell_starts[cell]; i < grid_cell_starts[cell + 1U]; ++i) {
+                    auto other = grid_cell_triangles[i];
+                    if(repair_visits[other] == visit) {
+                        continue;
+                    }
+
+                    repair_visits[other] = visit;
+
+                    auto const &other_bounds = screen_bounds[other];
+                    if(bounds.min_x > other_bounds.max_x || bounds.max_x < other_bounds.min_x ||
+                       bounds.min_y > other_bounds.max_y || bounds.max_y < other_bounds.min_y) {
+                        continue;
+                    }
+
+                    if(comparisons_remaining == 0U) {
+                        return false;
+                    }
+
+                    --comparisons_remaining;
+
+                    size_t other_pos = entry_positions[other];
+                    auto order = compare_draw_order(planes, positions, other, tri);
+                    if(order < 0) {
+                        first_valid = std::max(first_valid, other_pos + 1U);
+                    }
+                    else if(order > 0) {
+                        last_valid = std::min(last_valid, other_pos);
+                    }
+                }
+            }
+        }
+
+        if(first_valid > last_valid) {
+            // Conflicting constraints cannot be resolved by moving this triangle alone
+            return false;
+        }
+
+        size_t from = entry_positions[tri];
+        size_t first_moved = from;
+        size_t last_moved = from;
+        if(from < first_valid) {
+            // Everything up to first_valid shifts down by one
+            std::rotate(entries.begin() + from,
+                        entries.begin() + from + 1U,
+                        entries.begin() + first_valid);
+            last_moved = first_valid - 1U;
+        }
+        else if(from >= last_valid) {
+            std::rotate(entries.begin() + last_valid,
+                        entries.begin() + from,
+                        entries.begin() + from + 1U);
+            first_moved = last_valid;
+        }
+
+        for(size_t i = first_moved; i <= last_moved; ++i) {
+            entry_positions[entries[i].index] = static_cast<uint32_t>(i);
+        }
+    }
+
+    return true;
+}
+
+void jkgm::sorted_triangle_batch::record_order()
+{
+    // Ranks are dense. Triangles with duplicate keys keep only the first rank.
+    previous_ranks.clear();
+    for(auto const &em : entries) {
+        auto rank = static_cast<uint32_t>(previous_ranks.size());
+        previous_ranks.emplace(keys[em.index], rank);
+    }
+}
+
+void jkgm::sorted_triangle_batch::sort()
+{
+    TRACE_SCOPE("sorted_triangle_batch::sort");
+
+    for(size_t v = 0; v < 3; ++v) {
+        positions.x[v].resize(num_triangles);
+        positions.y[v].resize(num_triangles);
+        positions.w[v].resize(num_triangles);
+    }
+
+    positions.nx.resize(num_triangles);
+    positions.ny.resize(num_triangles);
+    positions.nz.resize(num_triangles);
+
+    entries.resize(num_triangles);
+    keys.resize(num_triangles);
+
+    for(size_t i = 0; i < num_triangles; ++i) {
+        auto const &tri = buffer[i];
+
+        triangle_vertex const *verts[3] = {&tri.v0, &tri.v1, &tri.v2};
+        for(size_t v = 0; v < 3; ++v) {
+            positions.x[v][i] = get<x>(verts[v]->pos);
+            positions.y[v][i] = get<y>(verts[v]->pos);
+            positions.w[v][i] = get<w>(verts[v]->pos);
+        }
+
+        // Face normals are only needed for sorting, so they are not computed at insertion
+        auto p0 = make_point(positions.x[0][i], positions.y[0][i], positions.w[0][i]);
+        auto p1 = make_point(positions.x[1][i], positions.y[1][i], positions.w[1][i]);
+        auto p2 = make_point(positions.x[2][i], positions.y[2][i], positions.w[2][i]);
+
+        auto normal = normalize(cross(p1 - p0, p2 - p0));
+
+        // JK disables backface culling. Make all of the normals point in the same direction.
+        if(dot(normal, point<3, float>::zero() - p0) < 0.0f) {
+            normal = -normal;
+        }
+
+        positions.nx[i] = get<x>(normal);
+        positions.ny[i] = get<y>(normal);
+        positions.nz[i] = get<z>(normal);
+
+        entries[i] = triangle_sort_entry{
+            static_cast<uint32_t>(i),
+            0,
+            std::max(positions.w[0][i], std::max(positions.w[1][i], positions.w[2][i]))};
+
+        size_t key = std::hash<size_t>()(tri.material.get());
+        for(auto index : tri.source_vertices) {
+            key = hash_combine(key, index);
+        }
+
+        keys[i] = key;
+    }
+
+    // Small camera motions rarely change the order of translucent surfaces. When most of last
+    // frame's triangles are still present, start from their old order and repair it.
+    bool reused_order = enable_temporal_sort && seed_from_previous_order() && repair_order();
+    if(!reused_order) {
+        switch(mode) {
+        case transparency_sort_mode::partition:
+            sort_partition();
+            break;
+
+        case transparency_sort_mode::bucketed:
+            sort_bucketed();
+            break;
+        }
+    }
+
+    if(enable_temporal_sort) {
+        record_order();
+    }
+
+    // Reorder the triangles to match the sorted entries
+    sorted_buffer.resize(buffer.size());
+    for(size_t i = 0; i < num_triangles; ++i) {
+        sorted_buffer[i] = buffer[entries[i].index];
+    }
+
+    std::swap(buffer, sorted_buffer);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "base/job_system.hpp"
+#include "common/config.hpp"
+#include "core_fwd.hpp"
+#include "math/color.hpp"
+#include "math/direction.hpp"
+#include "math/point.hpp"
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace jkgm {
+    struct triangle_vertex {
+        point<4, float> pos;
+        point<2, float> texcoords;
+
+        // sRGB with straight alpha
+        color_rgba8 color;
+
+        triangle_vertex();
+        triangle_vertex(point<4, float> pos, point<2, float> texcoords, color_rgba8 color);
+    };
+
+    struct triangle {
+        triangle_vertex v0, v1, v2;
+        material_instance_id material = material_instance_id(0U);
+        size_t shader_variant = 0U;
+
+        // Set when the triangle may produce partially transparent pixels. Opaque passes must
+        // draw it with a program that discards them.
+        bool alpha_test = false;
+
+        // Indices of the execute buffer vertices the triangle was built from, unique within the
+        // frame. The transparency sorter uses them to recognize the triangle in the next frame.
+        std::array<uint32_t, 3> source_vertices = {0U, 0U, 0U};
+
+        triangle();
+        triangle(triangle_vertex v0,
+                 triangle_vertex v1,
+                 triangle_vertex v2,
+                 material_instance_id material,
+                 size_t shader_variant,
+                 bool alpha_test);
+    };
+
+    class triangle_batch {
+    private:
+        struct material_run {
+            bool alpha_test;
+            float depth;
+            size_t first;
+            size_t last;
+        };
+
+        std::vector<material_run> runs;
+
+    protected:
+        std::vector<triangle> buffer;
+        std::vector<triangle> sorted_buffer;
+        size_t num_triangles = 0U;
+        size_t num_expansions = 0U;
+
+        void expand();
+
+    public:
+        triangle_batch();
+        virtual ~triangle_batch() = default;
+
+        size_t size() const;
+        size_t capacity() const;
+        void clear();
+        void insert(triangle const &tri);
+
+        // Returns the number of times insert has grown the batch since the last call
+        size_t take_num_expansions();
+
+        virtual void sort();
+
+        inline auto begin() const
+        {
+            return buffer.begin();
+        }
+
+        inline auto end() const
+        {
+            return buffer.begin() + num_triangles;
+        }
+
+        inline auto begin()
+        {
+            return buffer.begin();
+        }
+
+        inline auto end()
+        {
+            return buffer.begin() + num_triangles;
+        }
+    };
+
+    struct triangle_sort_entry {
+        uint32_t index;
+
+        // Partition assignment relative to the current pivot: -1, 0 (ambiguous) or 1
+        int side;
+
+        // Farthest vertex depth, used by the bucketed sorter
+        float depth;
+    };
+
+    // Eye space vertex positions and face normals in structure-of-arrays layout, indexed by
+    // triangle. Depth is stored in w.
+    struct triangle_positions {
+        std::array<std::vector<float>, 3> x;
+        std::array<std::vector<float>, 3> y;
+        std::array<std::vector<float>, 3> w;
+        std::vector<float> nx;
+        std::vector<float> ny;
+        std::vector<float> nz;
+    };
+
+    // Plane in eye space, evaluated as dot(p, n) - d
+    struct plane {
+        float nx, ny, nz, d;
+    };
+
+    // Inward-facing edge planes bound the prism swept by the triangle along its normal
+    struct triangle_planes {
+        plane v0v1;
+        plane v1v2;
+        plane v2v0;
+        plane face;
+    };
+
+    // Bounds of a triangle's projection in normalized device coordinates, its depth range, and
+    // the range of grid cells it covers
+    struct triangle_screen_bounds {
+        float min_x, max_x, min_y, max_y;
+        float min_depth, max_depth;
+        uint16_t min_cell_x, max_cell_x, min_cell_y, max_cell_y;
+    };
+
+    class sorted_triangle_batch : public triangle_batch {
+    private:
+        job_system *jobs;
+        transparency_sort_mode mode;
+        bool enable_temporal_sort;
+        triangle_positions positions;
+        std::vector<triangle_sort_entry> entries;
+
+        // Temporal reuse: triangles are identified across frames by material and source vertices
+        std::vector<size_t> keys;
+        std::unordered_map<size_t, uint32_t> previous_ranks;
+        std::vector<std::tuple<uint32_t, triangle_sort_entry>> matched_entries;
+        std::vector<triangle_sort_entry> unmatched_entries;
+        std::vector<size_t> rank_slots;
+        std::vector<triangle_planes> planes;
+        std::vector<triangle_screen_bounds> screen_bounds;
+        std::vector<uint32_t> grid_cell_starts;
+        std::vector<uint32_t> grid_cell_fill;
+        std::vector<uint32_t> grid_cell_triangles;
+        std::vector<bool> repair_flags;
+        std::vector<uint32_t> repair_triangles;
+        std::vector<uint32_t> repair_visits;
+        std::vector<uint32_t> entry_positions;
+
+        void sort_partition();
+        void sort_bucketed();
+
+        bool seed_from_previous_order();
+        bool repair_order();
+        void record_order();
+
+    public:
+        sorted_triangle_batch(job_system *jobs,
+                              transparency_sort_mode mode,
+                              bool enable_temporal_sort);
+
+        void sort() override;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "triangle_buffer.hpp"
+#include "base/runtime_assert.hpp"
+
+size_t jkgm::pack_triangle_buffer(triangle_batch const &tb, span<triangle_buffer_vertex> dest)
+{
+    logic_assert(dest.size() >= tb.size() * 3, "triangle buffer is too small for batch");
+
+    auto *vx = dest.data();
+    for(auto const &tri : tb) {
+        vx->pos = tri.v0.pos;
+        vx->texcoords = tri.v0.texcoords;
+        vx->col = tri.v0.color;
+
+        ++vx;
+
+        vx->pos = tri.v1.pos;
+        vx->texcoords = tri.v1.texcoords;
+        vx->col = tri.v1.color;
+
+        ++vx;
+
+        vx->pos = tri.v2.pos;
+        vx->texcoords = tri.v2.texcoords;
+        vx->col = tri.v2.color;
+
+        ++vx;
+    }
+
+    return tb.size() * 3;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "base/span.hpp"
+#include "math/color.hpp"
+#include "math/point.hpp"
+#include "triangle_batch.hpp"
+
+namespace jkgm {
+    struct triangle_buffer_vertex {
+        point<4, float> pos;
+        point<2, float> texcoords;
+        color_rgba8 col;
+    };
+
+    static_assert(sizeof(triangle_buffer_vertex) == 28U);
+
+    // Writes three vertices per triangle, in batch order. Returns the number of vertices written.
+    size_t pack_triangle_buffer(triangle_batch const &tb, span<triangle_buffer_vertex> dest);
+}
@@ -0,0 +1,68 @@
+#include "debug.hpp"
+#include "glad/gl.h"
+
+namespace jkgm::gl {
+    namespace {
+        void object_label(GLenum identifier, GLuint id, std::string_view label)
+        {
+            if(GLAD_GL_KHR_debug) {
+                glObjectLabel(identifier, id, static_cast<GLsizei>(label.size()), label.data());
+            }
+        }
+    }
+}
+
+bool jkgm::gl::has_debug_annotation_support()
+{
+    return GLAD_GL_KHR_debug != 0;
+}
+
+void jkgm::gl::push_debug_group(std::string_view name)
+{
+    if(GLAD_GL_KHR_debug) {
+        glPushDebugGroup(
+            GL_DEBUG_SOURCE_APPLICATION, 0U, static_cast<GLsizei>(name.size()), name.data());
+    }
+}
+
+void jkgm::gl::pop_debug_group()
+{
+    if(GLAD_GL_KHR_debug) {
+        glPopDebugGroup();
+    }
+}
+
+jkgm::gl::debug_group::debug_group(std::string_view name)
+{
+    push_debug_group(name);
+}
+
+jkgm::gl::debug_group::~debug_group()
+{
+    pop_debug_group();
+}
+
+void jkgm::gl::set_object_label(framebuffer_view id, std::string_view label)
+{
+    object_label(GL_FRAMEBUFFER, *id, label);
+}
+
+void jkgm::gl::set_object_label(program_view id, std::string_view label)
+{
+    object_label(GL_PROGRAM, *id, label);
+}
+
+void jkgm::gl::set_object_label(renderbuffer_view id, std::string_view label)
+{
+    object_label(GL_RENDERBUFFER, *id, label);
+}
+
+void jkgm::gl::set_object_label(texture_view id, std::string_view label)
+{
+    object_label(GL_TEXTURE, *id, label);
+}
+
+void jkgm::gl::set_object_label(vertex_array_view id, std::string_view label)
+{
+    object_label(GL_VERTEX_ARRAY, *id, label);
+}
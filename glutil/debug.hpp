@@ -0,0 +1,33 @@
+#pragma once
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+#include "renderbuffer.hpp"
+#include "texture.hpp"
+#include "vertex_array.hpp"
+#include <string_view>
+
+namespace jkgm::gl {
+    // Debug groups and object labels are shown by external tools such as RenderDoc and
+    // apitrace. Requires GL_KHR_debug; everything here does nothing when it is unavailable.
+    bool has_debug_annotation_support();
+
+    void push_debug_group(std::string_view name);
+    void pop_debug_group();
+
+    // Groups the commands issued during the lifetime of the scope
+    class debug_group {
+    public:
+        explicit debug_group(std::string_view name);
+        ~debug_group();
+
+        debug_group(debug_group const &) = delete;
+        debug_group &operator=(debug_group const &) = delete;
+    };
+
+    void set_object_label(framebuffer_view id, std::string_view label);
+    void set_object_label(program_view id, std::string_view label);
+    void set_object_label(renderbuffer_view id, std::string_view label);
+    void set_object_label(texture_view id, std::string_view label);
+    void set_object_label(vertex_array_view id, std::string_view label);
+}
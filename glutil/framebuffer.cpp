@@ -55,6 +55,21 @@ void jkgm::gl::detail::draw_buffers_span(span<enum_type const> bufs)
     glDrawBuffers(bufs.size(), bufs.data());
 }
 
+bool jkgm::gl::has_invalidate_framebuffer_support()
+{
+    return GLAD_GL_ARB_invalidate_subdata != 0;
+}
+
+void jkgm::gl::detail::invalidate_framebuffer_span(framebuffer_bind_target target,
+                                                   span<enum_type const> attachments)
+{
+    if(GLAD_GL_ARB_invalidate_subdata) {
+        glInvalidateFramebuffer(static_cast<GLenum>(target),
+                                static_cast<GLsizei>(attachments.size()),
+                                attachments.data());
+    }
+}
+
 void jkgm::gl::framebuffer_texture(framebuffer_bind_target target,
                                    framebuffer_attachment attachment,
                                    texture_view tex,
@@ -101,6 +116,8 @@ namespace jkgm::gl {
     static_assert(framebuffer_attachment::stencil == framebuffer_attachment(GL_STENCIL_ATTACHMENT));
     static_assert(framebuffer_attachment::depth_stencil ==
                   framebuffer_attachment(GL_DEPTH_STENCIL_ATTACHMENT));
+    static_assert(framebuffer_attachment::default_color == framebuffer_attachment(GL_COLOR));
+    static_assert(framebuffer_attachment::default_depth == framebuffer_attachment(GL_DEPTH));
 
     static_assert(framebuffer_bind_target::any == framebuffer_bind_target(GL_FRAMEBUFFER));
     static_assert(framebuffer_bind_target::draw == framebuffer_bind_target(GL_DRAW_FRAMEBUFFER));
@@ -34,7 +34,11 @@ namespace jkgm::gl {
         color2 = 0x8CE2,
         depth = 0x8D00,
         stencil = 0x8D20,
-        depth_stencil = 0x821A
+        depth_stencil = 0x821A,
+
+        // Default framebuffer attachments, only valid for invalidation
+        default_color = 0x1800,
+        default_depth = 0x1801
     };
 
     enum class framebuffer_bind_target : enum_type { any = 0x8D40, draw = 0x8CA9, read = 0x8CA8 };
@@ -72,6 +76,8 @@ namespace jkgm::gl {
 
     namespace detail {
         void draw_buffers_span(span<enum_type const> bufs);
+        void invalidate_framebuffer_span(framebuffer_bind_target target,
+                                         span<enum_type const> attachments);
     }
 
     template <class... T>
@@ -81,6 +87,17 @@ namespace jkgm::gl {
         detail::draw_buffers_span(make_span(dbs));
     }
 
+    // Marks attachment contents as undefined so the driver can skip loading them. Requires
+    // GL_ARB_invalidate_subdata; does nothing when the extension is unavailable.
+    bool has_invalidate_framebuffer_support();
+
+    template <class... T>
+    void invalidate_framebuffer(framebuffer_bind_target target, T... attachments)
+    {
+        std::array<enum_type, sizeof...(attachments)> atts{static_cast<enum_type>(attachments)...};
+        detail::invalidate_framebuffer_span(target, make_span(atts));
+    }
+
     void framebuffer_texture(framebuffer_bind_target target,
                              framebuffer_attachment attachment,
                              texture_view tex,
@@ -22,6 +22,17 @@ void jkgm::gl::set_blend_function(blend_function sfactor, blend_function dfactor
     glBlendFunc(static_cast<GLenum>(sfactor), static_cast<GLenum>(dfactor));
 }
 
+void jkgm::gl::set_blend_function_separate(blend_function src_rgb,
+                                           blend_function dst_rgb,
+                                           blend_function src_alpha,
+                                           blend_function dst_alpha)
+{
+    glBlendFuncSeparate(static_cast<GLenum>(src_rgb),
+                        static_cast<GLenum>(dst_rgb),
+                        static_cast<GLenum>(src_alpha),
+                        static_cast<GLenum>(dst_alpha));
+}
+
 void jkgm::gl::set_clear_color(color c)
 {
     glClearColor(get<r>(c), get<g>(c), get<b>(c), get<a>(c));
@@ -37,6 +48,11 @@ void jkgm::gl::set_depth_mask(bool enable)
     glDepthMask(enable ? GL_TRUE : GL_FALSE);
 }
 
+void jkgm::gl::set_depth_range(float near_val, float far_val)
+{
+    glDepthRange(near_val, far_val);
+}
+
 void jkgm::gl::set_face_cull_mode(face_mode mode)
 {
     glCullFace(static_cast<GLenum>(mode));
@@ -53,6 +69,16 @@ void jkgm::gl::set_viewport(box<2, int> vp)
     glViewport(get<x>(vp.start), get<y>(vp.start), get<x>(dim), get<y>(dim));
 }
 
+std::string jkgm::gl::get_string(string_name name)
+{
+    auto const *rv = glGetString(static_cast<GLenum>(name));
+    if(rv == nullptr) {
+        return std::string();
+    }
+
+    return std::string(reinterpret_cast<char const *>(rv));
+}
+
 void jkgm::gl::log_errors()
 {
     for(;;) {
@@ -68,6 +94,7 @@ void jkgm::gl::log_errors()
 namespace jkgm::gl {
     static_assert(blend_function::zero == blend_function(GL_ZERO));
     static_assert(blend_function::one == blend_function(GL_ONE));
+    static_assert(blend_function::source_alpha == blend_function(GL_SRC_ALPHA));
     static_assert(blend_function::one_minus_source_alpha == blend_function(GL_ONE_MINUS_SRC_ALPHA));
 
     static_assert(capability::blend == capability(GL_BLEND));
@@ -94,4 +121,10 @@ namespace jkgm::gl {
     static_assert(polygon_mode::point == polygon_mode(GL_POINT));
     static_assert(polygon_mode::line == polygon_mode(GL_LINE));
     static_assert(polygon_mode::fill == polygon_mode(GL_FILL));
+
+    static_assert(string_name::vendor == string_name(GL_VENDOR));
+    static_assert(string_name::renderer == string_name(GL_RENDERER));
+    static_assert(string_name::version == string_name(GL_VERSION));
+    static_assert(string_name::shading_language_version ==
+                  string_name(GL_SHADING_LANGUAGE_VERSION));
 }
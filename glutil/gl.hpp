@@ -4,11 +4,13 @@
 #include "gl_types.hpp"
 #include "math/box.hpp"
 #include "math/color.hpp"
+#include <string>
 
 namespace jkgm::gl {
     enum class blend_function : enum_type {
         zero = 0x0,
         one = 0x1,
+        source_alpha = 0x0302,
         one_minus_source_alpha = 0x0303
     };
 
@@ -34,6 +36,13 @@ namespace jkgm::gl {
 
     enum class polygon_mode : enum_type { point = 0x1b00, line = 0x1b01, fill = 0x1b02 };
 
+    enum class string_name : enum_type {
+        vendor = 0x1F00,
+        renderer = 0x1F01,
+        version = 0x1F02,
+        shading_language_version = 0x8B8C
+    };
+
     enum class clear_flag : bitfield_type { color = 0x00004000, depth = 0x00000100 };
     using clear_flags = flag_set<clear_flag>;
 
@@ -43,12 +52,19 @@ namespace jkgm::gl {
     void clear(clear_flags cf);
 
     void set_blend_function(blend_function sfactor, blend_function dfactor);
+    void set_blend_function_separate(blend_function src_rgb,
+                                     blend_function dst_rgb,
+                                     blend_function src_alpha,
+                                     blend_function dst_alpha);
     void set_clear_color(color c);
     void set_depth_function(comparison_function func);
     void set_depth_mask(bool enable);
+    void set_depth_range(float near_val, float far_val);
     void set_face_cull_mode(face_mode mode);
     void set_polygon_mode(face_mode fm, polygon_mode pm);
     void set_viewport(box<2, int> vp);
 
+    std::string get_string(string_name name);
+
     void log_errors();
 }
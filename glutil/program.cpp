@@ -43,6 +43,44 @@ std::string jkgm::gl::get_program_info_log(program_view id)
     return rv;
 }
 
+bool jkgm::gl::has_program_binary_support()
+{
+    if(!GLAD_GL_ARB_get_program_binary) {
+        return false;
+    }
+
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+}
+
+void jkgm::gl::set_program_binary_retrievable_hint(program_view id, bool value)
+{
+    glProgramParameteri(*id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, value ? GL_TRUE : GL_FALSE);
+}
+
+std::vector<char> jkgm::gl::get_program_binary(program_view id, enum_type *binary_format)
+{
+    std::vector<char> rv;
+
+    int binary_length = 0;
+    glGetProgramiv(*id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if(binary_length > 0) {
+        rv.resize(binary_length);
+
+        GLsizei actual_length = 0;
+        glGetProgramBinary(*id, binary_length, &actual_length, binary_format, rv.data());
+        rv.resize(actual_length);
+    }
+
+    return rv;
+}
+
+void jkgm::gl::program_binary(program_view id, enum_type binary_format, span<char const> binary)
+{
+    glProgramBinary(*id, binary_format, binary.data(), static_cast<GLsizei>(binary.size()));
+}
+
 void jkgm::gl::use_program(program_view prog)
 {
     glUseProgram(*prog);
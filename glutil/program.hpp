@@ -8,6 +8,7 @@
 #include "base/id.hpp"
 #include "base/unique_handle.hpp"
 #include <optional>
+#include <vector>
 
 namespace jkgm::gl {
     struct program_traits {
@@ -28,6 +29,12 @@ namespace jkgm::gl {
     bool get_program_link_status(program_view id);
     std::string get_program_info_log(program_view id);
 
+    // Program binaries require GL_ARB_get_program_binary and at least one driver binary format
+    bool has_program_binary_support();
+    void set_program_binary_retrievable_hint(program_view id, bool value);
+    std::vector<char> get_program_binary(program_view id, enum_type *binary_format);
+    void program_binary(program_view id, enum_type binary_format, span<char const> binary);
+
     void use_program(program_view prog);
     uniform_location_id get_uniform_location(program_view prog, cstring_view name);
 
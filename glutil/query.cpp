@@ -0,0 +1,54 @@
+#include "query.hpp"
+#include "glad/gl.h"
+
+GLuint jkgm::gl::query_traits::create()
+{
+    GLuint rv = 0;
+    glGenQueries(1, &rv);
+    return rv;
+}
+
+void jkgm::gl::query_traits::destroy(GLuint id)
+{
+    glDeleteQueries(1, &id);
+}
+
+void jkgm::gl::begin_query(query_target target, query_view q)
+{
+    glBeginQuery(static_cast<GLenum>(target), *q);
+}
+
+void jkgm::gl::end_query(query_target target)
+{
+    glEndQuery(static_cast<GLenum>(target));
+}
+
+void jkgm::gl::query_timestamp(query_view q)
+{
+    glQueryCounter(*q, GL_TIMESTAMP);
+}
+
+bool jkgm::gl::is_query_result_available(query_view q)
+{
+    GLint rv = GL_FALSE;
+    glGetQueryObjectiv(*q, GL_QUERY_RESULT_AVAILABLE, &rv);
+    return rv != GL_FALSE;
+}
+
+uint64_t jkgm::gl::get_query_result(query_view q)
+{
+    GLuint64 rv = 0U;
+    glGetQueryObjectui64v(*q, GL_QUERY_RESULT, &rv);
+    return rv;
+}
+
+uint64_t jkgm::gl::get_timestamp()
+{
+    GLint64 rv = 0;
+    glGetInteger64v(GL_TIMESTAMP, &rv);
+    return static_cast<uint64_t>(rv);
+}
+
+namespace jkgm::gl {
+    static_assert(query_target::time_elapsed == query_target(GL_TIME_ELAPSED));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "gl.hpp"
+#include "base/unique_handle.hpp"
+
+namespace jkgm::gl {
+    struct query_traits {
+        using value_type = uint_type;
+
+        static uint_type create();
+        static void destroy(uint_type id);
+    };
+
+    using query = unique_handle<query_traits>;
+    using query_view = unique_handle_view<query_traits>;
+
+    enum class query_target { time_elapsed = 0x88BF };
+
+    void begin_query(query_target target, query_view q);
+    void end_query(query_target target);
+
+    // Records the GPU time at which all previously issued commands have completed
+    void query_timestamp(query_view q);
+
+    bool is_query_result_available(query_view q);
+
+    // Blocks until the result is available. Time queries produce nanoseconds.
+    uint64_t get_query_result(query_view q);
+
+    // Returns the current GPU time in nanoseconds, comparable to timestamp query results
+    uint64_t get_timestamp();
+}
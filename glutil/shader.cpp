@@ -48,6 +48,16 @@ std::string jkgm::gl::get_shader_info_log(shader_view id)
     return rv;
 }
 
+bool jkgm::gl::has_parallel_shader_compile_support()
+{
+    return GLAD_GL_KHR_parallel_shader_compile != 0;
+}
+
+void jkgm::gl::set_max_shader_compiler_threads(unsigned int count)
+{
+    glMaxShaderCompilerThreadsKHR(count);
+}
+
 namespace jkgm::gl {
     static_assert(shader_type::vertex == shader_type(GL_VERTEX_SHADER));
     static_assert(shader_type::fragment == shader_type(GL_FRAGMENT_SHADER));
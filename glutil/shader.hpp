@@ -23,4 +23,9 @@ namespace jkgm::gl {
 
     bool get_shader_compile_status(shader_view id);
     std::string get_shader_info_log(shader_view id);
+
+    // Lets the driver compile and link on background threads (GL_KHR_parallel_shader_compile).
+    // Compiles issued afterward only block when their status is queried.
+    bool has_parallel_shader_compile_support();
+    void set_max_shader_compiler_threads(unsigned int count);
 }
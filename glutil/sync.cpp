@@ -0,0 +1,34 @@
+#include "sync.hpp"
+#include "glad/gl.h"
+
+void *jkgm::gl::fence_traits::create()
+{
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void jkgm::gl::fence_traits::destroy(void *id)
+{
+    glDeleteSync(static_cast<GLsync>(id));
+}
+
+bool jkgm::gl::is_fence_signaled(fence_view f)
+{
+    GLint rv = GL_UNSIGNALED;
+    glGetSynciv(static_cast<GLsync>(*f), GL_SYNC_STATUS, 1, nullptr, &rv);
+    return rv == GL_SIGNALED;
+}
+
+void jkgm::gl::wait_for_fence(fence_view f)
+{
+    constexpr GLuint64 timeout_ns = 1000000000U;
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while(true) {
+        auto result = glClientWaitSync(static_cast<GLsync>(*f), flags, timeout_ns);
+        if(result != GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+
+        flags = 0;
+    }
+}
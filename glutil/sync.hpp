@@ -0,0 +1,22 @@
+#pragma once
+
+#include "gl.hpp"
+#include "base/unique_handle.hpp"
+
+namespace jkgm::gl {
+    struct fence_traits {
+        using value_type = void *;
+
+        // Inserts a fence that signals once all previously issued commands have completed
+        static void *create();
+        static void destroy(void *id);
+    };
+
+    using fence = unique_handle<fence_traits>;
+    using fence_view = unique_handle_view<fence_traits>;
+
+    bool is_fence_signaled(fence_view f);
+
+    // Blocks until the fence signals. Pending commands are flushed so that it always does.
+    void wait_for_fence(fence_view f);
+}
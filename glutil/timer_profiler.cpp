@@ -0,0 +1,155 @@
+#include "timer_profiler.hpp"
+#include <algorithm>
+
+jkgm::gl::timer_profiler::timer_profiler(int frames_per_report)
+    : frames_per_report(frames_per_report)
+{
+}
+
+void jkgm::gl::timer_profiler::collect(frame_queries *frame)
+{
+    frame->pending = false;
+    if(frame->samples.empty()) {
+        return;
+    }
+
+    // Queries complete in order, so the last query being ready means all of them are
+    if(!is_query_result_available(frame->queries[frame->num_used_queries - 1U])) {
+        ++window_dropped_frames;
+        return;
+    }
+
+    std::fill(frame_section_times.begin(), frame_section_times.end(), -1.0);
+    for(auto const &s : frame->samples) {
+        auto begin_time = get_query_result(frame->queries[s.first_query]);
+        auto end_time = get_query_result(frame->queries[s.first_query + 1U]);
+
+        double elapsed = 0.0;
+        if(end_time > begin_time) {
+            elapsed = static_cast<double>(end_time - begin_time) / 1000.0;
+        }
+
+        // Sections used several times in one frame are summed
+        auto &em = frame_section_times[s.section];
+        em = std::max(em, 0.0) + elapsed;
+    }
+
+    for(size_t i = 0; i < sections.size(); ++i) {
+        auto time = frame_section_times[i];
+        if(time < 0.0) {
+            continue;
+        }
+
+        auto &section = sections[i];
+        section.window_total += time;
+        section.window_max = std::max(section.window_max, time);
+        ++section.window_frames;
+    }
+
+    ++window_frames;
+}
+
+void jkgm::gl::timer_profiler::begin_frame()
+{
+    auto &frame = frames[current_frame];
+    if(frame.pending) {
+        collect(&frame);
+    }
+
+    frame.num_used_queries = 0U;
+    frame.samples.clear();
+    open_samples.clear();
+}
+
+void jkgm::gl::timer_profiler::end_frame()
+{
+    // Close sections left open by an early return
+    while(!open_samples.empty()) {
+        end_section();
+    }
+
+    frames[current_frame].pending = true;
+    current_frame = (current_frame + 1U) % num_buffered_frames;
+}
+
+void jkgm::gl::timer_profiler::begin_section(std::string_view name)
+{
+    auto it = section_ids.find(name);
+    if(it == section_ids.end()) {
+        it = section_ids.emplace(std::string(name), sections.size()).first;
+        sections.push_back(section_data{std::string(name)});
+        frame_section_times.push_back(-1.0);
+    }
+
+    auto &frame = frames[current_frame];
+    while(frame.queries.size() < frame.num_used_queries + 2U) {
+        frame.queries.emplace_back();
+    }
+
+    size_t first_query = frame.num_used_queries;
+    frame.num_used_queries += 2U;
+
+    query_timestamp(frame.queries[first_query]);
+
+    open_samples.push_back(frame.samples.size());
+    frame.samples.push_back(sample{it->second, first_query});
+}
+
+void jkgm::gl::timer_profiler::end_section()
+{
+    if(open_samples.empty()) {
+        return;
+    }
+
+    auto &frame = frames[current_frame];
+    auto const &s = frame.samples[open_samples.back()];
+    open_samples.pop_back();
+
+    query_timestamp(frame.queries[s.first_query + 1U]);
+}
+
+std::optional<std::vector<jkgm::gl::timer_profiler_section>>
+    jkgm::gl::timer_profiler::take_report()
+{
+    if(window_frames < frames_per_report) {
+        return std::nullopt;
+    }
+
+    std::vector<timer_profiler_section> rv;
+    for(auto &section : sections) {
+        if(section.window_frames > 0) {
+            rv.push_back(timer_profiler_section{
+                section.name,
+                section.window_total / static_cast<double>(section.window_frames),
+                section.window_max});
+        }
+
+        section.window_total = 0.0;
+        section.window_max = 0.0;
+        section.window_frames = 0;
+    }
+
+    window_frames = 0;
+    return rv;
+}
+
+int jkgm::gl::timer_profiler::get_dropped_frames() const
+{
+    return window_dropped_frames;
+}
+
+jkgm::gl::timer_profiler_scope::timer_profiler_scope(timer_profiler *profiler,
+                                                     std::string_view name)
+    : profiler(profiler)
+{
+    if(profiler) {
+        profiler->begin_section(name);
+    }
+}
+
+jkgm::gl::timer_profiler_scope::~timer_profiler_scope()
+{
+    if(profiler) {
+        profiler->end_section();
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "query.hpp"
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jkgm::gl {
+    // GPU time of one profiled section over a report window, in microseconds
+    struct timer_profiler_section {
+        std::string name;
+        double mean_time = 0.0;
+        double max_time = 0.0;
+    };
+
+    // Measures the GPU time of named sections with timestamp queries. Results are read back
+    // several frames later without blocking. Frames whose results are still pending by then
+    // are dropped rather than waited for.
+    //
+    // Timestamps, unlike GL_TIME_ELAPSED queries, may be issued while another timer query is
+    // active, so sections may nest and may overlap other timers.
+    class timer_profiler {
+    private:
+        static constexpr size_t num_buffered_frames = 3U;
+
+        struct sample {
+            size_t section;
+            size_t first_query;
+        };
+
+        struct frame_queries {
+            std::vector<query> queries;
+            size_t num_used_queries = 0U;
+            std::vector<sample> samples;
+            bool pending = false;
+        };
+
+        struct section_data {
+            std::string name;
+            double window_total = 0.0;
+            double window_max = 0.0;
+            int window_frames = 0;
+        };
+
+        std::array<frame_queries, num_buffered_frames> frames;
+        size_t current_frame = 0U;
+        std::vector<size_t> open_samples;
+
+        std::map<std::string, size_t, std::less<>> section_ids;
+        std::vector<section_data> sections;
+        std::vector<double> frame_section_times;
+
+        int frames_per_report;
+        int window_frames = 0;
+        int window_dropped_frames = 0;
+
+        void collect(frame_queries *frame);
+
+    public:
+        explicit timer_profiler(int frames_per_report);
+
+        void begin_frame();
+        void end_frame();
+
+        void begin_section(std::string_view name);
+        void end_section();
+
+        // Returns averages once frames_per_report frames have been measured. Sections are in
+        // order of first use.
+        std::optional<std::vector<timer_profiler_section>> take_report();
+
+        // Counts frames whose results were not ready in time, since the profiler was created
+        int get_dropped_frames() const;
+    };
+
+    // Profiles a section for the lifetime of the scope. Does nothing when profiler is null.
+    class timer_profiler_scope {
+    private:
+        timer_profiler *profiler;
+
+    public:
+        timer_profiler_scope(timer_profiler *profiler, std::string_view name);
+        ~timer_profiler_scope();
+
+        timer_profiler_scope(timer_profiler_scope const &) = delete;
+        timer_profiler_scope &operator=(timer_profiler_scope const &) = delete;
+    };
+}
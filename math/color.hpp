@@ -1,6 +1,7 @@
 #pragma once
 
 #include "abstract_vector.hpp"
+#include <cstdint>
 
 namespace jkgm {
     struct color_vector_tag {
@@ -0,0 +1,101 @@
+#include "frame_fence_queue.hpp"
+#include "base/log.hpp"
+#include <algorithm>
+
+namespace jkgm {
+    namespace {
+        constexpr int frames_per_stats_window = 600;
+    }
+}
+
+jkgm::frame_fence_queue::frame_fence_queue(size_t max_frames_in_flight)
+    : max_frames_in_flight(max_frames_in_flight)
+    , cpu_begin(clock::now())
+{
+}
+
+void jkgm::frame_fence_queue::retire_front()
+{
+    auto &frame = frames.front();
+    gl::wait_for_fence(frame.fence);
+
+    // The timestamp was written before the fence, so the result is available now
+    auto gpu_completed = gl::get_query_result(frame.completion_query);
+
+    double cpu_submit_time =
+        std::chrono::duration<double, std::micro>(frame.cpu_submitted - frame.cpu_begin).count();
+    double gpu_completion_time = 0.0;
+    if(gpu_completed > frame.gpu_submitted) {
+        gpu_completion_time = static_cast<double>(gpu_completed - frame.gpu_submitted) / 1000.0;
+    }
+
+    double present_latency = cpu_submit_time + gpu_completion_time;
+
+    LOG_TRACE("Frame latency: CPU submit ",
+              static_cast<int>(cpu_submit_time),
+              " us, GPU completion ",
+              static_cast<int>(gpu_completion_time),
+              " us, present ",
+              static_cast<int>(present_latency),
+              " us");
+
+    ++window_frames;
+    window_cpu_submit_time += cpu_submit_time;
+    window_gpu_completion_time += gpu_completion_time;
+    window_present_latency += present_latency;
+    window_max_present_latency = std::max(window_max_present_latency, present_latency);
+
+    free_queries.push_back(std::move(frame.completion_query));
+    frames.pop_front();
+}
+
+void jkgm::frame_fence_queue::begin_frame()
+{
+    while(!frames.empty() &&
+          (frames.size() >= max_frames_in_flight || gl::is_fence_signaled(frames.front().fence))) {
+        retire_front();
+    }
+
+    cpu_begin = clock::now();
+}
+
+void jkgm::frame_fence_queue::end_frame()
+{
+    if(free_queries.empty()) {
+        free_queries.emplace_back();
+    }
+
+    auto completion_query = std::move(free_queries.back());
+    free_queries.pop_back();
+
+    auto cpu_submitted = clock::now();
+    auto gpu_submitted = gl::get_timestamp();
+    gl::query_timestamp(completion_query);
+
+    frames.push_back(frame_in_flight{
+        gl::fence(), std::move(completion_query), cpu_begin, cpu_submitted, gpu_submitted});
+}
+
+std::optional<jkgm::frame_latency_stats> jkgm::frame_fence_queue::take_stats()
+{
+    if(window_frames < frames_per_stats_window) {
+        return std::nullopt;
+    }
+
+    auto n = static_cast<double>(window_frames);
+
+    frame_latency_stats rv;
+    rv.num_frames = window_frames;
+    rv.mean_cpu_submit_time = window_cpu_submit_time / n;
+    rv.mean_gpu_completion_time = window_gpu_completion_time / n;
+    rv.mean_present_latency = window_present_latency / n;
+    rv.max_present_latency = window_max_present_latency;
+
+    window_frames = 0;
+    window_cpu_submit_time = 0.0;
+    window_gpu_completion_time = 0.0;
+    window_present_latency = 0.0;
+    window_max_present_latency = 0.0;
+
+    return rv;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "glutil/query.hpp"
+#include "glutil/sync.hpp"
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace jkgm {
+    // Latency over a reporting window, in microseconds
+    class frame_latency_stats {
+    public:
+        int num_frames = 0;
+        double mean_cpu_submit_time = 0.0;
+        double mean_gpu_completion_time = 0.0;
+        double mean_present_latency = 0.0;
+        double max_present_latency = 0.0;
+    };
+
+    // Fences every presented frame and blocks before starting a new frame while
+    // max_frames_in_flight frames are still unfinished on the GPU. Without this, the driver may
+    // queue several frames behind SwapBuffers, each adding a frame of input latency.
+    //
+    // Each frame is measured from the moment the renderer starts accepting it:
+    // - CPU submit time runs until SwapBuffers returns
+    // - GPU completion time runs from SwapBuffers returning until the GPU finishes the frame
+    // - Present latency is their sum. It does not include scanout.
+    class frame_fence_queue {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct frame_in_flight {
+            gl::fence fence;
+            gl::query completion_query;
+            clock::time_point cpu_begin;
+            clock::time_point cpu_submitted;
+            uint64_t gpu_submitted = 0U;
+        };
+
+        size_t max_frames_in_flight;
+        std::deque<frame_in_flight> frames;
+        std::vector<gl::query> free_queries;
+        clock::time_point cpu_begin;
+
+        int window_frames = 0;
+        double window_cpu_submit_time = 0.0;
+        double window_gpu_completion_time = 0.0;
+        double window_present_latency = 0.0;
+        double window_max_present_latency = 0.0;
+
+        void retire_front();
+
+    public:
+        explicit frame_fence_queue(size_t max_frames_in_flight);
+
+        // Blocks until fewer than max_frames_in_flight frames are unfinished
+        void begin_frame();
+
+        // Fences the frame. Call immediately after SwapBuffers.
+        void end_frame();
+
+        // Returns latency statistics once a full reporting window has been measured
+        std::optional<frame_latency_stats> take_stats();
+    };
+}
@@ -0,0 +1,69 @@
+#include "frame_limiter.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace jkgm {
+    namespace {
+        constexpr auto initial_sleep_margin = std::chrono::microseconds(2000);
+        constexpr auto min_sleep_margin = std::chrono::microseconds(250);
+    }
+}
+
+jkgm::frame_limiter::frame_limiter(double max_frame_rate)
+    : frame_interval(std::chrono::duration_cast<clock::duration>(
+          std::chrono::duration<double>(1.0 / max_frame_rate)))
+    , sleep_margin(initial_sleep_margin)
+{
+}
+
+void jkgm::frame_limiter::wait()
+{
+    auto now = clock::now();
+
+    if(has_deadline && now < next_deadline) {
+        if((next_deadline - now) > sleep_margin) {
+            auto sleep_target = next_deadline - sleep_margin;
+            std::this_thread::sleep_until(sleep_target);
+
+            // Grow the margin to cover the worst oversleep immediately, and shrink it slowly
+            auto oversleep = clock::now() - sleep_target;
+            sleep_margin = std::max({oversleep + oversleep / 4,
+                                     sleep_margin - sleep_margin / 64,
+                                     clock::duration(min_sleep_margin)});
+        }
+
+        while(clock::now() < next_deadline) {
+            std::this_thread::yield();
+        }
+
+        now = clock::now();
+    }
+
+    // Deadlines advance by whole intervals so that small overshoots do not accumulate into
+    // drift. Catching up a larger delay would produce a short frame right after a long one, so
+    // pacing restarts from the current time instead.
+    if(!has_deadline || (now - next_deadline) > (frame_interval / 8)) {
+        next_deadline = now + frame_interval;
+        has_deadline = true;
+    }
+    else {
+        next_deadline += frame_interval;
+    }
+
+    record_frame(now);
+}
+
+void jkgm::frame_limiter::record_frame(clock::time_point now)
+{
+    if(has_last_frame) {
+        pacing.add_frame(std::chrono::duration<double, std::micro>(now - last_frame).count());
+    }
+
+    last_frame = now;
+    has_last_frame = true;
+}
+
+std::optional<jkgm::frame_pacing_stats> jkgm::frame_limiter::take_stats()
+{
+    return pacing.take_stats();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/frame_pacing.hpp"
+#include <chrono>
+#include <optional>
+
+namespace jkgm {
+    // Caps the frame rate. Waits sleep until shortly before the deadline and then spin, because
+    // OS sleeps routinely overshoot by a millisecond or more. The spin margin adapts to the
+    // largest recently observed oversleep.
+    class frame_limiter {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        clock::duration frame_interval;
+        clock::duration sleep_margin;
+        clock::time_point next_deadline;
+        bool has_deadline = false;
+
+        clock::time_point last_frame;
+        bool has_last_frame = false;
+        frame_pacing_accumulator pacing;
+
+        void record_frame(clock::time_point now);
+
+    public:
+        explicit frame_limiter(double max_frame_rate);
+
+        // Blocks until the next frame is due
+        void wait();
+
+        // Returns pacing statistics once a full reporting window has been measured
+        std::optional<frame_pacing_stats> take_stats();
+    };
+}
@@ -0,0 +1,40 @@
+#include "gpu_timer.hpp"
+
+void jkgm::gpu_timer::begin()
+{
+    if(num_pending == num_queries) {
+        return;
+    }
+
+    gl::begin_query(gl::query_target::time_elapsed, queries[next_query]);
+    is_active = true;
+}
+
+void jkgm::gpu_timer::end()
+{
+    if(!is_active) {
+        return;
+    }
+
+    gl::end_query(gl::query_target::time_elapsed);
+    is_active = false;
+
+    next_query = (next_query + 1U) % num_queries;
+    ++num_pending;
+}
+
+std::optional<double> jkgm::gpu_timer::poll()
+{
+    std::optional<double> rv;
+    while(num_pending > 0U) {
+        auto const &q = queries[(next_query + num_queries - num_pending) % num_queries];
+        if(!gl::is_query_result_available(q)) {
+            break;
+        }
+
+        rv = static_cast<double>(gl::get_query_result(q)) / 1000000.0;
+        --num_pending;
+    }
+
+    return rv;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "glutil/query.hpp"
+#include <array>
+#include <optional>
+
+namespace jkgm {
+    // Measures GPU time spent between begin and end. Results are read several frames later so
+    // that polling never stalls the pipeline.
+    class gpu_timer {
+    private:
+        static constexpr size_t num_queries = 4U;
+
+        std::array<gl::query, num_queries> queries;
+        size_t next_query = 0U;
+        size_t num_pending = 0U;
+        bool is_active = false;
+
+    public:
+        // Does nothing when every query is still in flight. That frame is not measured.
+        void begin();
+        void end();
+
+        // Returns the most recent completed measurement in milliseconds, if any completed
+        std::optional<double> poll();
+    };
+}
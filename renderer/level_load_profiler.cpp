@@ -0,0 +1,107 @@
+#include "level_load_profiler.hpp"
+#include "common/json_incl.hpp"
+
+namespace jkgm {
+    namespace {
+        constexpr char const *phase_names[num_level_load_phases] = {"md5",
+                                                                    "material_lookup",
+                                                                    "file_read",
+                                                                    "image_decode",
+                                                                    "srgb_conversion",
+                                                                    "texture_upload"};
+
+        int64_t to_microseconds(std::chrono::steady_clock::duration d)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        }
+    }
+}
+
+void jkgm::level_load_profiler::begin_texture()
+{
+    std::lock_guard<std::mutex> lk(lock);
+
+    if(!is_loading) {
+        is_loading = true;
+        load_begin = clock::now();
+        phase_times.fill(clock::duration::zero());
+        num_textures = 0U;
+        num_replacement_hits = 0U;
+        num_replacement_misses = 0U;
+        upload_bytes = 0U;
+    }
+
+    ++num_textures;
+}
+
+void jkgm::level_load_profiler::add_phase_time(level_load_phase phase, clock::duration time)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(is_loading) {
+        phase_times[static_cast<size_t>(phase)] += time;
+    }
+}
+
+void jkgm::level_load_profiler::add_replacement_lookup(bool is_hit)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(is_loading) {
+        ++(is_hit ? num_replacement_hits : num_replacement_misses);
+    }
+}
+
+void jkgm::level_load_profiler::add_upload_bytes(size_t bytes)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(is_loading) {
+        upload_bytes += bytes;
+    }
+}
+
+std::optional<std::string>
+    jkgm::level_load_profiler::end_load(std::vector<std::string> const &material_packs)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(!is_loading) {
+        return std::nullopt;
+    }
+
+    is_loading = false;
+
+    json::json phases = json::json::object();
+    for(size_t i = 0; i < num_level_load_phases; ++i) {
+        phases[phase_names[i]] = to_microseconds(phase_times[i]);
+    }
+
+    json::json j;
+    j["wall_time_us"] = to_microseconds(clock::now() - load_begin);
+    j["textures"] = num_textures;
+    j["replacement_hits"] = num_replacement_hits;
+    j["replacement_misses"] = num_replacement_misses;
+    j["upload_bytes"] = upload_bytes;
+    j["phase_time_us"] = phases;
+    j["material_packs"] = material_packs;
+
+    return j.dump();
+}
+
+jkgm::level_load_phase_scope::level_load_phase_scope(level_load_profiler *profiler,
+                                                     level_load_phase phase)
+    : profiler(profiler)
+    , phase(phase)
+{
+    if(profiler) {
+        begin = std::chrono::steady_clock::now();
+    }
+}
+
+jkgm::level_load_phase_scope::~level_load_phase_scope()
+{
+    if(profiler) {
+        profiler->add_phase_time(phase, std::chrono::steady_clock::now() - begin);
+    }
+}
+
+static_assert(static_cast<size_t>(jkgm::level_load_phase::texture_upload) + 1U ==
+                  jkgm::num_level_load_phases,
+              "phase_names must cover every level_load_phase");
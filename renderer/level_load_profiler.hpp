@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    enum class level_load_phase {
+        md5,
+        material_lookup,
+        file_read,
+        image_decode,
+        srgb_conversion,
+        texture_upload
+    };
+
+    constexpr size_t num_level_load_phases = 6U;
+
+    // Aggregates the cost of texture loading. A load begins with the first texture JK loads
+    // after a game frame, and ends when the next game frame is presented.
+    //
+    // Textures are loaded on the game thread, while file reads, decodes and uploads run on the
+    // render thread.
+    class level_load_profiler {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        std::mutex lock;
+        bool is_loading = false;
+        clock::time_point load_begin;
+        std::array<clock::duration, num_level_load_phases> phase_times{};
+        size_t num_textures = 0U;
+        size_t num_replacement_hits = 0U;
+        size_t num_replacement_misses = 0U;
+        size_t upload_bytes = 0U;
+
+    public:
+        // Begins a load, if none is in progress, and counts one texture
+        void begin_texture();
+
+        void add_phase_time(level_load_phase phase, clock::duration time);
+        void add_replacement_lookup(bool is_hit);
+        void add_upload_bytes(size_t bytes);
+
+        // Ends the load in progress. Returns its summary as a single-line JSON object, or
+        // nothing when no load was in progress.
+        std::optional<std::string> end_load(std::vector<std::string> const &material_packs);
+    };
+
+    // Adds the lifetime of the scope to a load phase. Does nothing when profiler is null.
+    class level_load_phase_scope {
+    private:
+        level_load_profiler *profiler;
+        level_load_phase phase;
+        std::chrono::steady_clock::time_point begin;
+
+    public:
+        level_load_phase_scope(level_load_profiler *profiler, level_load_phase phase);
+        ~level_load_phase_scope();
+
+        level_load_phase_scope(level_load_phase_scope const &) = delete;
+        level_load_phase_scope(level_load_phase_scope &&) = delete;
+        level_load_phase_scope &operator=(level_load_phase_scope const &) = delete;
+        level_load_phase_scope &operator=(level_load_phase_scope &&) = delete;
+    };
+}
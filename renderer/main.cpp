@@ -181,6 +181,18 @@ LONG WINAPI HookedChangeDisplaySettingsW(DEVMODEW *lpDevMode, DWORD dwFlags)
     return TrueChangeDisplaySettingsW(lpDevMode, dwFlags);
 }
 
+using ExitProcess_type = VOID(WINAPI *)(UINT uExitCode);
+static ExitProcess_type TrueExitProcess = nullptr;
+VOID WINAPI HookedExitProcess(UINT uExitCode)
+{
+    // Runs before DLL detach, while the loader lock is free and the render thread is still alive
+    if(the_renderer) {
+        the_renderer->on_process_exit();
+    }
+
+    TrueExitProcess(uExitCode);
+}
+
 bool attach_hooks()
 {
     DetourRestoreAfterWith();
@@ -227,6 +239,9 @@ bool attach_hooks()
         (ChangeDisplaySettingsW_type)DetourFindFunction("user32.dll", "ChangeDisplaySettingsW");
     DetourAttach(&(PVOID &)TrueChangeDisplaySettingsW, HookedChangeDisplaySettingsW);
 
+    TrueExitProcess = (ExitProcess_type)DetourFindFunction("kernel32.dll", "ExitProcess");
+    DetourAttach(&(PVOID &)TrueExitProcess, HookedExitProcess);
+
     LONG error = DetourTransactionCommit();
     return error == NO_ERROR;
 }
@@ -247,6 +262,7 @@ bool detach_hooks()
     DetourDetach(&(PVOID &)TrueDeleteObject, HookedDeleteObject);
     DetourDetach(&(PVOID &)TrueChangeDisplaySettingsA, HookedChangeDisplaySettingsA);
     DetourDetach(&(PVOID &)TrueChangeDisplaySettingsW, HookedChangeDisplaySettingsW);
+    DetourDetach(&(PVOID &)TrueExitProcess, HookedExitProcess);
 
     LONG error = DetourTransactionCommit();
     return error == NO_ERROR;
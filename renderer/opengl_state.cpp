@@ -3,72 +3,223 @@
 #include "base/log.hpp"
 #include "base/memory_block.hpp"
 #include "common/error_reporter.hpp"
+#include <algorithm>
 #include <random>
 
-jkgm::gl::shader jkgm::compile_shader_from_file(fs::path const &filename, gl::shader_type type)
-{
-    diagnostic_context dc(filename.generic_string());
-    gl::shader rv(type);
+namespace jkgm {
+    namespace {
+        std::string load_shader_source(fs::path const &filename)
+        {
+            diagnostic_context dc(filename.generic_string());
+
+            memory_block mb;
+
+            try {
+                auto fs = make_file_input_stream(filename);
+                memory_output_block mob(&mb);
+                fs->copy_to(&mob);
+            }
+            catch(std::exception const &e) {
+                LOG_ERROR("Failed to load shader: ", e.what());
+                report_error_message(
+                    str(format("JkGfxMod could not open an essential file and cannot "
+                               "continue.\n\nDetails: Error while opening ",
+                               filename.generic_string(),
+                               "\n",
+                               e.what())));
+                abort();
+            }
+
+            return std::string(mb.str());
+        }
 
-    memory_block mb;
+        gl::shader begin_compile_shader(std::string_view src,
+                                        gl::shader_type type,
+                                        std::vector<std::string> const &defines)
+        {
+            gl::shader rv(type);
+
+            // Defines must follow the #version directive. Split the source after the first line
+            // and reset the line counter so that compiler messages still refer to the file on
+            // disk.
+            std::string prefix;
+            if(!defines.empty()) {
+                auto first_line_end = src.find('\n');
+                if(first_line_end == std::string_view::npos) {
+                    first_line_end = src.size();
+                }
+                else {
+                    ++first_line_end;
+                }
+
+                prefix = std::string(src.substr(0, first_line_end));
+                src = src.substr(first_line_end);
+
+                for(auto const &def : defines) {
+                    prefix.append("#define ");
+                    prefix.append(def);
+                    prefix.append("\n");
+                }
+
+                prefix.append("#line 2\n");
+            }
+
+            gl::shader_source(rv, make_span(prefix), make_span(src));
+            gl::compile_shader(rv);
+
+            return rv;
+        }
+
+        void check_shader_compile_status(fs::path const &filename, gl::shader_view shader)
+        {
+            if(!gl::get_shader_compile_status(shader)) {
+                diagnostic_context dc(filename.generic_string());
+
+                auto err_str = gl::get_shader_info_log(shader);
+                LOG_ERROR("Failed to compile shader: ", err_str);
+                report_error_message(str(format(
+                    "JkGfxMod failed to compile an essential shader. This may have happened "
+                    "because your graphics device does not support OpenGL 3.3, because the shader "
+                    "file has been incorrectly modified, or because of a bug in JkGfxMod.\n\n"
+                    "Details: Failed to compile ",
+                    filename.generic_string(),
+                    "\n",
+                    err_str)));
+                abort();
+            }
+        }
 
-    try {
-        auto fs = make_file_input_stream(filename);
-        memory_output_block mob(&mb);
-        fs->copy_to(&mob);
+        void check_program_link_status(std::string const &name, gl::program_view prog)
+        {
+            if(!gl::get_program_link_status(prog)) {
+                auto err_str = gl::get_program_info_log(prog);
+                LOG_ERROR("Failed to link program ", name, ": ", err_str);
+                report_error_message(str(format(
+                    "JkGfxMod failed to link an essential shader. This may have happened because "
+                    "your graphics device does not support OpenGL 3.3, because the shader files "
+                    "have been incorrectly modified, or because of a bug in JkGfxMod.\n\n"
+                    "Details: Failed to link ",
+                    name,
+                    "\n",
+                    err_str)));
+                abort();
+            }
+        }
     }
-    catch(std::exception const &e) {
-        LOG_ERROR("Failed to load shader: ", e.what());
-        report_error_message(str(format("JkGfxMod could not open an essential file and cannot "
-                                        "continue.\n\nDetails: Error while opening ",
-                                        filename.generic_string(),
-                                        "\n",
-                                        e.what())));
-        abort();
+}
+
+jkgm::program_linker::program_linker(program_cache *cache)
+    : cache(cache)
+{
+    if(gl::has_parallel_shader_compile_support()) {
+        // Let the driver pick the number of compiler threads
+        gl::set_max_shader_compiler_threads(0xFFFFFFFFU);
+    }
+}
+
+void jkgm::program_linker::link_program_from_files(
+    std::string const &name,
+    gl::program *prog,
+    fs::path const &vx,
+    fs::path const &fg,
+    std::vector<std::string> const &defines,
+    std::function<void(gl::program_view)> on_linked)
+{
+    auto vx_src = load_shader_source(vx);
+    auto fg_src = load_shader_source(fg);
+
+    pending_program pp;
+    pp.name = name;
+    pp.prog = prog;
+    pp.on_linked = std::move(on_linked);
+
+    gl::set_object_label(*prog, name);
+
+    auto key = cache->make_key(vx_src, fg_src, defines);
+    if(cache->load(key, *prog)) {
+        LOG_TRACE("Loaded program ", name, " from cache");
+        ++num_cached;
+        pending.push_back(std::move(pp));
+        return;
     }
 
-    gl::shader_source(rv, make_string_span(""), make_span(mb.str()));
-    gl::compile_shader(rv);
-    if(!gl::get_shader_compile_status(rv)) {
-        auto err_str = gl::get_shader_info_log(rv);
-        LOG_ERROR("Failed to compile shader: ", err_str);
-        report_error_message(str(format(
-            "JkGfxMod failed to compile an essential shader. This may have happened because your "
-            "graphics device does not support OpenGL 3.3, because the shader file has been "
-            "incorrectly modified, or because of a bug in JkGfxMod.\n\nDetails: Failed to compile ",
-            filename.generic_string(),
-            "\n",
-            err_str)));
-        abort();
+    // Compile and link without checking status. The driver may be compiling other programs in
+    // parallel, and status queries force it to finish.
+    pp.cache_key = key;
+    pp.shaders.emplace_back(vx, begin_compile_shader(vx_src, gl::shader_type::vertex, defines));
+    pp.shaders.emplace_back(fg,
+                            begin_compile_shader(fg_src, gl::shader_type::fragment, defines));
+
+    for(auto const &shader : pp.shaders) {
+        gl::attach_shader(*prog, std::get<1>(shader));
     }
 
-    return rv;
+    cache->prepare_link(*prog);
+    gl::link_program(*prog);
+
+    pending.push_back(std::move(pp));
 }
 
-void jkgm::link_program_from_files(std::string const &name,
-                                   gl::program *prog,
-                                   fs::path const &vx,
-                                   fs::path const &fg)
+void jkgm::program_linker::finish()
 {
-    auto vx_shader = compile_shader_from_file(vx, gl::shader_type::vertex);
-    auto fg_shader = compile_shader_from_file(fg, gl::shader_type::fragment);
+    for(auto &pp : pending) {
+        if(pp.cache_key.has_value()) {
+            for(auto const &shader : pp.shaders) {
+                check_shader_compile_status(std::get<0>(shader), std::get<1>(shader));
+            }
+
+            check_program_link_status(pp.name, *pp.prog);
+            cache->store(*pp.cache_key, *pp.prog);
+        }
 
-    gl::attach_shader(*prog, vx_shader);
-    gl::attach_shader(*prog, fg_shader);
+        if(pp.on_linked) {
+            pp.on_linked(*pp.prog);
+        }
+    }
 
-    gl::link_program(*prog);
+    LOG_DEBUG("Linked ", pending.size(), " programs (", num_cached, " from cache)");
+
+    pending.clear();
+    num_cached = 0U;
+}
+
+void jkgm::link_game_programs_from_files(program_linker *linker,
+                                         std::string const &name,
+                                         game_program_set *progs,
+                                         fs::path const &vx,
+                                         fs::path const &fg,
+                                         config const *the_config,
+                                         std::vector<std::string> const &extra_defines)
+{
+    for(size_t i = 0; i < progs->size(); ++i) {
+        std::vector<std::string> defines = extra_defines;
+        if(i & game_shader_variant::parallax) {
+            defines.push_back("PARALLAX_MAPPING");
+        }
 
-    if(!gl::get_program_link_status(*prog)) {
-        auto err_str = gl::get_program_info_log(*prog);
-        LOG_ERROR("Failed to link program ", name, ": ", gl::get_program_info_log(*prog));
-        report_error_message(str(format(
-            "JkGfxMod failed to link an essential shader. This may have happened because your "
-            "graphics device does not support OpenGL 3.3, because the shader files have been "
-            "incorrectly modified, or because of a bug in JkGfxMod.\n\nDetails: Failed to link ",
-            name,
-            "\n",
-            err_str)));
-        abort();
+        if(i & game_shader_variant::alpha_mask) {
+            defines.push_back("ALPHA_MASK");
+        }
+
+        if(the_config->enable_posterized_lighting) {
+            defines.push_back("POSTERIZE_LIGHTING");
+        }
+
+        linker->link_program_from_files(
+            str(format(name, "[", i, "]")),
+            &(*progs)[i],
+            vx,
+            fg,
+            defines,
+            [i](gl::program_view prog) {
+                // Sampler bindings never change. Assign them once instead of once per pass.
+                gl::use_program(prog);
+                gl::set_uniform_integer(gl::uniform_location_id(2), 0);
+                gl::set_uniform_integer(gl::uniform_location_id(4), 1);
+                if(i & game_shader_variant::parallax) {
+                    gl::set_uniform_integer(gl::uniform_location_id(7), 2);
+                }
+            });
     }
 }
 
@@ -279,14 +430,17 @@ jkgm::hud_model::hud_model(size<2, int> scr_res,
     num_indices = indices.size();
 }
 
-jkgm::render_depthbuffer::render_depthbuffer(size<2, int> dims)
+jkgm::render_depthbuffer::render_depthbuffer(size<2, int> dims, std::string_view name)
     : viewport(make_point(0, 0), dims)
 {
     gl::bind_renderbuffer(rbo);
     gl::renderbuffer_storage(gl::renderbuffer_format::depth, dims);
+    gl::set_object_label(rbo, name);
 }
 
-jkgm::render_buffer::render_buffer(size<2, int> dims, render_depthbuffer *rbo)
+jkgm::render_buffer::render_buffer(size<2, int> dims,
+                                   render_depthbuffer *rbo,
+                                   std::string_view name)
     : viewport(make_point(0, 0), dims)
 {
     gl::bind_framebuffer(gl::framebuffer_bind_target::any, fbo);
@@ -318,6 +472,11 @@ jkgm::render_buffer::render_buffer(size<2, int> dims, render_depthbuffer *rbo)
         LOG_ERROR("Failed to create render framebuffer: ", static_cast<int>(fbs));
     }
 
+    if(gl::has_debug_annotation_support()) {
+        gl::set_object_label(fbo, name);
+        gl::set_object_label(tex, str(format(name, ".color")));
+    }
+
     gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
 }
 
@@ -391,15 +550,34 @@ jkgm::render_gbuffer::render_gbuffer(size<2, int> dims, render_depthbuffer *rbo)
         LOG_ERROR("Failed to create render framebuffer: ", static_cast<int>(fbs));
     }
 
+    gl::set_object_label(fbo, "gbuffer");
+    gl::set_object_label(color_tex, "gbuffer.color");
+    gl::set_object_label(emissive_tex, "gbuffer.emissive");
+    gl::set_object_label(depth_nrm_tex, "gbuffer.depth_nrm");
+
     gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
 }
 
-jkgm::ssao_occlusion_buffer::ssao_occlusion_buffer(size<2, int> dims)
+jkgm::render_oit_buffer::render_oit_buffer(size<2, int> dims, render_depthbuffer *rbo)
     : viewport(make_point(0, 0), dims)
 {
     gl::bind_framebuffer(gl::framebuffer_bind_target::any, fbo);
 
-    gl::bind_texture(gl::texture_bind_target::texture_2d, tex);
+    // Set up accumulation texture:
+    gl::bind_texture(gl::texture_bind_target::texture_2d, accum_tex);
+    gl::tex_image_2d(gl::texture_bind_target::texture_2d,
+                     /*level*/ 0,
+                     gl::texture_internal_format::rgba16f,
+                     dims,
+                     gl::texture_pixel_format::rgba,
+                     gl::texture_pixel_type::float32,
+                     span<char const>(nullptr, 0U));
+    gl::set_texture_max_level(gl::texture_bind_target::texture_2d, 0U);
+    gl::framebuffer_texture(
+        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color0, accum_tex, 0);
+
+    // Set up weight texture:
+    gl::bind_texture(gl::texture_bind_target::texture_2d, weight_tex);
     gl::tex_image_2d(gl::texture_bind_target::texture_2d,
                      /*level*/ 0,
                      gl::texture_internal_format::r16f,
@@ -408,36 +586,11 @@ jkgm::ssao_occlusion_buffer::ssao_occlusion_buffer(size<2, int> dims)
                      gl::texture_pixel_type::float32,
                      span<char const>(nullptr, 0U));
     gl::set_texture_max_level(gl::texture_bind_target::texture_2d, 0U);
-    gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::linear);
-    gl::set_texture_min_filter(gl::texture_bind_target::texture_2d, gl::min_filter::linear);
-    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
-                              gl::texture_direction::s,
-                              gl::texture_wrap_mode::clamp_to_edge);
-    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
-                              gl::texture_direction::t,
-                              gl::texture_wrap_mode::clamp_to_edge);
-
     gl::framebuffer_texture(
-        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color0, tex, 0);
-
-    gl::draw_buffers(gl::draw_buffer::color0);
-
-    auto fbs = gl::check_framebuffer_status(gl::framebuffer_bind_target::any);
-    if(gl::check_framebuffer_status(gl::framebuffer_bind_target::any) !=
-       gl::framebuffer_status::complete) {
-        gl::log_errors();
-        LOG_ERROR("Failed to create SSAO framebuffer: ", static_cast<int>(fbs));
-    }
+        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color1, weight_tex, 0);
 
-    gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
-}
-
-jkgm::post_buffer::post_buffer(size<2, int> dims)
-    : viewport(make_point(0, 0), dims)
-{
-    gl::bind_framebuffer(gl::framebuffer_bind_target::any, fbo);
-
-    gl::bind_texture(gl::texture_bind_target::texture_2d, tex);
+    // Set up emissive texture:
+    gl::bind_texture(gl::texture_bind_target::texture_2d, emissive_tex);
     gl::tex_image_2d(gl::texture_bind_target::texture_2d,
                      /*level*/ 0,
                      gl::texture_internal_format::rgba16f,
@@ -446,33 +599,32 @@ jkgm::post_buffer::post_buffer(size<2, int> dims)
                      gl::texture_pixel_type::float32,
                      span<char const>(nullptr, 0U));
     gl::set_texture_max_level(gl::texture_bind_target::texture_2d, 0U);
-    gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::linear);
-    gl::set_texture_min_filter(gl::texture_bind_target::texture_2d, gl::min_filter::linear);
-    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
-                              gl::texture_direction::s,
-                              gl::texture_wrap_mode::clamp_to_edge);
-    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
-                              gl::texture_direction::t,
-                              gl::texture_wrap_mode::clamp_to_edge);
-
     gl::framebuffer_texture(
-        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color0, tex, 0);
+        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color2, emissive_tex, 0);
 
-    gl::draw_buffers(gl::draw_buffer::color0);
+    // Share the opaque depth buffer so that opaque geometry occludes transparency:
+    gl::framebuffer_renderbuffer(
+        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::depth, rbo->rbo);
+
+    // Finish:
+    gl::draw_buffers(gl::draw_buffer::color0, gl::draw_buffer::color1, gl::draw_buffer::color2);
 
     auto fbs = gl::check_framebuffer_status(gl::framebuffer_bind_target::any);
-    if(gl::check_framebuffer_status(gl::framebuffer_bind_target::any) !=
-       gl::framebuffer_status::complete) {
+    if(fbs != gl::framebuffer_status::complete) {
         gl::log_errors();
         LOG_ERROR("Failed to create render framebuffer: ", static_cast<int>(fbs));
     }
 
+    gl::set_object_label(fbo, "oit");
+    gl::set_object_label(accum_tex, "oit.accum");
+    gl::set_object_label(weight_tex, "oit.weight");
+    gl::set_object_label(emissive_tex, "oit.emissive");
+
     gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
 }
 
 jkgm::hdr_stack_em::hdr_stack_em(size<2, int> dims, int num_passes, float weight)
-    : a(dims)
-    , b(dims)
+    : dims(dims)
     , num_passes(num_passes)
     , weight(weight)
 {
@@ -509,25 +661,21 @@ jkgm::triangle_buffer_model::triangle_buffer_model()
     gl::enable_vertex_attrib_array(2U);
     gl::vertex_attrib_pointer(/*index*/ 2,
                               /*elements*/ 4,
-                              gl::vertex_element_type::float32,
-                              /*normalized*/ false,
+                              gl::vertex_element_type::uint8,
+                              /*normalized*/ true,
                               /*stride*/ sizeof(triangle_buffer_vertex),
                               /*offset*/ offsetof(triangle_buffer_vertex, col));
-    gl::enable_vertex_attrib_array(3U);
-    gl::vertex_attrib_pointer(/*index*/ 3,
-                              /*elements*/ 3,
-                              gl::vertex_element_type::float32,
-                              /*normalized*/ false,
-                              /*stride*/ sizeof(triangle_buffer_vertex),
-                              /*offset*/ offsetof(triangle_buffer_vertex, normal));
 }
 
-void jkgm::triangle_buffer_model::maybe_grow_buffers(unsigned int new_capacity)
+bool jkgm::triangle_buffer_model::maybe_grow_buffers(unsigned int new_capacity,
+                                                     bool unsynchronized)
 {
     gl::bind_buffer(gl::buffer_bind_target::array, vbo);
 
+    bool grew = false;
     if(vb_capacity < new_capacity) {
         vb_capacity = new_capacity * 2;
+        grew = true;
 
         gl::bind_buffer(gl::buffer_bind_target::array, vbo);
         gl::buffer_reserve(gl::buffer_bind_target::array,
@@ -535,8 +683,15 @@ void jkgm::triangle_buffer_model::maybe_grow_buffers(unsigned int new_capacity)
                            gl::buffer_usage::stream_draw);
     }
 
+    flag_set<gl::buffer_access> access{gl::buffer_access::write};
+    if(unsynchronized) {
+        access += gl::buffer_access::unsynchronized;
+    }
+
     mmio = gl::map_buffer_range<triangle_buffer_vertex>(
-        gl::buffer_bind_target::array, 0, vb_capacity, {gl::buffer_access::write});
+        gl::buffer_bind_target::array, 0, vb_capacity, access);
+
+    return grew;
 }
 
 void jkgm::triangle_buffer_model::update_buffers()
@@ -547,9 +702,17 @@ void jkgm::triangle_buffer_model::update_buffers()
 
 jkgm::triangle_buffer_sequence::triangle_buffer_sequence()
 {
-    constexpr size_t num_buffers = 3;
     for(size_t i = 0; i < num_buffers; ++i) {
-        trimdls.emplace_back();
+        auto &em = trimdls.emplace_back();
+
+        if(gl::has_debug_annotation_support()) {
+            gl::set_object_label(em.world_trimdl.vao, str(format("triangles[", i, "].world")));
+            gl::set_object_label(em.world_transparent_trimdl.vao,
+                                 str(format("triangles[", i, "].world_transparent")));
+            gl::set_object_label(em.gun_trimdl.vao, str(format("triangles[", i, "].gun")));
+            gl::set_object_label(em.gun_transparent_trimdl.vao,
+                                 str(format("triangles[", i, "].gun_transparent")));
+        }
     }
 
     it = trimdls.begin();
@@ -584,53 +747,92 @@ jkgm::opengl_state::opengl_state::opengl_state(size<2, int> screen_res,
                                                config const *the_config)
     : menumdl(screen_res, actual_scr_area)
     , hudmdl(screen_res, internal_screen_res, actual_scr_area, the_config->hud_scale)
-    , shared_depthbuffer(screen_res)
-    , screen_renderbuffer(screen_res, &shared_depthbuffer)
-    , screen_postbuffer1(screen_res)
-    , screen_postbuffer2(screen_res)
-    , gbuffer(screen_res, &shared_depthbuffer)
+    , shared_depthbuffer(screen_res, "screen.depth")
+    , screen_renderbuffer(screen_res, &shared_depthbuffer, "screen")
+    , scene_res(screen_res)
+    , gbuffer(std::make_unique<render_gbuffer>(screen_res, &shared_depthbuffer))
 {
     LOG_DEBUG("Loading OpenGL assets");
 
     fs::path data_root(the_config->data_path);
 
-    link_program_from_files(
+    program_cache cache(data_root / "cache/programs");
+    program_linker linker(&cache);
+
+    linker.link_program_from_files(
         "menu", &menu_program, data_root / "shaders/menu.vert", data_root / "shaders/menu.frag");
 
-    link_program_from_files("game_opaque_pass",
-                            &game_opaque_pass_program,
-                            data_root / "shaders/game.vert",
-                            data_root / "shaders/game_opaque_pass.frag");
-    link_program_from_files("game_post_ssao",
-                            &game_post_ssao_program,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_ssao.frag");
-    link_program_from_files("game_post_opaque_composite",
-                            &game_post_opaque_composite_program,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_opaque_composite.frag");
-
-    link_program_from_files("game_transparency_pass",
-                            &game_transparency_pass_program,
-                            data_root / "shaders/game.vert",
-                            data_root / "shaders/game_trns_pass.frag");
-
-    link_program_from_files("post_gauss3",
-                            &post_gauss3,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_gauss3.frag");
-    link_program_from_files("post_gauss7",
-                            &post_gauss7,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_gauss7.frag");
-    link_program_from_files("post_low_pass",
-                            &post_low_pass,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_low_pass.frag");
-    link_program_from_files("post_to_srgb",
-                            &post_to_srgb,
-                            data_root / "shaders/postprocess.vert",
-                            data_root / "shaders/post_to_srgb.frag");
+    link_game_programs_from_files(&linker,
+                                  "game_opaque_pass",
+                                  &game_opaque_pass_programs,
+                                  data_root / "shaders/game.vert",
+                                  data_root / "shaders/game_opaque_pass.frag",
+                                  the_config);
+    link_game_programs_from_files(&linker,
+                                  "game_alpha_test_pass",
+                                  &game_alpha_test_pass_programs,
+                                  data_root / "shaders/game.vert",
+                                  data_root / "shaders/game_opaque_pass.frag",
+                                  the_config,
+                                  {"ALPHA_TEST"});
+    linker.link_program_from_files("game_post_ssao",
+                                   &game_post_ssao_program,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_ssao.frag");
+    linker.link_program_from_files("game_post_opaque_composite",
+                                   &game_post_opaque_composite_program,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_opaque_composite.frag");
+
+    link_game_programs_from_files(&linker,
+                                  "game_transparency_pass",
+                                  &game_transparency_pass_programs,
+                                  data_root / "shaders/game.vert",
+                                  data_root / "shaders/game_trns_pass.frag",
+                                  the_config);
+
+    if(the_config->transparency_mode == transparency_mode::weighted_blended) {
+        link_game_programs_from_files(&linker,
+                                      "game_oit_pass",
+                                      &game_oit_pass_programs,
+                                      data_root / "shaders/game.vert",
+                                      data_root / "shaders/game_trns_pass.frag",
+                                      the_config,
+                                      {"WEIGHTED_OIT"});
+        linker.link_program_from_files("game_post_oit_composite",
+                                       &game_post_oit_composite_program,
+                                       data_root / "shaders/postprocess.vert",
+                                       data_root / "shaders/post_oit_composite.frag");
+
+        oit_buffer = std::make_unique<render_oit_buffer>(screen_res, &shared_depthbuffer);
+    }
+
+    linker.link_program_from_files("post_gauss3",
+                                   &post_gauss3,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_gauss3.frag");
+    linker.link_program_from_files("post_gauss7",
+                                   &post_gauss7,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_gauss7.frag");
+    linker.link_program_from_files("post_low_pass",
+                                   &post_low_pass,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_low_pass.frag");
+    linker.link_program_from_files("post_to_srgb",
+                                   &post_to_srgb,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_to_srgb.frag");
+    linker.link_program_from_files("post_upscale",
+                                   &post_upscale,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_upscale.frag");
+    linker.link_program_from_files("post_sharpen",
+                                   &post_sharpen,
+                                   data_root / "shaders/postprocess.vert",
+                                   data_root / "shaders/post_sharpen.frag");
+
+    linker.finish();
 
     gl::bind_texture(gl::texture_bind_target::texture_2d, menu_texture);
     gl::tex_image_2d(gl::texture_bind_target::texture_2d,
@@ -649,6 +851,8 @@ jkgm::opengl_state::opengl_state::opengl_state(size<2, int> screen_res,
                               gl::texture_direction::t,
                               gl::texture_wrap_mode::clamp_to_edge);
 
+    gl::set_object_label(menu_texture, "menu");
+
     menu_texture_data.resize(640 * 480, color_rgba8::zero());
 
     gl::bind_texture(gl::texture_bind_target::texture_2d, hud_texture);
@@ -668,11 +872,22 @@ jkgm::opengl_state::opengl_state::opengl_state(size<2, int> screen_res,
                               gl::texture_direction::t,
                               gl::texture_wrap_mode::clamp_to_edge);
 
+    gl::set_object_label(hud_texture, "hud");
+
     hud_texture_data.resize(volume(internal_screen_res), color_rgba8::zero());
 
-    if(the_config->enable_ssao) {
-        ssao_occlusionbuffer = std::make_unique<ssao_occlusion_buffer>(screen_res);
+    if(the_config->enable_dynamic_render_scale) {
+        scene_timer = std::make_unique<gpu_timer>();
+    }
+
+    if(the_config->max_frames_in_flight > 0) {
+        frame_fences = std::make_unique<frame_fence_queue>(
+            std::min(static_cast<size_t>(the_config->max_frames_in_flight),
+                     triangle_buffer_sequence::num_buffers));
+    }
 
+    // The automatic quality mode may enable SSAO after startup
+    if(the_config->enable_ssao || the_config->quality == quality_mode::automatic) {
         std::uniform_real_distribution<float> ssao_noise_dist(0.0f, 1.0f);
         std::default_random_engine generator;
         std::vector<point<2, float>> ssao_noise;
@@ -694,5 +909,54 @@ jkgm::opengl_state::opengl_state::opengl_state(size<2, int> screen_res,
         gl::set_texture_max_level(gl::texture_bind_target::texture_2d, 0);
         gl::set_texture_min_filter(gl::texture_bind_target::texture_2d, gl::min_filter::nearest);
         gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::nearest);
+        gl::set_object_label(*ssao_noise_texture, "ssao_noise");
+    }
+
+    gl::set_object_label(postmdl.vao, "post");
+    gl::set_object_label(menumdl.vao, "menu");
+    gl::set_object_label(hudmdl.vao, "hud");
+}
+
+void jkgm::opengl_state::set_scene_resolution(size<2, int> res)
+{
+    if(res == scene_res) {
+        return;
     }
+
+    LOG_DEBUG("Scene resolution changed to ", get<x>(res), "x", get<y>(res));
+
+    scene_res = res;
+
+    render_depthbuffer *depth = &shared_depthbuffer;
+    if(res == screen_renderbuffer.viewport.size()) {
+        scene_renderbuffer.reset();
+        scene_depthbuffer.reset();
+    }
+    else {
+        scene_depthbuffer = std::make_unique<render_depthbuffer>(res, "scene.depth");
+        scene_renderbuffer =
+            std::make_unique<render_buffer>(res, scene_depthbuffer.get(), "scene");
+        depth = scene_depthbuffer.get();
+    }
+
+    gbuffer = std::make_unique<render_gbuffer>(res, depth);
+    if(oit_buffer) {
+        oit_buffer = std::make_unique<render_oit_buffer>(res, depth);
+    }
+
+    render_targets.trim();
+}
+
+bool jkgm::opengl_state::is_scene_scaled() const
+{
+    return scene_renderbuffer != nullptr;
+}
+
+jkgm::render_buffer &jkgm::opengl_state::get_scene_renderbuffer()
+{
+    if(scene_renderbuffer) {
+        return *scene_renderbuffer;
+    }
+
+    return screen_renderbuffer;
 }
\ No newline at end of file
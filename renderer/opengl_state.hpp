@@ -2,24 +2,74 @@
 
 #include "base/filesystem.hpp"
 #include "common/config.hpp"
+#include "core/triangle_buffer.hpp"
 #include "glutil/buffer.hpp"
+#include "glutil/debug.hpp"
 #include "glutil/framebuffer.hpp"
 #include "glutil/program.hpp"
 #include "glutil/renderbuffer.hpp"
 #include "glutil/shader.hpp"
 #include "glutil/texture.hpp"
 #include "glutil/vertex_array.hpp"
+#include "frame_fence_queue.hpp"
+#include "gpu_timer.hpp"
+#include "program_cache.hpp"
+#include "render_graph.hpp"
+#include <array>
+#include <functional>
 #include <map>
 #include <optional>
+#include <string>
+#include <tuple>
 #include <vector>
 
 namespace jkgm {
-    gl::shader compile_shader_from_file(fs::path const &filename, gl::shader_type type);
+    // Compiles and links programs in batches. Status checks are deferred until finish() so that
+    // drivers supporting GL_KHR_parallel_shader_compile can build every program concurrently.
+    class program_linker {
+    private:
+        struct pending_program {
+            std::string name;
+            gl::program *prog = nullptr;
+            std::vector<std::tuple<fs::path, gl::shader>> shaders;
+            std::optional<md5> cache_key;
+            std::function<void(gl::program_view)> on_linked;
+        };
+
+        program_cache *cache;
+        std::vector<pending_program> pending;
+        size_t num_cached = 0U;
+
+    public:
+        explicit program_linker(program_cache *cache);
+
+        void link_program_from_files(std::string const &name,
+                                     gl::program *prog,
+                                     fs::path const &vx,
+                                     fs::path const &fg,
+                                     std::vector<std::string> const &defines = {},
+                                     std::function<void(gl::program_view)> on_linked = nullptr);
+        void finish();
+    };
+
+    // Game pass shaders are specialized at compile time. Each flag enables a costly shader path
+    // that is only compiled into the variants used by materials that need it.
+    namespace game_shader_variant {
+        constexpr size_t parallax = 0x1U;
+        constexpr size_t alpha_mask = 0x2U;
+
+        constexpr size_t count = 0x4U;
+    }
+
+    using game_program_set = std::array<gl::program, game_shader_variant::count>;
 
-    void link_program_from_files(std::string const &name,
-                                 gl::program *prog,
-                                 fs::path const &vx,
-                                 fs::path const &fg);
+    void link_game_programs_from_files(program_linker *linker,
+                                       std::string const &name,
+                                       game_program_set *progs,
+                                       fs::path const &vx,
+                                       fs::path const &fg,
+                                       config const *the_config,
+                                       std::vector<std::string> const &extra_defines = {});
 
     class post_model {
     public:
@@ -62,7 +112,7 @@ namespace jkgm {
 
         box<2, int> viewport;
 
-        explicit render_depthbuffer(size<2, int> dims);
+        render_depthbuffer(size<2, int> dims, std::string_view name);
     };
 
     class render_buffer {
@@ -72,7 +122,7 @@ namespace jkgm {
 
         box<2, int> viewport;
 
-        render_buffer(size<2, int> dims, render_depthbuffer *rbo);
+        render_buffer(size<2, int> dims, render_depthbuffer *rbo, std::string_view name);
     };
 
     class render_gbuffer {
@@ -87,28 +137,24 @@ namespace jkgm {
         render_gbuffer(size<2, int> dims, render_depthbuffer *rbo);
     };
 
-    class ssao_occlusion_buffer {
+    // Weighted blended order-independent transparency targets. The accumulation target holds
+    // weighted premultiplied color in rgb and revealage in alpha. The weight target holds the sum
+    // of weighted coverage. The emissive target holds the unweighted sum of emitted light.
+    class render_oit_buffer {
     public:
         gl::framebuffer fbo;
-        gl::texture tex;
-        box<2, int> viewport;
-
-        explicit ssao_occlusion_buffer(size<2, int> dims);
-    };
+        gl::texture accum_tex;
+        gl::texture weight_tex;
+        gl::texture emissive_tex;
 
-    class post_buffer {
-    public:
-        gl::framebuffer fbo;
-        gl::texture tex;
         box<2, int> viewport;
 
-        explicit post_buffer(size<2, int> dims);
+        render_oit_buffer(size<2, int> dims, render_depthbuffer *rbo);
     };
 
     class hdr_stack_em {
     public:
-        post_buffer a;
-        post_buffer b;
+        size<2, int> dims;
         int num_passes;
         float weight;
 
@@ -122,13 +168,8 @@ namespace jkgm {
         hdr_stack();
     };
 
-    struct alignas(32) triangle_buffer_vertex {
-        point<4, float> pos;
-        point<2, float> texcoords;
-        jkgm::color col;
-        direction<3, float> normal;
-    };
-
+    // Color is sRGB with straight alpha and is decoded in game.vert. Normals are derived in the
+    // fragment shaders.
     class triangle_buffer_model {
     private:
         gl::buffer vbo;
@@ -142,7 +183,10 @@ namespace jkgm {
 
         triangle_buffer_model();
 
-        void maybe_grow_buffers(unsigned int new_capacity);
+        // Unsynchronized maps skip the driver's implicit wait. Only use them when a fence
+        // guarantees that the GPU has finished reading the buffer. Returns true when the buffer
+        // was reallocated.
+        bool maybe_grow_buffers(unsigned int new_capacity, bool unsynchronized);
         void update_buffers();
     };
 
@@ -154,6 +198,9 @@ namespace jkgm {
     };
 
     class triangle_buffer_sequence {
+    public:
+        static constexpr size_t num_buffers = 3U;
+
     private:
         std::vector<triangle_buffer_models> trimdls;
         std::vector<triangle_buffer_models>::iterator it;
@@ -169,6 +216,7 @@ namespace jkgm {
         size<2, int> dims;
         gl::texture handle;
         int refct = 0;
+        bool has_alpha = false;
         std::optional<fs::path> origin_filename;
 
         explicit srgb_texture(size<2, int> dims);
@@ -186,16 +234,21 @@ namespace jkgm {
     struct opengl_state {
         gl::program menu_program;
 
-        gl::program game_opaque_pass_program;
+        game_program_set game_opaque_pass_programs;
+        game_program_set game_alpha_test_pass_programs;
         gl::program game_post_ssao_program;
         gl::program game_post_opaque_composite_program;
 
-        gl::program game_transparency_pass_program;
+        game_program_set game_transparency_pass_programs;
+        game_program_set game_oit_pass_programs;
+        gl::program game_post_oit_composite_program;
 
         gl::program post_gauss3;
         gl::program post_gauss7;
         gl::program post_low_pass;
         gl::program post_to_srgb;
+        gl::program post_upscale;
+        gl::program post_sharpen;
 
         post_model postmdl;
         overlay_model menumdl;
@@ -208,18 +261,30 @@ namespace jkgm {
         gl::texture hud_texture;
         std::vector<color_rgba8> hud_texture_data;
 
-        std::unique_ptr<ssao_occlusion_buffer> ssao_occlusionbuffer;
         std::unique_ptr<gl::texture> ssao_noise_texture;
 
+        std::unique_ptr<gpu_timer> scene_timer;
+
+        // Present when the number of frames in flight is bounded. Never bounds more frames than
+        // there are triangle buffers, so triangle buffers are always idle when refilled.
+        std::unique_ptr<frame_fence_queue> frame_fences;
+
         render_depthbuffer shared_depthbuffer;
 
         render_buffer screen_renderbuffer;
-        post_buffer screen_postbuffer1;
-        post_buffer screen_postbuffer2;
 
-        render_gbuffer gbuffer;
+        // The 3D scene is drawn at scene_res. When it is smaller than the screen, the scene has
+        // its own color and depth buffers and is upscaled into the screen render buffer.
+        size<2, int> scene_res;
+        std::unique_ptr<render_depthbuffer> scene_depthbuffer;
+        std::unique_ptr<render_buffer> scene_renderbuffer;
+
+        std::unique_ptr<render_gbuffer> gbuffer;
+
+        std::unique_ptr<render_oit_buffer> oit_buffer;
 
         hdr_stack bloom_layers;
+        render_target_pool render_targets;
 
         std::vector<srgb_texture> srgb_textures;
         std::map<fs::path, size_t> file_to_srgb_texture_map;
@@ -231,5 +296,11 @@ namespace jkgm {
                      size<2, int> internal_screen_res,
                      box<2, int> actual_screen_area,
                      config const *the_config);
+
+        // Reallocates the scene targets when the resolution changes
+        void set_scene_resolution(size<2, int> res);
+
+        bool is_scene_scaled() const;
+        render_buffer &get_scene_renderbuffer();
     };
 }
\ No newline at end of file
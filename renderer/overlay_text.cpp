@@ -0,0 +1,165 @@
+#include "overlay_text.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace jkgm {
+    namespace {
+        constexpr int glyph_width = 5;
+        constexpr int glyph_height = 7;
+        constexpr int glyph_advance = glyph_width + 1;
+        constexpr int line_advance = glyph_height + 2;
+        constexpr int panel_padding = 2;
+
+        // Each row is 5 bits wide, most significant bit on the left
+        using glyph = std::array<uint8_t, glyph_height>;
+
+        struct glyph_entry {
+            char ch;
+            glyph rows;
+        };
+
+        constexpr glyph_entry font[] = {
+            {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+            {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+            {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+            {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+            {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+            {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+            {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+            {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+            {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+            {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+            {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+            {'A', {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}},
+            {'B', {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}},
+            {'C', {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}},
+            {'D', {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}},
+            {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+            {'F', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}},
+            {'G', {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}},
+            {'H', {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+            {'I', {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+            {'J', {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}},
+            {'K', {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}},
+            {'L', {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}},
+            {'M', {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}},
+            {'N', {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}},
+            {'O', {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+            {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+            {'Q', {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}},
+            {'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
+            {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+            {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+            {'U', {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+            {'V', {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}},
+            {'W', {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}},
+            {'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+            {'Y', {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}},
+            {'Z', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}},
+            {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+            {',', {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}},
+            {':', {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}},
+            {'%', {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}},
+            {'/', {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}},
+            {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+            {'_', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}},
+            {'(', {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}},
+            {')', {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}},
+            {'=', {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}},
+            {'+', {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}},
+            {'<', {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}},
+            {'>', {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}},
+            {'#', {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}},
+            {'?', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}}};
+
+        glyph const &get_glyph(char ch)
+        {
+            ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+            for(auto const &em : font) {
+                if(em.ch == ch) {
+                    return em.rows;
+                }
+            }
+
+            // Unknown characters are drawn as '?'
+            return std::end(font)[-1].rows;
+        }
+
+        void fill_rect(span<color_rgba8> image,
+                       size<2, int> image_dims,
+                       int x0,
+                       int y0,
+                       int x1,
+                       int y1,
+                       color_rgba8 col)
+        {
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, get<x>(image_dims));
+            y1 = std::min(y1, get<y>(image_dims));
+
+            for(int py = y0; py < y1; ++py) {
+                for(int px = x0; px < x1; ++px) {
+                    image.data()[py * get<x>(image_dims) + px] = col;
+                }
+            }
+        }
+    }
+}
+
+int jkgm::draw_overlay_text(span<color_rgba8> image,
+                            size<2, int> image_dims,
+                            point<2, int> origin,
+                            std::vector<std::string> const &lines,
+                            int scale)
+{
+    scale = std::max(scale, 1);
+
+    size_t max_line_length = 0U;
+    for(auto const &line : lines) {
+        max_line_length = std::max(max_line_length, line.size());
+    }
+
+    int panel_width =
+        (static_cast<int>(max_line_length) * glyph_advance + panel_padding * 2) * scale;
+    int panel_height = (static_cast<int>(lines.size()) * line_advance + panel_padding * 2) * scale;
+
+    int ox = get<x>(origin);
+    int oy = get<y>(origin);
+
+    fill_rect(image,
+              image_dims,
+              ox,
+              oy,
+              ox + panel_width,
+              oy + panel_height,
+              color_rgba8(uint8_t(0U), uint8_t(0U), uint8_t(0U), uint8_t(160U)));
+
+    auto text_color = color_rgba8::fill(255U);
+
+    int line_y = oy + panel_padding * scale;
+    for(auto const &line : lines) {
+        int glyph_x = ox + panel_padding * scale;
+        for(char ch : line) {
+            auto const &rows = get_glyph(ch);
+            for(int row = 0; row < glyph_height; ++row) {
+                for(int col = 0; col < glyph_width; ++col) {
+                    if((rows[row] & (0x10 >> col)) == 0) {
+                        continue;
+                    }
+
+                    int px = glyph_x + col * scale;
+                    int py = line_y + row * scale;
+                    fill_rect(image, image_dims, px, py, px + scale, py + scale, text_color);
+                }
+            }
+
+            glyph_x += glyph_advance * scale;
+        }
+
+        line_y += line_advance * scale;
+    }
+
+    return oy + panel_height;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "base/span.hpp"
+#include "math/color.hpp"
+#include "math/point.hpp"
+#include "math/size.hpp"
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    // Draws lines of text on a translucent panel in an RGBA image, using a built-in 5x7 pixel
+    // font enlarged by scale. Lowercase letters are drawn as capitals. Returns the y coordinate
+    // just below the panel, so that panels can be stacked.
+    int draw_overlay_text(span<color_rgba8> image,
+                          size<2, int> image_dims,
+                          point<2, int> origin,
+                          std::vector<std::string> const &lines,
+                          int scale);
+}
@@ -0,0 +1,156 @@
+#include "program_cache.hpp"
+#include "base/file_stream.hpp"
+#include "base/log.hpp"
+#include "base/memory_block.hpp"
+#include "glutil/gl.hpp"
+#include <cstring>
+
+namespace jkgm {
+    namespace {
+        constexpr uint32_t program_cache_version = 1U;
+
+        struct program_cache_header {
+            char magic[4] = {'J', 'K', 'P', 'B'};
+            uint32_t version = program_cache_version;
+            uint32_t binary_format = 0U;
+            uint32_t binary_length = 0U;
+        };
+
+        void add_key_part(md5_hasher *mh, std::string_view part)
+        {
+            uint32_t len = static_cast<uint32_t>(part.size());
+            mh->add(make_span(&len, 1).as_const_bytes());
+            mh->add(make_span(part));
+        }
+    }
+}
+
+jkgm::program_cache::program_cache(fs::path const &cache_path)
+    : cache_path(cache_path)
+{
+    if(!gl::has_program_binary_support()) {
+        LOG_INFO("Program binary cache disabled: no program binary formats are available");
+        return;
+    }
+
+    context_signature = str(format(gl::get_string(gl::string_name::vendor),
+                                   "\n",
+                                   gl::get_string(gl::string_name::renderer),
+                                   "\n",
+                                   gl::get_string(gl::string_name::version)));
+
+    std::error_code ec;
+    fs::create_directories(cache_path, ec);
+    if(ec) {
+        LOG_WARNING("Program binary cache disabled: could not create ",
+                    cache_path.generic_string(),
+                    ": ",
+                    ec.message());
+        return;
+    }
+
+    enabled = true;
+}
+
+fs::path jkgm::program_cache::get_entry_path(md5 const &key) const
+{
+    return cache_path / (static_cast<std::string>(key) + ".bin");
+}
+
+jkgm::md5 jkgm::program_cache::make_key(std::string_view vx_src,
+                                        std::string_view fg_src,
+                                        std::vector<std::string> const &defines) const
+{
+    md5_hasher mh;
+    add_key_part(&mh, context_signature);
+    add_key_part(&mh, vx_src);
+    add_key_part(&mh, fg_src);
+    for(auto const &def : defines) {
+        add_key_part(&mh, def);
+    }
+
+    return mh.finish();
+}
+
+void jkgm::program_cache::prepare_link(gl::program_view prog) const
+{
+    if(enabled) {
+        gl::set_program_binary_retrievable_hint(prog, true);
+    }
+}
+
+bool jkgm::program_cache::load(md5 const &key, gl::program_view prog) const
+{
+    if(!enabled) {
+        return false;
+    }
+
+    auto entry_path = get_entry_path(key);
+
+    std::error_code ec;
+    if(!fs::exists(entry_path, ec)) {
+        return false;
+    }
+
+    memory_block mb;
+    try {
+        auto fs = make_file_input_stream(entry_path);
+        memory_output_block mob(&mb);
+        fs->copy_to(&mob);
+    }
+    catch(std::exception const &e) {
+        LOG_WARNING("Failed to read cached program ", entry_path.generic_string(), ": ", e.what());
+        return false;
+    }
+
+    program_cache_header expected_hdr;
+    program_cache_header hdr;
+    if(mb.size() < sizeof(hdr)) {
+        LOG_DEBUG("Cached program ", entry_path.generic_string(), " is truncated");
+        return false;
+    }
+
+    std::memcpy(&hdr, mb.data(), sizeof(hdr));
+    if(std::memcmp(hdr.magic, expected_hdr.magic, sizeof(hdr.magic)) != 0 ||
+       hdr.version != expected_hdr.version ||
+       hdr.binary_length != (mb.size() - sizeof(hdr))) {
+        LOG_DEBUG("Cached program ", entry_path.generic_string(), " is malformed");
+        return false;
+    }
+
+    gl::program_binary(
+        prog, hdr.binary_format, make_span(mb.data() + sizeof(hdr), hdr.binary_length));
+
+    // Drivers reject binaries from other driver versions by failing the link status
+    if(!gl::get_program_link_status(prog)) {
+        LOG_DEBUG("Cached program ", entry_path.generic_string(), " was rejected by the driver");
+        return false;
+    }
+
+    return true;
+}
+
+void jkgm::program_cache::store(md5 const &key, gl::program_view prog) const
+{
+    if(!enabled) {
+        return;
+    }
+
+    program_cache_header hdr;
+    auto binary = gl::get_program_binary(prog, &hdr.binary_format);
+    if(binary.empty()) {
+        return;
+    }
+
+    hdr.binary_length = static_cast<uint32_t>(binary.size());
+
+    auto entry_path = get_entry_path(key);
+    try {
+        auto fs = make_file_output_stream(entry_path);
+        fs->write(make_span(&hdr, 1).as_const_bytes());
+        fs->write(make_span(binary));
+    }
+    catch(std::exception const &e) {
+        LOG_WARNING("Failed to write cached program ", entry_path.generic_string(), ": ", e.what());
+    }
+}
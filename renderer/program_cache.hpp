@@ -0,0 +1,33 @@
+#pragma once
+
+#include "base/filesystem.hpp"
+#include "base/md5.hpp"
+#include "glutil/program.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jkgm {
+    // Stores linked program binaries on disk. Entries are keyed on the shader sources, the
+    // define set, and the GL vendor/renderer/version strings, so a driver update or shader edit
+    // results in a cache miss rather than a stale binary.
+    class program_cache {
+    private:
+        fs::path cache_path;
+        std::string context_signature;
+        bool enabled = false;
+
+        fs::path get_entry_path(md5 const &key) const;
+
+    public:
+        explicit program_cache(fs::path const &cache_path);
+
+        md5 make_key(std::string_view vx_src,
+                     std::string_view fg_src,
+                     std::vector<std::string> const &defines) const;
+
+        void prepare_link(gl::program_view prog) const;
+        bool load(md5 const &key, gl::program_view prog) const;
+        void store(md5 const &key, gl::program_view prog) const;
+    };
+}
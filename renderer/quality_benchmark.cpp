@@ -0,0 +1,86 @@
+#include "quality_benchmark.hpp"
+#include "base/log.hpp"
+
+namespace jkgm {
+    namespace {
+        // Early frames include shader and texture uploads and are not representative
+        constexpr int warmup_frames = 30;
+        constexpr int measured_frames = 240;
+    }
+}
+
+jkgm::quality_settings jkgm::quality_benchmark::get_benchmark_settings()
+{
+    quality_settings rv;
+    rv.max_anisotropy = 16.0f;
+    rv.enable_bloom = true;
+    rv.enable_ssao = true;
+    rv.enable_parallax = true;
+    rv.render_scale = 1.0f;
+    return rv;
+}
+
+void jkgm::quality_benchmark::begin_pass(benchmark_pass pass)
+{
+    timers[static_cast<size_t>(pass)].begin();
+}
+
+void jkgm::quality_benchmark::end_pass(benchmark_pass pass)
+{
+    timers[static_cast<size_t>(pass)].end();
+}
+
+void jkgm::quality_benchmark::end_frame()
+{
+    ++num_frames;
+
+    for(size_t i = 0; i < num_passes; ++i) {
+        auto pass_time = timers[i].poll();
+        if(pass_time.has_value() && num_frames > warmup_frames) {
+            total_time[i] += *pass_time;
+            ++num_samples[i];
+        }
+    }
+}
+
+bool jkgm::quality_benchmark::is_finished() const
+{
+    return num_frames >= (warmup_frames + measured_frames);
+}
+
+double jkgm::quality_benchmark::get_average_time(benchmark_pass pass) const
+{
+    auto i = static_cast<size_t>(pass);
+    if(num_samples[i] == 0) {
+        return 0.0;
+    }
+
+    return total_time[i] / static_cast<double>(num_samples[i]);
+}
+
+jkgm::quality_settings jkgm::quality_benchmark::choose_settings(float min_render_scale,
+                                                                 double target_frame_time) const
+{
+    double geometry_time = get_average_time(benchmark_pass::geometry);
+    double ssao_time = get_average_time(benchmark_pass::ssao);
+    double transparency_time = get_average_time(benchmark_pass::transparency);
+    double bloom_time = get_average_time(benchmark_pass::bloom);
+
+    LOG_INFO("Quality benchmark: geometry ",
+             static_cast<int>(geometry_time * 1000.0),
+             " us, SSAO ",
+             static_cast<int>(ssao_time * 1000.0),
+             " us, transparency ",
+             static_cast<int>(transparency_time * 1000.0),
+             " us, bloom ",
+             static_cast<int>(bloom_time * 1000.0),
+             " us");
+
+    quality_pass_times times;
+    times.geometry = geometry_time;
+    times.ssao = ssao_time;
+    times.transparency = transparency_time;
+    times.bloom = bloom_time;
+
+    return choose_quality_settings(times, min_render_scale, target_frame_time);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common/quality_profile.hpp"
+#include "core/quality_selection.hpp"
+#include "gpu_timer.hpp"
+#include <array>
+
+namespace jkgm {
+    enum class benchmark_pass : size_t { geometry, ssao, transparency, bloom };
+
+    // Measures the GPU cost of each optional pass during the first frames of play, with every
+    // option enabled, and then picks the richest settings expected to meet a frame-time target.
+    class quality_benchmark {
+    private:
+        static constexpr size_t num_passes = 4U;
+
+        std::array<gpu_timer, num_passes> timers;
+        std::array<double, num_passes> total_time = {};
+        std::array<int, num_passes> num_samples = {};
+        int num_frames = 0;
+
+        double get_average_time(benchmark_pass pass) const;
+
+    public:
+        // The settings used while the benchmark runs. These are the most expensive settings the
+        // benchmark can choose.
+        static quality_settings get_benchmark_settings();
+
+        void begin_pass(benchmark_pass pass);
+        void end_pass(benchmark_pass pass);
+        void end_frame();
+
+        bool is_finished() const;
+
+        quality_settings choose_settings(float min_render_scale, double target_frame_time) const;
+    };
+}
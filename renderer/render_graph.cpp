@@ -0,0 +1,303 @@
+#include "render_graph.hpp"
+#include "base/log.hpp"
+#include "glutil/debug.hpp"
+#include <algorithm>
+
+bool jkgm::render_graph_texture_desc::operator==(render_graph_texture_desc const &other) const
+{
+    return dims == other.dims && internal_format == other.internal_format &&
+           pixel_format == other.pixel_format;
+}
+
+jkgm::render_target_pool::entry::entry(render_graph_texture_desc const &desc)
+    : desc(desc)
+{
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, fbo);
+
+    gl::bind_texture(gl::texture_bind_target::texture_2d, tex);
+    gl::tex_image_2d(gl::texture_bind_target::texture_2d,
+                     /*level*/ 0,
+                     desc.internal_format,
+                     desc.dims,
+                     desc.pixel_format,
+                     gl::texture_pixel_type::float32,
+                     span<char const>(nullptr, 0U));
+    gl::set_texture_max_level(gl::texture_bind_target::texture_2d, 0U);
+    gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::linear);
+    gl::set_texture_min_filter(gl::texture_bind_target::texture_2d, gl::min_filter::linear);
+    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
+                              gl::texture_direction::s,
+                              gl::texture_wrap_mode::clamp_to_edge);
+    gl::set_texture_wrap_mode(gl::texture_bind_target::texture_2d,
+                              gl::texture_direction::t,
+                              gl::texture_wrap_mode::clamp_to_edge);
+
+    gl::framebuffer_texture(
+        gl::framebuffer_bind_target::any, gl::framebuffer_attachment::color0, tex, 0);
+
+    gl::draw_buffers(gl::draw_buffer::color0);
+
+    auto fbs = gl::check_framebuffer_status(gl::framebuffer_bind_target::any);
+    if(fbs != gl::framebuffer_status::complete) {
+        gl::log_errors();
+        LOG_ERROR("Failed to create transient framebuffer: ", static_cast<int>(fbs));
+    }
+
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
+}
+
+namespace jkgm {
+    namespace {
+        void label_pool_entry(render_target_pool::entry *em, std::string const &label)
+        {
+            // Storage is reused by the same resources every frame, so this rarely relabels
+            if(gl::has_debug_annotation_support() && em->label != label) {
+                em->label = label;
+                gl::set_object_label(em->tex, label);
+                gl::set_object_label(em->fbo, label);
+            }
+        }
+    }
+}
+
+jkgm::render_target_pool::entry *
+    jkgm::render_target_pool::acquire(render_graph_texture_desc const &desc,
+                                      std::string const &label)
+{
+    for(auto &em : entries) {
+        if(!em->in_use && em->desc == desc) {
+            em->in_use = true;
+            label_pool_entry(em.get(), label);
+            return em.get();
+        }
+    }
+
+    LOG_DEBUG("Allocating transient render target ",
+              get<x>(desc.dims),
+              "x",
+              get<y>(desc.dims),
+              " (",
+              entries.size() + 1,
+              " total)");
+
+    auto *rv = entries.emplace_back(std::make_unique<entry>(desc)).get();
+    rv->in_use = true;
+    label_pool_entry(rv, label);
+    return rv;
+}
+
+void jkgm::render_target_pool::release(entry *em)
+{
+    em->in_use = false;
+}
+
+void jkgm::render_target_pool::trim()
+{
+    entries.erase(std::remove_if(entries.begin(),
+                                 entries.end(),
+                                 [](auto const &em) { return !em->in_use; }),
+                  entries.end());
+}
+
+jkgm::render_graph_context::render_graph_context(render_graph const *graph, box<2, int> vp)
+    : graph(graph)
+    , vp(vp)
+{
+}
+
+jkgm::gl::texture_view jkgm::render_graph_context::get_texture(render_graph_resource_id id) const
+{
+    auto const &res = graph->resources.at(id.get());
+    if(res.physical) {
+        return res.physical->tex;
+    }
+
+    if(res.tex.has_value()) {
+        return *res.tex;
+    }
+
+    LOG_ERROR("Render graph resource ", res.name, " has no texture");
+    return gl::default_texture;
+}
+
+jkgm::box<2, int> jkgm::render_graph_context::viewport() const
+{
+    return vp;
+}
+
+jkgm::render_graph_resource_id
+    jkgm::render_graph::create_texture(std::string const &name,
+                                       render_graph_texture_desc const &desc)
+{
+    resource res;
+    res.name = name;
+    res.desc = desc;
+    res.viewport = make_box(make_point(0, 0), desc.dims);
+
+    resources.push_back(std::move(res));
+    return render_graph_resource_id(resources.size() - 1);
+}
+
+jkgm::render_graph_resource_id jkgm::render_graph::import_texture(std::string const &name,
+                                                                  gl::texture_view tex)
+{
+    resource res;
+    res.name = name;
+    res.tex = tex;
+
+    resources.push_back(std::move(res));
+    return render_graph_resource_id(resources.size() - 1);
+}
+
+jkgm::render_graph_resource_id
+    jkgm::render_graph::import_target(std::string const &name,
+                                      gl::framebuffer_view fbo,
+                                      box<2, int> viewport,
+                                      std::optional<gl::texture_view> tex)
+{
+    resource res;
+    res.name = name;
+    res.fbo = fbo;
+    res.tex = tex;
+    res.viewport = viewport;
+    res.is_default_framebuffer = (*fbo == *gl::default_framebuffer);
+
+    resources.push_back(std::move(res));
+    return render_graph_resource_id(resources.size() - 1);
+}
+
+void jkgm::render_graph::add_pass(std::string const &name,
+                                  std::vector<render_graph_resource_id> const &reads,
+                                  render_graph_resource_id write,
+                                  render_graph_load_op load_op,
+                                  execute_function fn,
+                                  color clear_color)
+{
+    passes.push_back(pass{name, reads, write, load_op, clear_color, std::move(fn)});
+}
+
+void jkgm::render_graph::cull_passes()
+{
+    // Walk backward from the passes that write imported targets, tracking which transient
+    // resources still need a writer. A full overwrite satisfies the need; a load does not.
+    std::vector<bool> needed(resources.size(), false);
+
+    for(auto it = passes.rbegin(); it != passes.rend(); ++it) {
+        auto const &write_res = resources.at(it->write.get());
+        it->live = write_res.fbo.has_value() || needed[it->write.get()];
+        if(!it->live) {
+            continue;
+        }
+
+        if(it->load_op != render_graph_load_op::load) {
+            needed[it->write.get()] = false;
+        }
+
+        for(auto const &read : it->reads) {
+            needed[read.get()] = true;
+        }
+    }
+
+    for(size_t i = 0; i < resources.size(); ++i) {
+        if(needed[i] && resources[i].desc.has_value()) {
+            LOG_WARNING("Render graph resource ", resources[i].name, " is read before written");
+        }
+    }
+}
+
+void jkgm::render_graph::compute_lifetimes()
+{
+    for(size_t i = 0; i < passes.size(); ++i) {
+        auto const &p = passes[i];
+        if(!p.live) {
+            continue;
+        }
+
+        auto touch = [&](render_graph_resource_id id) {
+            auto &res = resources.at(id.get());
+            if(!res.first_use.has_value()) {
+                res.first_use = i;
+            }
+
+            res.last_use = i;
+        };
+
+        touch(p.write);
+        for(auto const &read : p.reads) {
+            touch(read);
+        }
+    }
+}
+
+void jkgm::render_graph::begin_pass(pass const &p)
+{
+    auto &target = resources.at(p.write.get());
+
+    gl::framebuffer_view fbo = gl::default_framebuffer;
+    if(target.desc.has_value()) {
+        fbo = target.physical->fbo;
+    }
+    else {
+        fbo = *target.fbo;
+    }
+
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, fbo);
+    gl::set_viewport(target.viewport);
+
+    switch(p.load_op) {
+    case render_graph_load_op::load:
+        break;
+
+    case render_graph_load_op::clear:
+        gl::clear_buffer_color(0, p.clear_color);
+        break;
+
+    case render_graph_load_op::dont_care:
+        // Only color is invalidated, including on the default framebuffer. Imported targets may
+        // share a depth buffer with later passes outside of the graph.
+        if(target.is_default_framebuffer) {
+            gl::invalidate_framebuffer(gl::framebuffer_bind_target::any,
+                                       gl::framebuffer_attachment::default_color);
+        }
+        else {
+            gl::invalidate_framebuffer(gl::framebuffer_bind_target::any,
+                                       gl::framebuffer_attachment::color0);
+        }
+        break;
+    }
+}
+
+void jkgm::render_graph::execute(render_target_pool *pool, gl::timer_profiler *profiler)
+{
+    cull_passes();
+    compute_lifetimes();
+
+    for(size_t i = 0; i < passes.size(); ++i) {
+        auto const &p = passes[i];
+        if(!p.live) {
+            continue;
+        }
+
+        // Acquire storage for transient resources first used by this pass
+        for(auto &res : resources) {
+            if(res.desc.has_value() && res.first_use == i) {
+                res.physical = pool->acquire(*res.desc, res.name);
+            }
+        }
+
+        {
+            gl::debug_group group(p.name);
+            gl::timer_profiler_scope scope(profiler, p.name);
+            begin_pass(p);
+            p.fn(render_graph_context(this, resources.at(p.write.get()).viewport));
+        }
+
+        // Return storage for transient resources last used by this pass
+        for(auto &res : resources) {
+            if(res.physical && res.last_use == i) {
+                pool->release(res.physical);
+                res.physical = nullptr;
+            }
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "base/id.hpp"
+#include "glutil/framebuffer.hpp"
+#include "glutil/texture.hpp"
+#include "glutil/timer_profiler.hpp"
+#include "math/box.hpp"
+#include "math/color.hpp"
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    MAKE_ID_TYPE(render_graph_resource, size_t);
+
+    // What happens to the previous contents of a pass's render target
+    enum class render_graph_load_op {
+        // Keep the previous contents. The pass depends on the previous writer.
+        load,
+
+        // Clear to the pass clear color before drawing
+        clear,
+
+        // The pass overwrites the entire target. Previous contents are invalidated.
+        dont_care
+    };
+
+    struct render_graph_texture_desc {
+        size<2, int> dims;
+        gl::texture_internal_format internal_format;
+        gl::texture_pixel_format pixel_format;
+
+        bool operator==(render_graph_texture_desc const &other) const;
+    };
+
+    // Owns the storage behind transient render graph textures. Storage is shared by any graph
+    // resources with matching descriptions whose lifetimes do not overlap, including resources
+    // in different graphs. Storage is only allocated once a graph actually needs it.
+    class render_target_pool {
+    public:
+        struct entry {
+            render_graph_texture_desc desc;
+            gl::texture tex;
+            gl::framebuffer fbo;
+            bool in_use = false;
+
+            // Name of the graph resource most recently stored here, for debug tools
+            std::string label;
+
+            explicit entry(render_graph_texture_desc const &desc);
+        };
+
+    private:
+        std::vector<std::unique_ptr<entry>> entries;
+
+    public:
+        entry *acquire(render_graph_texture_desc const &desc, std::string const &label);
+        void release(entry *em);
+
+        // Frees storage not currently held by a graph, such as targets sized for a previous
+        // resolution
+        void trim();
+    };
+
+    class render_graph;
+
+    class render_graph_context {
+        friend class render_graph;
+
+    private:
+        render_graph const *graph;
+        box<2, int> vp;
+
+        render_graph_context(render_graph const *graph, box<2, int> vp);
+
+    public:
+        gl::texture_view get_texture(render_graph_resource_id id) const;
+        box<2, int> viewport() const;
+    };
+
+    // Declarative sequence of full-screen passes. Passes whose results are never consumed by a
+    // pass writing to an imported target are culled, redundant clears are replaced with
+    // framebuffer invalidation, and transient textures are drawn from a render_target_pool.
+    // Each pass is a debug group named after the pass.
+    class render_graph {
+        friend class render_graph_context;
+
+    public:
+        using execute_function = std::function<void(render_graph_context const &)>;
+
+    private:
+        struct resource {
+            std::string name;
+
+            // Transient resources
+            std::optional<render_graph_texture_desc> desc;
+            render_target_pool::entry *physical = nullptr;
+
+            // Imported resources
+            std::optional<gl::framebuffer_view> fbo;
+            std::optional<gl::texture_view> tex;
+            box<2, int> viewport = make_box(make_point(0, 0), make_size(0, 0));
+            bool is_default_framebuffer = false;
+
+            // Live pass indices
+            std::optional<size_t> first_use;
+            size_t last_use = 0U;
+        };
+
+        struct pass {
+            std::string name;
+            std::vector<render_graph_resource_id> reads;
+            render_graph_resource_id write;
+            render_graph_load_op load_op;
+            color clear_color;
+            execute_function fn;
+            bool live = false;
+        };
+
+        std::vector<resource> resources;
+        std::vector<pass> passes;
+
+        void cull_passes();
+        void compute_lifetimes();
+        void begin_pass(pass const &p);
+
+    public:
+        render_graph_resource_id create_texture(std::string const &name,
+                                                render_graph_texture_desc const &desc);
+        render_graph_resource_id import_texture(std::string const &name, gl::texture_view tex);
+        render_graph_resource_id import_target(std::string const &name,
+                                               gl::framebuffer_view fbo,
+                                               box<2, int> viewport,
+                                               std::optional<gl::texture_view> tex);
+
+        void add_pass(std::string const &name,
+                      std::vector<render_graph_resource_id> const &reads,
+                      render_graph_resource_id write,
+                      render_graph_load_op load_op,
+                      execute_function fn,
+                      color clear_color = color::zero());
+
+        // Each pass is profiled under its name when a profiler is given
+        void execute(render_target_pool *pool, gl::timer_profiler *profiler = nullptr);
+    };
+}
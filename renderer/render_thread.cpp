@@ -0,0 +1,117 @@
+#include "render_thread.hpp"
+#include "base/trace.hpp"
+
+jkgm::render_thread::render_thread(bool threaded)
+{
+    if(threaded) {
+        worker = std::thread([this] { run(); });
+    }
+}
+
+jkgm::render_thread::~render_thread()
+{
+    if(!worker.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
+    }
+
+    work_cv.notify_one();
+    worker.join();
+}
+
+bool jkgm::render_thread::is_threaded() const
+{
+    return worker.joinable();
+}
+
+size_t jkgm::render_thread::submit(std::function<void()> fn)
+{
+    if(!is_threaded()) {
+        fn();
+        ++num_completed;
+        return ++num_submitted;
+    }
+
+    size_t ticket = 0U;
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        jobs.push_back(std::move(fn));
+        ticket = ++num_submitted;
+    }
+
+    work_cv.notify_one();
+    return ticket;
+}
+
+void jkgm::render_thread::wait_for(std::unique_lock<std::mutex> &lk, size_t ticket)
+{
+    done_cv.wait(lk, [&] { return num_completed >= ticket; });
+}
+
+void jkgm::render_thread::run()
+{
+    TRACE_THREAD_NAME("render");
+
+    std::unique_lock<std::mutex> lk(lock);
+    while(true) {
+        work_cv.wait(lk, [&] { return stopping || !jobs.empty(); });
+        if(jobs.empty()) {
+            // Stopping, and all queued work has drained
+            return;
+        }
+
+        auto fn = std::move(jobs.front());
+        jobs.pop_front();
+
+        lk.unlock();
+        fn();
+        lk.lock();
+
+        ++num_completed;
+        done_cv.notify_all();
+    }
+}
+
+void jkgm::render_thread::post(std::function<void()> fn)
+{
+    submit(std::move(fn));
+}
+
+void jkgm::render_thread::call(std::function<void()> fn)
+{
+    auto ticket = submit(std::move(fn));
+
+    std::unique_lock<std::mutex> lk(lock);
+    wait_for(lk, ticket);
+}
+
+void jkgm::render_thread::post_frame(std::function<void()> fn, size_t max_pending_frames)
+{
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        while(pending_frames.size() >= max_pending_frames) {
+            wait_for(lk, pending_frames.front());
+            pending_frames.pop_front();
+        }
+    }
+
+    auto ticket = submit(std::move(fn));
+
+    std::lock_guard<std::mutex> lk(lock);
+    while(!pending_frames.empty() && pending_frames.front() <= num_completed) {
+        pending_frames.pop_front();
+    }
+
+    pending_frames.push_back(ticket);
+}
+
+void jkgm::render_thread::wait_idle()
+{
+    std::unique_lock<std::mutex> lk(lock);
+    wait_for(lk, num_submitted);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace jkgm {
+    // Executes renderer work in submission order on a dedicated thread that owns the GL context.
+    // When constructed without a thread, work executes immediately on the submitting thread.
+    class render_thread {
+    private:
+        std::mutex lock;
+        std::condition_variable work_cv;
+        std::condition_variable done_cv;
+        std::deque<std::function<void()>> jobs;
+        std::deque<size_t> pending_frames;
+        size_t num_submitted = 0U;
+        size_t num_completed = 0U;
+        bool stopping = false;
+        std::thread worker;
+
+        size_t submit(std::function<void()> fn);
+        void wait_for(std::unique_lock<std::mutex> &lk, size_t ticket);
+        void run();
+
+    public:
+        explicit render_thread(bool threaded);
+        ~render_thread();
+
+        render_thread(render_thread const &) = delete;
+        render_thread &operator=(render_thread const &) = delete;
+
+        bool is_threaded() const;
+
+        // Queues work and returns immediately
+        void post(std::function<void()> fn);
+
+        // Queues work and blocks until it has finished. Captures by reference are safe.
+        void call(std::function<void()> fn);
+
+        // Queues a frame of work. Blocks first while max_pending_frames frames are unfinished.
+        void post_frame(std::function<void()> fn, size_t max_pending_frames);
+
+        // Blocks until all previously queued work has finished
+        void wait_idle();
+    };
+}
@@ -3,12 +3,20 @@
 #include "backbuffer_surface.hpp"
 #include "base/file_block.hpp"
 #include "base/file_stream.hpp"
+#include "base/job_system.hpp"
 #include "base/log.hpp"
 #include "base/memory_block.hpp"
+#include "base/trace.hpp"
 #include "base/win32.hpp"
 #include "common/error_reporter.hpp"
 #include "common/image.hpp"
 #include "common/material_map.hpp"
+#include "common/quality_profile.hpp"
+#include "core/execute_buffer_translator.hpp"
+#include "core/frame_time_histogram.hpp"
+#include "core/render_scale.hpp"
+#include "core/triangle_batch.hpp"
+#include "core/triangle_buffer.hpp"
 #include "d3d_impl.hpp"
 #include "d3ddevice_impl.hpp"
 #include "d3dviewport_impl.hpp"
@@ -16,27 +24,37 @@
 #include "ddraw_impl.hpp"
 #include "ddrawpalette_impl.hpp"
 #include "execute_buffer.hpp"
+#include "frame_limiter.hpp"
 #include "glad/glad.h"
 #include "glutil/buffer.hpp"
+#include "glutil/debug.hpp"
 #include "glutil/framebuffer.hpp"
 #include "glutil/gl.hpp"
 #include "glutil/program.hpp"
 #include "glutil/shader.hpp"
 #include "glutil/texture.hpp"
+#include "glutil/timer_profiler.hpp"
 #include "glutil/vertex_array.hpp"
 #include "math/color_conv.hpp"
 #include "math/colors.hpp"
 #include "offscreen_menu_surface.hpp"
 #include "offscreen_surface.hpp"
 #include "opengl_state.hpp"
+#include "overlay_text.hpp"
 #include "primary_menu_surface.hpp"
 #include "primary_surface.hpp"
+#include "quality_benchmark.hpp"
+#include "render_graph.hpp"
+#include "render_thread.hpp"
 #include "sysmem_texture.hpp"
-#include "triangle_batch.hpp"
 #include "vidmem_texture.hpp"
 #include "zbuffer_surface.hpp"
 #include <Windows.h>
+#include <timeapi.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include <random>
 
 namespace jkgm {
@@ -44,6 +62,19 @@ namespace jkgm {
     static size<2, int> original_configured_screen_res = make_size(0, 0);
     static box<2, int> actual_display_area = make_box(make_point(0, 0), make_size(0, 0));
 
+    // Execute buffers are decoded without the Windows SDK types
+    static_assert(sizeof(D3DTLVERTEX) == sizeof(d3d::tl_vertex));
+    static_assert(sizeof(D3DINSTRUCTION) == sizeof(d3d::instruction));
+    static_assert(sizeof(D3DTRIANGLE) == sizeof(d3d::triangle_indices));
+    static_assert(D3DOP_TRIANGLE == d3d::opcode::triangle);
+    static_assert(D3DRENDERSTATE_ALPHABLENDENABLE == d3d::render_state::alpha_blend_enable);
+
+    // Updated by the window procedure
+    static std::atomic<bool> window_has_focus = true;
+    static std::atomic<bool> window_is_minimized = false;
+    static std::atomic<bool> cpu_trace_dump_requested = false;
+    static std::atomic<bool> frame_time_report_requested = false;
+
     using wglCreateContextAttribsARB_type = HGLRC(WINAPI *)(HDC hDC,
                                                             HGLRC hShareContext,
                                                             int const *attribList);
@@ -77,6 +108,27 @@ namespace jkgm {
 #define WGL_FULL_ACCELERATION_ARB 0x2027
 #define WGL_TYPE_RGBA_ARB 0x202B
 
+    // Number of presented frames the game thread may queue ahead of the render thread
+    static constexpr size_t max_pending_render_frames = 1U;
+
+    static constexpr float min_render_scale = 0.25f;
+    static constexpr float max_render_scale = 1.0f;
+
+    // The weapon overlay is drawn into the front of the depth range so that it always covers the
+    // world without clearing and redrawing
+    static constexpr float weapon_depth_range = 0.01f;
+
+    // GPU profiler averages are reported every few seconds
+    static constexpr int gpu_profiler_frames_per_report = 120;
+
+    // Menus are always drawn into a 640x480 indexed buffer
+    static constexpr size_t menu_num_pixels = 640U * 480U;
+
+    struct draw_counters {
+        size_t num_draw_calls = 0U;
+        size_t num_triangles = 0U;
+    };
+
     void init_wgl_extensions(HINSTANCE hInstance)
     {
         WNDCLASS dummy_class;
@@ -176,6 +228,32 @@ namespace jkgm {
             return 0;
         }
 
+        case WM_ACTIVATEAPP:
+            window_has_focus = (wParam != FALSE);
+            break;
+
+        case WM_KEYDOWN:
+            // Ctrl+F11 logs the frame time report. Ctrl+F12 writes the recent CPU trace.
+            if(wParam == VK_F11 && (GetKeyState(VK_CONTROL) & 0x8000) != 0) {
+                frame_time_report_requested = true;
+            }
+
+            if(wParam == VK_F12 && (GetKeyState(VK_CONTROL) & 0x8000) != 0) {
+                cpu_trace_dump_requested = true;
+            }
+
+            break;
+
+        case WM_SIZE:
+            if(wParam == SIZE_MINIMIZED) {
+                window_is_minimized = true;
+            }
+            else if(wParam == SIZE_RESTORED || wParam == SIZE_MAXIMIZED) {
+                window_is_minimized = false;
+            }
+
+            break;
+
         case WM_MOUSEMOVE: {
             // Scale the mouse position so JK thinks it's over the menu
             auto xPos = (int16_t)lParam;
@@ -245,7 +323,7 @@ namespace jkgm {
         return make_direction(xoff, yoff);
     }
 
-    class renderer_impl : public renderer {
+    class renderer_impl : public renderer, public execute_buffer_materials {
     private:
         config const *the_config;
         material_map materials;
@@ -295,19 +373,70 @@ namespace jkgm {
         timestamp_t menu_prev_ticks;
         timestamp_t menu_curr_ticks;
 
+        job_system jobs;
+
         triangle_batch world_batch;
         sorted_triangle_batch world_transparent_batch;
         triangle_batch gun_batch;
         sorted_triangle_batch gun_transparent_batch;
-
-        bool is_gun = false;
-        bool is_transparent = false;
-        triangle_batch *current_triangle_batch = &world_batch;
+        execute_buffer_translator translator;
 
         material_instance_id current_material = material_instance_id(0U);
+        gl::program const *current_program = nullptr;
+
+        draw_counters opaque_pass_counters;
+        draw_counters transparency_pass_counters;
+        draw_counters *current_pass_counters = nullptr;
+
+        std::optional<render_scale_controller> dynamic_render_scale;
+        std::optional<frame_limiter> limiter;
+
+        // Paces JK itself while the window is in the background
+        std::optional<frame_limiter> background_limiter;
+        std::atomic<bool> is_background_throttled = false;
+
+        std::optional<gl::timer_profiler> gpu_profiler;
+        std::unique_ptr<output_stream> gpu_profile_csv;
+        std::vector<std::string> gpu_profile_overlay_lines;
+        size_t num_presented_frames = 0U;
+
+        // Counters for the frame being built, on the render thread. Texture hashes happen on the
+        // game thread and are collected when the frame ends.
+        frame_statistics current_frame_stats;
+        frame_statistics_accumulator frame_stats_summary;
+        std::atomic<size_t> num_pending_texture_hashes = 0U;
+        std::chrono::steady_clock::time_point last_frame_end;
+        bool has_last_frame_end = false;
+
+        std::mutex last_frame_stats_lock;
+        frame_statistics last_frame_stats;
+        std::vector<std::string> frame_stats_overlay_lines;
+
+        std::optional<level_load_profiler> level_loads;
+        std::unique_ptr<output_stream> level_load_report;
+
+        // Renderer inputs, recorded on the game thread. Closed after the configured number of
+        // game frames.
+        std::unique_ptr<capture_writer> capture;
+        int num_captured_game_frames = 0;
+
+        // Game frames only. Reported and restarted at the end of each level.
+        std::mutex frame_times_lock;
+        std::optional<frame_time_histogram> frame_times;
+        bool is_building_game_frame = false;
+
+        // Quality options in effect. These come from the stored quality profile or the running
+        // benchmark when the quality mode is automatic.
+        quality_settings quality;
+        std::atomic<bool> parallax_enabled = true;
+        quality_profile auto_quality_profile;
+        std::optional<quality_benchmark> benchmark;
 
         std::vector<point<3, float>> ssao_kernel;
 
+        // Declared last: the render thread must drain before any state it touches is destroyed
+        render_thread rthread;
+
     public:
         explicit renderer_impl(HINSTANCE dll_instance, config const *the_config)
             : the_config(the_config)
@@ -328,9 +457,62 @@ namespace jkgm {
             , ddraw1_zbuffer_surface(this)
             , ddraw1_palette(this)
             , dll_instance(dll_instance)
+            , world_transparent_batch(&jobs,
+                                      the_config->transparency_sort,
+                                      the_config->enable_temporal_transparency_sort)
+            , gun_transparent_batch(&jobs,
+                                    the_config->transparency_sort,
+                                    the_config->enable_temporal_transparency_sort)
+            , translator(this,
+                         game_triangle_batches{&world_batch,
+                                               &world_transparent_batch,
+                                               &gun_batch,
+                                               &gun_transparent_batch})
+            , rthread(the_config->enable_render_thread)
         {
             indexed_bitmap_colors.resize(256, color_rgba8::zero());
 
+            set_quality_settings(get_configured_quality_settings(*the_config));
+
+            if(the_config->max_frame_rate > 0.0f) {
+                limiter.emplace(the_config->max_frame_rate);
+            }
+
+            if(the_config->background_mode != background_mode::none) {
+                background_limiter.emplace(std::max(1.0f, the_config->background_frame_rate));
+            }
+
+            if(the_config->enable_gpu_profiler || the_config->enable_gpu_profiler_overlay) {
+                gpu_profiler.emplace(gpu_profiler_frames_per_report);
+                open_gpu_profile_csv();
+            }
+
+            if(the_config->enable_level_load_report) {
+                level_loads.emplace();
+                open_level_load_report();
+            }
+
+            if(the_config->enable_frame_time_report) {
+                frame_times.emplace(static_cast<double>(the_config->hitch_threshold_ms) * 1000.0);
+            }
+
+            open_capture();
+
+            if(the_config->enable_cpu_trace) {
+                if constexpr(trace_compiled_in) {
+                    set_trace_enabled(true);
+                    TRACE_THREAD_NAME("game");
+                }
+                else {
+                    LOG_WARNING("CPU tracing is enabled, but this build does not include it");
+                }
+            }
+
+            if(limiter.has_value() || background_limiter.has_value()) {
+                // Sleeps are only as precise as the system timer
+                timeBeginPeriod(1);
+            }
+
             menu_prev_ticks = std::chrono::high_resolution_clock::now();
             menu_curr_ticks = menu_prev_ticks;
 
@@ -352,9 +534,18 @@ namespace jkgm {
 
         void set_renderer_mode(renderer_mode mode) override
         {
+            if(this->mode == renderer_mode::ingame && mode == renderer_mode::menu) {
+                log_frame_times("level end", /*reset*/ true);
+            }
+
             this->mode = mode;
         }
 
+        void on_process_exit() override
+        {
+            log_frame_times("exit", /*reset*/ false);
+        }
+
         size<2, int> get_internal_screen_resolution() override
         {
             return actual_display_area.size();
@@ -362,7 +553,7 @@ namespace jkgm {
 
         bool is_parallax_enabled() override
         {
-            return the_config->enable_parallax;
+            return parallax_enabled;
         }
 
         point<2, int> get_cursor_pos(point<2, int> real_pos) override
@@ -450,27 +641,45 @@ namespace jkgm {
                                         WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
                                         0};
 
-            hGLRC = wglCreateContextAttribsARB(hDC, NULL, gl_attribs.data());
-            wglMakeCurrent(hDC, hGLRC);
+            // The context is current on the render thread, which issues all subsequent GL calls
+            rthread.call([&] {
+                hGLRC = wglCreateContextAttribsARB(hDC, NULL, gl_attribs.data());
+                wglMakeCurrent(hDC, hGLRC);
 
-            if(!gladLoadGL()) {
-                LOG_ERROR("Failed to load GLAD");
-            }
+                if(!gladLoadGL()) {
+                    LOG_ERROR("Failed to load GLAD");
+                }
+
+                if(the_config->quality == quality_mode::automatic) {
+                    initialize_automatic_quality();
+                }
+            });
 
             ShowWindow(hWnd, SW_SHOW);
 
-            gl::set_clear_color(solid(colors::black));
-            gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+            rthread.call([&] {
+                gl::set_clear_color(solid(colors::black));
+                gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
 
-            SwapBuffers(hDC);
+                SwapBuffers(hDC);
 
-            ogs = std::make_unique<opengl_state>(
-                conf_scr_res, internal_scr_res, actual_display_area, the_config);
-            begin_frame();
+                ogs = std::make_unique<opengl_state>(
+                    conf_scr_res, internal_scr_res, actual_display_area, the_config);
+                begin_frame();
+            });
         }
 
         void begin_frame()
         {
+            if(gpu_profiler.has_value()) {
+                gpu_profiler->begin_frame();
+            }
+
+            if(ogs->frame_fences) {
+                ogs->frame_fences->begin_frame();
+                log_frame_latency();
+            }
+
             gl::set_active_texture_unit(0);
             gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_renderbuffer.fbo);
             gl::set_viewport(ogs->screen_renderbuffer.viewport);
@@ -479,126 +688,573 @@ namespace jkgm {
 
         void end_frame()
         {
+            TRACE_SCOPE("end_frame");
+
             // Compose renderbuffer onto window:
             auto current_wnd_sz = conf_scr_res;
             gl::bind_vertex_array(ogs->postmdl.vao);
+            gl::disable(gl::capability::depth_test);
+            gl::disable(gl::capability::cull_face);
+
+            render_graph rg;
+            auto screen_tex = rg.import_texture("screen", ogs->screen_renderbuffer.tex);
+            auto backbuffer = rg.import_target("backbuffer",
+                                               gl::default_framebuffer,
+                                               make_box(make_point(0, 0), current_wnd_sz),
+                                               std::nullopt);
+
+            // Bloom passes are culled when the final pass does not read their results
+            std::vector<render_graph_resource_id> bloom_layer_textures;
+
+            auto low_pass = rg.create_texture("bloom_low_pass",
+                                              render_graph_texture_desc{
+                                                  current_wnd_sz,
+                                                  gl::texture_internal_format::rgba16f,
+                                                  gl::texture_pixel_format::rgba});
+            rg.add_pass("bloom_low_pass",
+                        {screen_tex},
+                        low_pass,
+                        render_graph_load_op::dont_care,
+                        [&](render_graph_context const &ctx) {
+                            gl::use_program(ogs->post_low_pass);
+                            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+
+                            gl::set_active_texture_unit(0);
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(screen_tex));
+
+                            gl::draw_elements(gl::element_type::triangles,
+                                              ogs->postmdl.num_indices,
+                                              gl::index_type::uint32);
+                        });
+
+            // Blur and down sample:
+            auto hdr_vp_size = static_cast<size<2, float>>(current_wnd_sz);
+            float hdr_aspect_ratio = get<x>(hdr_vp_size) / get<y>(hdr_vp_size);
+
+            auto src_tx = low_pass;
+            for(size_t level = 0; level < ogs->bloom_layers.elements.size(); ++level) {
+                auto const &hdr_stack_em = ogs->bloom_layers.elements[level];
+                render_graph_texture_desc layer_desc{hdr_stack_em.dims,
+                                                     gl::texture_internal_format::rgba16f,
+                                                     gl::texture_pixel_format::rgba};
+                auto layer_name = str(format("bloom[", level, "]"));
+                auto layer_a = rg.create_texture(layer_name + ".a", layer_desc);
+                auto layer_b = rg.create_texture(layer_name + ".b", layer_desc);
+
+                auto layer_vp_size = static_cast<size<2, float>>(hdr_stack_em.dims);
+                auto blur_size =
+                    make_size(get<x>(layer_vp_size) * hdr_aspect_ratio, get<y>(layer_vp_size));
+
+                auto add_blur_pass = [&](render_graph_resource_id src,
+                                         render_graph_resource_id dst,
+                                         direction<2, float> dir) {
+                    rg.add_pass(layer_name,
+                                {src},
+                                dst,
+                                render_graph_load_op::dont_care,
+                                [this, src, blur_size, dir](render_graph_context const &ctx) {
+                                    gl::use_program(ogs->post_gauss7);
+                                    gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                                    gl::set_uniform_vector(gl::uniform_location_id(1), blur_size);
+                                    gl::set_uniform_vector(gl::uniform_location_id(2), dir);
+
+                                    gl::set_active_texture_unit(0);
+                                    gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                     ctx.get_texture(src));
+                                    gl::draw_elements(gl::element_type::triangles,
+                                                      ogs->postmdl.num_indices,
+                                                      gl::index_type::uint32);
+                                });
+                };
+
+                for(int i = 0; i < hdr_stack_em.num_passes; ++i) {
+                    // Blur horizontally
+                    add_blur_pass(src_tx, layer_b, make_direction(1.0f, 0.0f));
+
+                    // Blur vertically
+                    add_blur_pass(layer_b, layer_a, make_direction(0.0f, 1.0f));
+
+                    // Set up next stage
+                    src_tx = layer_a;
+                }
 
-            if(the_config->enable_bloom) {
-                // Render low pass for bloom
-                gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_postbuffer2.fbo);
-                gl::set_viewport(make_box(make_point(0, 0), current_wnd_sz));
+                bloom_layer_textures.push_back(layer_a);
+            }
 
-                gl::set_clear_color(solid(colors::black));
-                gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+            // Copy to front buffer while converting to srgb
+            std::vector<render_graph_resource_id> final_reads{screen_tex};
+            bool enable_bloom = quality.enable_bloom && !is_background_throttled;
+            if(enable_bloom) {
+                final_reads.insert(
+                    final_reads.end(), bloom_layer_textures.begin(), bloom_layer_textures.end());
+            }
 
-                gl::use_program(ogs->post_low_pass);
+            rg.add_pass(
+                "post_to_srgb",
+                final_reads,
+                backbuffer,
+                render_graph_load_op::dont_care,
+                [&](render_graph_context const &ctx) {
+                    gl::use_program(ogs->post_to_srgb);
+
+                    gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+
+                    gl::set_active_texture_unit(0);
+                    gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                     ctx.get_texture(screen_tex));
+
+                    int curr_em = 1;
+                    for(auto const &layer : bloom_layer_textures) {
+                        gl::set_uniform_integer(gl::uniform_location_id(curr_em), curr_em);
+                        gl::set_active_texture_unit(curr_em);
+                        if(enable_bloom) {
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(layer));
+                        }
+                        else {
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             gl::default_texture);
+                        }
 
-                gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                        ++curr_em;
+                    }
 
-                gl::set_active_texture_unit(0);
-                gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->screen_renderbuffer.tex);
+                    curr_em = 5;
+                    for(auto const &hdr_stack_em : ogs->bloom_layers.elements) {
+                        gl::set_uniform_float(gl::uniform_location_id(curr_em),
+                                              hdr_stack_em.weight);
+                        ++curr_em;
+                    }
 
-                gl::draw_elements(
-                    gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
+                    gl::draw_elements(gl::element_type::triangles,
+                                      ogs->postmdl.num_indices,
+                                      gl::index_type::uint32);
+                });
 
-                // Blur and down sample:
-                gl::set_active_texture_unit(0);
+            begin_benchmark_pass(benchmark_pass::bloom);
+            {
+                gl::debug_group group("post");
+                rg.execute(&ogs->render_targets, get_gpu_profiler());
+            }
+            end_benchmark_pass(benchmark_pass::bloom);
 
-                gl::texture_view src_tx = ogs->screen_postbuffer2.tex;
+            if(limiter.has_value()) {
+                limiter->wait();
+                log_frame_pacing();
+            }
 
-                gl::use_program(ogs->post_gauss7);
-                gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+            SwapBuffers(hDC);
 
-                auto hdr_vp_size = static_cast<size<2, float>>(current_wnd_sz);
-                float hdr_aspect_ratio = get<x>(hdr_vp_size) / get<y>(hdr_vp_size);
+            if(ogs->frame_fences) {
+                ogs->frame_fences->end_frame();
+            }
 
-                for(auto &hdr_stack_em : ogs->bloom_layers.elements) {
-                    auto layer_vp_size =
-                        static_cast<size<2, float>>(hdr_stack_em.a.viewport.size());
-                    gl::set_uniform_vector(gl::uniform_location_id(1),
-                                           make_size(get<x>(layer_vp_size) * hdr_aspect_ratio,
-                                                     get<y>(layer_vp_size)));
+            ++num_presented_frames;
+            finish_frame_statistics();
 
-                    for(int i = 0; i < hdr_stack_em.num_passes; ++i) {
-                        // Blur horizontally
-                        gl::bind_framebuffer(gl::framebuffer_bind_target::any, hdr_stack_em.b.fbo);
-                        gl::set_viewport(hdr_stack_em.b.viewport);
+            if(gpu_profiler.has_value()) {
+                gpu_profiler->end_frame();
+                report_gpu_profile();
+            }
 
-                        gl::set_clear_color(solid(colors::black));
-                        gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+            if(frame_time_report_requested.exchange(false)) {
+                log_frame_times("request", /*reset*/ false);
+            }
 
-                        gl::set_uniform_vector(gl::uniform_location_id(2),
-                                               make_direction(1.0f, 0.0f));
-                        gl::bind_texture(gl::texture_bind_target::texture_2d, src_tx);
-                        gl::draw_elements(gl::element_type::triangles,
-                                          ogs->postmdl.num_indices,
-                                          gl::index_type::uint32);
+            if(cpu_trace_dump_requested.exchange(false) && is_trace_enabled()) {
+                write_cpu_trace();
+            }
 
-                        // Blur vertically
-                        gl::bind_framebuffer(gl::framebuffer_bind_target::any, hdr_stack_em.a.fbo);
+            begin_frame();
+        }
 
-                        gl::set_clear_color(solid(colors::black));
-                        gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+        void finish_frame_statistics()
+        {
+            auto now = std::chrono::steady_clock::now();
+            if(has_last_frame_end) {
+                current_frame_stats.frame_time =
+                    std::chrono::duration<double, std::micro>(now - last_frame_end).count();
+            }
 
-                        gl::set_uniform_vector(gl::uniform_location_id(2),
-                                               make_direction(0.0f, 1.0f));
-                        gl::bind_texture(gl::texture_bind_target::texture_2d, hdr_stack_em.b.tex);
-                        gl::draw_elements(gl::element_type::triangles,
-                                          ogs->postmdl.num_indices,
-                                          gl::index_type::uint32);
+            last_frame_end = now;
+            has_last_frame_end = true;
 
-                        // Set up next stage
-                        src_tx = hdr_stack_em.a.tex;
-                    }
-                }
+            current_frame_stats.num_texture_hashes = num_pending_texture_hashes.exchange(0U);
+
+            if(the_config->enable_frame_statistics_overlay) {
+                frame_stats_overlay_lines = format_frame_statistics(current_frame_stats);
             }
 
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, gl::default_framebuffer);
-            gl::set_viewport(make_box(make_point(0, 0), current_wnd_sz));
+            if(the_config->enable_frame_statistics) {
+                frame_stats_summary.add_frame(current_frame_stats);
+                log_frame_statistics();
+            }
 
-            gl::set_clear_color(solid(colors::black));
-            gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
-            gl::disable(gl::capability::depth_test);
-            gl::disable(gl::capability::cull_face);
+            if(frame_times.has_value() && is_building_game_frame) {
+                std::lock_guard<std::mutex> lk(frame_times_lock);
+                frame_times->add_frame(num_presented_frames, current_frame_stats);
+            }
 
-            // Copy to front buffer while converting to srgb
-            gl::use_program(ogs->post_to_srgb);
+            is_building_game_frame = false;
 
-            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+            {
+                std::lock_guard<std::mutex> lk(last_frame_stats_lock);
+                last_frame_stats = current_frame_stats;
+            }
 
-            gl::set_active_texture_unit(0);
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->screen_renderbuffer.tex);
-
-            int curr_em = 1;
-            if(the_config->enable_bloom) {
-                for(auto &hdr_stack_em : ogs->bloom_layers.elements) {
-                    gl::set_uniform_integer(gl::uniform_location_id(curr_em), curr_em);
-                    gl::set_active_texture_unit(curr_em);
-                    gl::bind_texture(gl::texture_bind_target::texture_2d, hdr_stack_em.a.tex);
-                    ++curr_em;
+            current_frame_stats = frame_statistics();
+        }
+
+        void log_frame_statistics()
+        {
+            auto summary = frame_stats_summary.take_summary();
+            if(!summary.has_value()) {
+                return;
+            }
+
+            auto const &mean = summary->mean;
+            auto const &max = summary->max;
+            LOG_INFO("Frame statistics over ",
+                     summary->num_frames,
+                     " frames (mean/max): frame ",
+                     static_cast<int>(mean.frame_time),
+                     "/",
+                     static_cast<int>(max.frame_time),
+                     " us, sort ",
+                     static_cast<int>(mean.sort_time),
+                     "/",
+                     static_cast<int>(max.sort_time),
+                     " us, world triangles ",
+                     mean.world_triangles,
+                     "/",
+                     max.world_triangles,
+                     " + ",
+                     mean.world_transparent_triangles,
+                     "/",
+                     max.world_transparent_triangles,
+                     " transparent, gun triangles ",
+                     mean.gun_triangles,
+                     "/",
+                     max.gun_triangles,
+                     " + ",
+                     mean.gun_transparent_triangles,
+                     "/",
+                     max.gun_transparent_triangles,
+                     " transparent, opaque pass triangles ",
+                     mean.num_opaque_triangles_drawn,
+                     "/",
+                     max.num_opaque_triangles_drawn,
+                     " in ",
+                     mean.num_opaque_draw_calls,
+                     "/",
+                     max.num_opaque_draw_calls,
+                     " draws, transparency pass triangles ",
+                     mean.num_transparent_triangles_drawn,
+                     "/",
+                     max.num_transparent_triangles_drawn,
+                     " in ",
+                     mean.num_transparent_draw_calls,
+                     "/",
+                     max.num_transparent_draw_calls,
+                     " draws, material switches ",
+                     mean.num_material_switches,
+                     "/",
+                     max.num_material_switches,
+                     ", vertices ",
+                     mean.num_vertices_streamed,
+                     "/",
+                     max.num_vertices_streamed,
+                     ", texture uploads ",
+                     mean.num_texture_uploads,
+                     "/",
+                     max.num_texture_uploads,
+                     " (",
+                     mean.texture_upload_bytes,
+                     "/",
+                     max.texture_upload_bytes,
+                     " bytes), texture hashes ",
+                     mean.num_texture_hashes,
+                     "/",
+                     max.num_texture_hashes,
+                     ", buffer growths ",
+                     mean.num_buffer_growths,
+                     "/",
+                     max.num_buffer_growths,
+                     ", batch expansions ",
+                     mean.num_batch_expansions,
+                     "/",
+                     max.num_batch_expansions);
+        }
+
+        void log_frame_times(std::string_view reason, bool reset)
+        {
+            if(!frame_times.has_value()) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lk(frame_times_lock);
+            frame_times->log_report(reason);
+            if(reset) {
+                frame_times->reset();
+            }
+        }
+
+        level_load_profiler *get_level_load_profiler() override
+        {
+            return level_loads.has_value() ? &*level_loads : nullptr;
+        }
+
+        void open_level_load_report()
+        {
+            if(!the_config->level_load_report_path.has_value()) {
+                return;
+            }
+
+            try {
+                level_load_report = make_file_output_stream(*the_config->level_load_report_path);
+            }
+            catch(std::exception const &e) {
+                LOG_WARNING("Failed to open level load report file: ", e.what());
+            }
+        }
+
+        void end_level_load()
+        {
+            if(!level_loads.has_value()) {
+                return;
+            }
+
+            auto summary = level_loads->end_load(materials.get_pack_names());
+            if(!summary.has_value()) {
+                return;
+            }
+
+            LOG_INFO("Level load: ", *summary);
+
+            if(level_load_report) {
+                // One JSON object per line
+                try {
+                    level_load_report->write(make_span(*summary + "\n"));
+                }
+                catch(std::exception const &e) {
+                    LOG_WARNING("Failed to write level load report file: ", e.what());
+                    level_load_report.reset();
                 }
             }
-            else {
-                for(auto &hdr_stack_em : ogs->bloom_layers.elements) {
-                    gl::set_uniform_integer(gl::uniform_location_id(curr_em), curr_em);
-                    gl::set_active_texture_unit(curr_em);
-                    gl::bind_texture(gl::texture_bind_target::texture_2d, gl::default_texture);
-                    ++curr_em;
+        }
+
+        void open_capture()
+        {
+            if(!the_config->capture_path.has_value() || the_config->capture_frames <= 0) {
+                return;
+            }
+
+            capture_header header;
+            header.screen_res = conf_scr_res;
+            header.internal_screen_res = internal_scr_res;
+            header.display_area = actual_display_area;
+            header.internal_screen_scale = internal_scr_res_scale_f;
+            header.internal_screen_offset = internal_scr_offset_f;
+
+            try {
+                capture = std::make_unique<capture_writer>(
+                    make_file_output_stream(*the_config->capture_path), header);
+                LOG_INFO("Capturing renderer inputs for ",
+                         the_config->capture_frames,
+                         " game frames to ",
+                         *the_config->capture_path);
+            }
+            catch(std::exception const &e) {
+                LOG_WARNING("Failed to open capture file: ", e.what());
+            }
+        }
+
+        template <class FnT>
+        void write_capture(FnT const &fn)
+        {
+            if(!capture) {
+                return;
+            }
+
+            try {
+                fn(*capture);
+            }
+            catch(std::exception const &e) {
+                LOG_WARNING("Failed to write capture file: ", e.what());
+                capture.reset();
+            }
+        }
+
+        void capture_texture_load(capture_texture_info const &info,
+                                  span<char const> pixels) override
+        {
+            write_capture([&](capture_writer &cw) { cw.write_texture_load(info, pixels); });
+        }
+
+        void capture_present_game()
+        {
+            if(!capture) {
+                return;
+            }
+
+            write_capture([&](capture_writer &cw) {
+                cw.write_present_game(make_span(ddraw1_backbuffer_surface.buffer).as_const_bytes());
+            });
+
+            if(++num_captured_game_frames >= the_config->capture_frames) {
+                LOG_INFO("Captured ", num_captured_game_frames, " game frames");
+                capture.reset();
+            }
+        }
+
+        frame_statistics get_frame_statistics() override
+        {
+            std::lock_guard<std::mutex> lk(last_frame_stats_lock);
+            return last_frame_stats;
+        }
+
+        void write_cpu_trace()
+        {
+            auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<float>(std::max(0.0f, the_config->cpu_trace_seconds)));
+
+            try {
+                write_chrome_trace(the_config->cpu_trace_path, window);
+                LOG_INFO("Wrote CPU trace to ", the_config->cpu_trace_path);
+            }
+            catch(std::exception const &e) {
+                LOG_WARNING("Failed to write CPU trace: ", e.what());
+            }
+        }
+
+        gl::timer_profiler *get_gpu_profiler()
+        {
+            return gpu_profiler.has_value() ? &*gpu_profiler : nullptr;
+        }
+
+        void open_gpu_profile_csv()
+        {
+            if(!the_config->gpu_profiler_csv_path.has_value()) {
+                return;
+            }
+
+            try {
+                gpu_profile_csv = make_file_output_stream(*the_config->gpu_profiler_csv_path);
+                gpu_profile_csv->write(make_span(std::string("frame,section,mean_us,max_us\n")));
+            }
+            catch(std::exception const &e) {
+                LOG_WARNING("Failed to open GPU profile CSV file: ", e.what());
+                gpu_profile_csv.reset();
+            }
+        }
+
+        void report_gpu_profile()
+        {
+            auto report = gpu_profiler->take_report();
+            if(!report.has_value()) {
+                return;
+            }
+
+            std::string log_message;
+            std::string csv_rows;
+            gpu_profile_overlay_lines.clear();
+            gpu_profile_overlay_lines.push_back("GPU (us)         mean    max");
+
+            for(auto const &section : *report) {
+                auto mean_time = static_cast<int>(section.mean_time);
+                auto max_time = static_cast<int>(section.max_time);
+
+                log_message += str(format(" ", section.name, " ", mean_time, "/", max_time));
+                csv_rows += str(format(
+                    num_presented_frames, ",", section.name, ",", mean_time, ",", max_time, "\n"));
+
+                auto label = section.name;
+                label.resize(std::max(label.size(), size_t(14U)), ' ');
+                gpu_profile_overlay_lines.push_back(
+                    str(format(label, width(7, mean_time), width(7, max_time))));
+            }
+
+            LOG_INFO("GPU profile (mean/max us):",
+                     log_message,
+                     " (",
+                     gpu_profiler->get_dropped_frames(),
+                     " frames dropped)");
+
+            if(gpu_profile_csv) {
+                try {
+                    gpu_profile_csv->write(make_span(csv_rows));
+                }
+                catch(std::exception const &e) {
+                    LOG_WARNING("Failed to write GPU profile CSV file: ", e.what());
+                    gpu_profile_csv.reset();
                 }
             }
+        }
 
-            curr_em = 5;
-            for(auto &hdr_stack_em : ogs->bloom_layers.elements) {
-                gl::set_uniform_float(gl::uniform_location_id(curr_em), hdr_stack_em.weight);
-                ++curr_em;
+        void draw_overlays()
+        {
+            // Panels stack downward from the top left corner
+            int scale = std::max(1, get<y>(internal_scr_res) / 480);
+            int next_y = 4 * scale;
+
+            if(the_config->enable_gpu_profiler_overlay && !gpu_profile_overlay_lines.empty()) {
+                next_y = draw_overlay_text(make_span(ogs->hud_texture_data),
+                                           internal_scr_res,
+                                           make_point(4 * scale, next_y),
+                                           gpu_profile_overlay_lines,
+                                           scale) +
+                         4 * scale;
             }
 
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
+            if(the_config->enable_frame_statistics_overlay && !frame_stats_overlay_lines.empty()) {
+                next_y = draw_overlay_text(make_span(ogs->hud_texture_data),
+                                           internal_scr_res,
+                                           make_point(4 * scale, next_y),
+                                           frame_stats_overlay_lines,
+                                           scale) +
+                         4 * scale;
+            }
+        }
 
-            SwapBuffers(hDC);
+        void log_frame_pacing()
+        {
+            auto stats = limiter->take_stats();
+            if(!stats.has_value()) {
+                return;
+            }
 
-            begin_frame();
+            LOG_INFO("Frame pacing over ",
+                     stats->num_frames,
+                     " frames: mean ",
+                     static_cast<int>(stats->mean_frame_time),
+                     " us, stddev ",
+                     static_cast<int>(stats->frame_time_stddev),
+                     " us, min ",
+                     static_cast<int>(stats->min_frame_time),
+                     " us, max ",
+                     static_cast<int>(stats->max_frame_time),
+                     " us");
+        }
+
+        void log_frame_latency()
+        {
+            auto stats = ogs->frame_fences->take_stats();
+            if(!stats.has_value()) {
+                return;
+            }
+
+            LOG_INFO("Frame latency over ",
+                     stats->num_frames,
+                     " frames: CPU submit ",
+                     static_cast<int>(stats->mean_cpu_submit_time),
+                     " us, GPU completion ",
+                     static_cast<int>(stats->mean_gpu_completion_time),
+                     " us, present ",
+                     static_cast<int>(stats->mean_present_latency),
+                     " us (max ",
+                     static_cast<int>(stats->max_present_latency),
+                     " us)");
         }
 
         HRESULT enumerate_devices(LPDDENUMCALLBACKA cb, LPVOID lpContext) override
@@ -638,7 +1294,21 @@ namespace jkgm {
             }
         }
 
-        void present_menu_gdi() override
+        void draw_menu()
+        {
+            gl::debug_group group("menu");
+
+            gl::enable(gl::capability::blend);
+            gl::disable(gl::capability::depth_test);
+            gl::use_program(ogs->menu_program);
+            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+
+            gl::bind_vertex_array(ogs->menumdl.vao);
+            gl::draw_elements(
+                gl::element_type::triangles, ogs->menumdl.num_indices, gl::index_type::uint32);
+        }
+
+        void present_menu_gdi_body()
         {
             if(!indexed_bitmap_source) {
                 end_frame();
@@ -663,17 +1333,24 @@ namespace jkgm {
                                  gl::texture_pixel_type::uint8,
                                  make_span(ogs->menu_texture_data).as_const_bytes());
 
-            // Render
-            gl::enable(gl::capability::blend);
-            gl::disable(gl::capability::depth_test);
-            gl::use_program(ogs->menu_program);
-            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+            draw_menu();
+            end_frame();
+        }
 
-            gl::bind_vertex_array(ogs->menumdl.vao);
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->menumdl.num_indices, gl::index_type::uint32);
+        void present_menu_gdi() override
+        {
+            if(throttle_in_background()) {
+                return;
+            }
 
-            end_frame();
+            write_capture([&](capture_writer &cw) {
+                auto source = make_span(indexed_bitmap_source,
+                                        indexed_bitmap_source ? menu_num_pixels : 0U);
+                cw.write_present_menu(make_span(indexed_bitmap_colors).as_const_bytes(), source);
+            });
+
+            // Menu frames read game memory directly, so they are not queued
+            rthread.call([this] { present_menu_gdi_body(); });
         }
 
         void present_menu_surface_body()
@@ -695,30 +1372,35 @@ namespace jkgm {
                                  gl::texture_pixel_type::uint8,
                                  make_span(ogs->menu_texture_data).as_const_bytes());
 
-            // Render
-            gl::enable(gl::capability::blend);
-            gl::disable(gl::capability::depth_test);
-            gl::use_program(ogs->menu_program);
-            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
-
-            gl::bind_vertex_array(ogs->menumdl.vao);
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->menumdl.num_indices, gl::index_type::uint32);
-
+            draw_menu();
             end_frame();
         }
 
+        void capture_present_menu_surface()
+        {
+            write_capture([&](capture_writer &cw) {
+                auto const &source = ddraw1_primary_menu_surface.buffer;
+                cw.write_present_menu(make_span(ddraw1_palette.srgb_entries).as_const_bytes(),
+                                      make_span(source).as_const_bytes());
+            });
+        }
+
         void present_menu_surface_immediate() override
         {
             menu_prev_ticks = std::chrono::high_resolution_clock::now();
             menu_curr_ticks = menu_prev_ticks;
             menu_accumulator = 0.0;
 
-            present_menu_surface_body();
+            capture_present_menu_surface();
+            rthread.call([this] { present_menu_surface_body(); });
         }
 
         void present_menu_surface_delayed() override
         {
+            if(throttle_in_background()) {
+                return;
+            }
+
             // Present menu, emulating a 60 Hz monitor
             menu_prev_ticks = menu_curr_ticks;
             menu_curr_ticks = std::chrono::high_resolution_clock::now();
@@ -728,22 +1410,27 @@ namespace jkgm {
             menu_accumulator += elapsed;
             if(menu_accumulator >= (1.0 / 60.0)) {
                 menu_accumulator = 0.0;
-                present_menu_surface_body();
+                capture_present_menu_surface();
+                rthread.call([this] { present_menu_surface_body(); });
             }
         }
 
-        void update_hud_texture()
+        void update_hud_texture(span<uint16_t const> hud_buffer)
         {
+            TRACE_SCOPE("update_hud_texture");
+
             ZeroMemory(ogs->hud_texture_data.data(), ogs->hud_texture_data.size());
 
-            for(size_t i = 0; i < ddraw1_backbuffer_surface.buffer.size(); ++i) {
-                auto const &in_em = ddraw1_backbuffer_surface.buffer[i];
+            for(size_t i = 0; i < hud_buffer.size(); ++i) {
+                auto const &in_em = hud_buffer.data()[i];
 
                 // Convert from RGB565 to RGBA8888
                 ogs->hud_texture_data[i] = rgb565_key_to_srgb_a8(
                     in_em, /*transparent?*/ in_em == ddraw1_backbuffer_surface.color_key);
             }
 
+            draw_overlays();
+
             // Blit texture data into texture
             gl::set_active_texture_unit(0);
             gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->hud_texture);
@@ -754,14 +1441,13 @@ namespace jkgm {
                              gl::texture_pixel_format::rgba,
                              gl::texture_pixel_type::uint8,
                              make_span(ogs->hud_texture_data).as_const_bytes());
-
-            for(auto &em : ddraw1_backbuffer_surface.buffer) {
-                em = ddraw1_backbuffer_surface.color_key;
-            }
         }
 
         void draw_hud()
         {
+            gl::debug_group group("hud");
+            gl::timer_profiler_scope scope(get_gpu_profiler(), "hud");
+
             gl::enable(gl::capability::blend);
             gl::disable(gl::capability::depth_test);
 
@@ -777,28 +1463,63 @@ namespace jkgm {
                 gl::element_type::triangles, ogs->hudmdl.num_indices, gl::index_type::uint32);
         }
 
-        void update_current_batch()
+        size_t get_material_shader_variant(material_instance_id id) override
         {
-            if(is_gun && is_transparent) {
-                current_triangle_batch = &gun_transparent_batch;
+            if(id.get() == 0U) {
+                return 0U;
             }
-            else if(is_gun) {
-                current_triangle_batch = &gun_batch;
+
+            auto const &mat = vidmem_texture_surfaces.at(id.get() - 1);
+
+            size_t rv = 0U;
+            if(mat->displacement_map.has_value() && mat->displacement_factor != 0.0f) {
+                rv |= game_shader_variant::parallax;
             }
-            else if(is_transparent) {
-                current_triangle_batch = &world_transparent_batch;
+
+            if(mat->alpha_mode == material_alpha_mode::mask) {
+                rv |= game_shader_variant::alpha_mask;
             }
-            else {
-                current_triangle_batch = &world_batch;
+
+            return rv;
+        }
+
+        bool get_material_has_alpha(material_instance_id id) override
+        {
+            if(id.get() == 0U) {
+                return false;
+            }
+
+            auto const &mat = vidmem_texture_surfaces.at(id.get() - 1);
+            if(get<a>(mat->albedo_factor) < 1.0f) {
+                return true;
+            }
+
+            return mat->albedo_map.has_value() &&
+                   at(ogs->srgb_textures, *mat->albedo_map).has_alpha;
+        }
+
+        void use_game_program(game_program_set const &progs, size_t variant)
+        {
+            auto const *prog = &progs.at(variant);
+            if(prog != current_program) {
+                gl::use_program(*prog);
+                current_program = prog;
             }
         }
 
-        void bind_material(material_instance_id id, bool force_opaque, bool posterize_lighting)
+        void bind_material(game_program_set const &progs,
+                           material_instance_id id,
+                           size_t variant,
+                           bool force_opaque)
         {
+            if(force_opaque) {
+                variant &= ~game_shader_variant::alpha_mask;
+            }
+
+            use_game_program(progs, variant);
+
             if(id.get() == 0U) {
                 // This is the default (untextured) material
-                gl::set_active_texture_unit(2);
-                gl::bind_texture(gl::texture_bind_target::texture_2d, gl::default_texture);
                 gl::set_active_texture_unit(1);
                 gl::bind_texture(gl::texture_bind_target::texture_2d, gl::default_texture);
                 gl::set_active_texture_unit(0);
@@ -807,21 +1528,13 @@ namespace jkgm {
                 // Enable features
                 gl::set_uniform_vector(gl::uniform_location_id(1),
                                        make_point(/*has albedo map*/ 0.0f,
-                                                  /*has emissive map*/ 0.0f,
-                                                  /*alpha mode*/ 0.0f,
-                                                  (posterize_lighting ? 1.0f : 0.0f)));
+                                                  /*has emissive map*/ 0.0f));
 
                 // Albedo factor
                 gl::set_uniform_vector(gl::uniform_location_id(3), color::fill(1.0f));
 
                 // Emissive factor
                 gl::set_uniform_vector(gl::uniform_location_id(5), color_rgb::zero());
-
-                // Displacement factor
-                gl::set_uniform_float(gl::uniform_location_id(8), 0.0f);
-
-                // Alpha cutoff
-                gl::set_uniform_float(gl::uniform_location_id(6), 0.0f);
             }
             else {
                 auto const &mat = vidmem_texture_surfaces.at(id.get() - 1);
@@ -836,60 +1549,67 @@ namespace jkgm {
                     emissive_map = at(ogs->srgb_textures, *mat->emissive_map).handle;
                 }
 
-                gl::texture_view displacement_map = gl::default_texture;
-                if(mat->displacement_map.has_value()) {
-                    displacement_map = at(ogs->linear_textures, *mat->displacement_map).handle;
+                if(variant & game_shader_variant::parallax) {
+                    gl::set_active_texture_unit(2);
+                    gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                     at(ogs->linear_textures, *mat->displacement_map).handle);
+                    gl::set_uniform_float(gl::uniform_location_id(8), mat->displacement_factor);
                 }
 
-                gl::set_active_texture_unit(2);
-                gl::bind_texture(gl::texture_bind_target::texture_2d, displacement_map);
                 gl::set_active_texture_unit(1);
                 gl::bind_texture(gl::texture_bind_target::texture_2d, emissive_map);
                 gl::set_active_texture_unit(0);
                 gl::bind_texture(gl::texture_bind_target::texture_2d, albedo_map);
 
                 // Enable features
-                gl::set_uniform_vector(
-                    gl::uniform_location_id(1),
-                    make_point(mat->albedo_map.has_value() ? 1.0f : 0.0f,
-                               mat->emissive_map.has_value() ? 1.0f : 0.0f,
-                               ((mat->alpha_mode == material_alpha_mode::mask) && (!force_opaque))
-                                   ? 1.0f
-                                   : 0.0f,
-                               (posterize_lighting ? 1.0f : 0.0f)));
+                gl::set_uniform_vector(gl::uniform_location_id(1),
+                                       make_point(mat->albedo_map.has_value() ? 1.0f : 0.0f,
+                                                  mat->emissive_map.has_value() ? 1.0f : 0.0f));
 
                 gl::set_uniform_vector(gl::uniform_location_id(3), mat->albedo_factor);
                 gl::set_uniform_vector(gl::uniform_location_id(5), mat->emissive_factor);
-                gl::set_uniform_float(gl::uniform_location_id(8), mat->displacement_factor);
-                gl::set_uniform_float(gl::uniform_location_id(6), mat->alpha_cutoff);
+
+                if(variant & game_shader_variant::alpha_mask) {
+                    gl::set_uniform_float(gl::uniform_location_id(6), mat->alpha_cutoff);
+                }
             }
 
             current_material = id;
         }
 
-        void draw_batch(triangle_batch const &tb,
+        // Alpha tested triangles are drawn with alpha_test_progs, when present
+        void draw_batch(game_program_set const &progs,
+                        triangle_batch const &tb,
                         triangle_buffer_model *trimdl,
                         bool force_opaque,
-                        bool posterize_lighting)
+                        game_program_set const *alpha_test_progs = nullptr)
         {
             gl::bind_vertex_array(trimdl->vao);
 
             size_t curr_offset = 0U;
             size_t num_verts = 0U;
 
-            bind_material(material_instance_id(0U), force_opaque, posterize_lighting);
+            bind_material(progs, material_instance_id(0U), 0U, force_opaque);
+            bool current_alpha_test = false;
 
             for(auto const &tri : tb) {
-                if(current_material != tri.material) {
+                bool alpha_test = tri.alpha_test && (alpha_test_progs != nullptr);
+                if(current_material != tri.material || current_alpha_test != alpha_test) {
                     // Draw pending elements from previous material
                     if(num_verts > 0) {
                         gl::draw_arrays(gl::element_type::triangles, curr_offset, num_verts);
+                        ++current_pass_counters->num_draw_calls;
 
                         curr_offset += num_verts;
                         num_verts = 0U;
                     }
 
-                    bind_material(tri.material, force_opaque, posterize_lighting);
+                    bind_material(alpha_test ? *alpha_test_progs : progs,
+                                  tri.material,
+                                  tri.shader_variant,
+                                  force_opaque);
+                    current_alpha_test = alpha_test;
+                    ++current_frame_stats.num_material_switches;
                 }
 
                 num_verts += 3;
@@ -897,47 +1617,45 @@ namespace jkgm {
 
             if(num_verts > 0) {
                 gl::draw_arrays(gl::element_type::triangles, curr_offset, num_verts);
+                ++current_pass_counters->num_draw_calls;
 
                 curr_offset += num_verts;
                 num_verts = 0U;
             }
+
+            current_pass_counters->num_triangles += tb.size();
         }
 
         void fill_buffer(triangle_batch const &tb, triangle_buffer_model *mdl)
         {
-            mdl->maybe_grow_buffers(tb.capacity() * 3);
-
-            auto *vx = mdl->mmio.data();
-            for(auto const &tri : tb) {
-                vx->pos = tri.v0.pos;
-                vx->texcoords = tri.v0.texcoords;
-                vx->col = tri.v0.color;
-                vx->normal = tri.normal;
-
-                ++vx;
+            TRACE_SCOPE("fill_buffer");
 
-                vx->pos = tri.v1.pos;
-                vx->texcoords = tri.v1.texcoords;
-                vx->col = tri.v1.color;
-                vx->normal = tri.normal;
+            if(mdl->maybe_grow_buffers(tb.capacity() * 3,
+                                       /*unsynchronized*/ ogs->frame_fences != nullptr)) {
+                ++current_frame_stats.num_buffer_growths;
+            }
 
-                ++vx;
+            mdl->num_vertices = static_cast<int>(pack_triangle_buffer(tb, mdl->mmio));
+            mdl->update_buffers();
 
-                vx->pos = tri.v2.pos;
-                vx->texcoords = tri.v2.texcoords;
-                vx->col = tri.v2.color;
-                vx->normal = tri.normal;
+            current_frame_stats.num_vertices_streamed += mdl->num_vertices;
+        }
 
-                ++vx;
+        void begin_game_programs(game_program_set const &progs)
+        {
+            for(auto const &prog : progs) {
+                gl::use_program(prog);
+                gl::set_uniform_vector(gl::uniform_location_id(0),
+                                       static_cast<size<2, float>>(conf_scr_res));
             }
 
-            mdl->num_vertices = tb.size() * 3;
-            mdl->update_buffers();
+            current_program = nullptr;
         }
 
-        void draw_game_opaque_into_gbuffer(triangle_buffer_models *trimdl, bool posterize_lighting)
+        void draw_game_opaque_into_gbuffer(triangle_buffer_models *trimdl)
         {
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->gbuffer.fbo);
+            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->gbuffer->fbo);
+            gl::set_viewport(ogs->gbuffer->viewport);
             gl::clear_buffer_depth(1.0f);
             gl::clear_buffer_color(0, color::zero());
             gl::clear_buffer_color(1, color::zero());
@@ -953,132 +1671,251 @@ namespace jkgm {
                                    gl::blend_function::one_minus_source_alpha);
             gl::set_depth_function(gl::comparison_function::less);
 
-            gl::use_program(ogs->game_opaque_pass_program);
-
-            gl::set_uniform_vector(gl::uniform_location_id(0),
-                                   static_cast<size<2, float>>(conf_scr_res));
-            gl::set_uniform_integer(gl::uniform_location_id(2), 0);
-            gl::set_uniform_integer(gl::uniform_location_id(4), 1);
-            gl::set_uniform_integer(gl::uniform_location_id(7), 2);
+            // Opaque programs never discard, so early depth testing stays enabled for them.
+            // Batches are sorted with alpha tested triangles last.
+            auto const &progs = ogs->game_opaque_pass_programs;
+            auto const &at_progs = ogs->game_alpha_test_pass_programs;
+            begin_game_programs(progs);
+            begin_game_programs(at_progs);
+            current_pass_counters = &opaque_pass_counters;
 
             // Draw first pass (opaque world geometry)
+            gl::set_depth_range(weapon_depth_range, 1.0f);
             draw_batch(
-                world_batch, &trimdl->world_trimdl, /*force opaque*/ true, posterize_lighting);
+                progs, world_batch, &trimdl->world_trimdl, /*force opaque*/ true, &at_progs);
 
             // Draw second pass (transparent world geometry with alpha testing)
-            draw_batch(world_transparent_batch,
+            draw_batch(at_progs,
+                       world_transparent_batch,
                        &trimdl->world_transparent_trimdl,
-                       /*force opaque*/ true,
-                       posterize_lighting);
+                       /*force opaque*/ true);
 
             // Draw fourth pass (opaque gun geometry)
-            draw_batch(gun_batch, &trimdl->gun_trimdl, /*force opaque*/ true, posterize_lighting);
+            gl::set_depth_range(0.0f, weapon_depth_range);
+            draw_batch(progs, gun_batch, &trimdl->gun_trimdl, /*force opaque*/ true, &at_progs);
 
             // Draw fifth pass (transparent gun geometry with alpha testing)
-            draw_batch(gun_transparent_batch,
+            draw_batch(at_progs,
+                       gun_transparent_batch,
                        &trimdl->gun_transparent_trimdl,
-                       /*force opaque*/ true,
-                       posterize_lighting);
+                       /*force opaque*/ true);
+
+            gl::set_depth_range(0.0f, 1.0f);
         }
 
-        void draw_game_ssao_postprocess()
+        void draw_game_post_opaque_passes()
         {
-            // Compute SSAO:
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->ssao_occlusionbuffer->fbo);
-            gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
-
-            gl::use_program(ogs->game_post_ssao_program);
-            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
-            gl::set_uniform_integer(gl::uniform_location_id(1), 1);
+            gl::disable(gl::capability::depth_test);
+            gl::bind_vertex_array(ogs->postmdl.vao);
 
-            for(size_t i = 0; i < ssao_kernel.size(); ++i) {
-                gl::set_uniform_vector(gl::uniform_location_id(2 + i), ssao_kernel[i]);
+            render_graph rg;
+            auto color_tex = rg.import_texture("gbuffer_color", ogs->gbuffer->color_tex);
+            auto emissive_tex = rg.import_texture("gbuffer_emissive", ogs->gbuffer->emissive_tex);
+            auto depth_nrm_tex =
+                rg.import_texture("gbuffer_depth_nrm", ogs->gbuffer->depth_nrm_tex);
+            auto &scene_renderbuffer = ogs->get_scene_renderbuffer();
+            auto scene = rg.import_target("scene",
+                                          scene_renderbuffer.fbo,
+                                          scene_renderbuffer.viewport,
+                                          scene_renderbuffer.tex);
+
+            std::vector<render_graph_resource_id> composite_reads{color_tex, emissive_tex};
+            std::optional<render_graph_resource_id> occlusion_result;
+
+            if(quality.enable_ssao && !is_background_throttled) {
+                render_graph_texture_desc ssao_desc{scene_renderbuffer.viewport.size(),
+                                                    gl::texture_internal_format::r16f,
+                                                    gl::texture_pixel_format::red};
+                auto occlusion = rg.create_texture("ssao_occlusion", ssao_desc);
+                auto occlusion_blur = rg.create_texture("ssao_blur", ssao_desc);
+
+                // Compute SSAO:
+                rg.add_pass("ssao",
+                            {depth_nrm_tex},
+                            occlusion,
+                            render_graph_load_op::dont_care,
+                            [&](render_graph_context const &ctx) {
+                                gl::use_program(ogs->game_post_ssao_program);
+                                gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                                gl::set_uniform_integer(gl::uniform_location_id(1), 1);
+
+                                for(size_t i = 0; i < ssao_kernel.size(); ++i) {
+                                    gl::set_uniform_vector(gl::uniform_location_id(2 + i),
+                                                           ssao_kernel[i]);
+                                }
+
+                                gl::set_active_texture_unit(1);
+                                gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                 *ogs->ssao_noise_texture);
+
+                                gl::set_active_texture_unit(0);
+                                gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                 ctx.get_texture(depth_nrm_tex));
+
+                                gl::draw_elements(gl::element_type::triangles,
+                                                  ogs->postmdl.num_indices,
+                                                  gl::index_type::uint32);
+                            });
+
+                // Blur SSAO:
+                auto add_blur_pass = [&](render_graph_resource_id src,
+                                         render_graph_resource_id dst,
+                                         direction<2, float> dir) {
+                    rg.add_pass("ssao_blur",
+                                {src},
+                                dst,
+                                render_graph_load_op::dont_care,
+                                [this, src, dir](render_graph_context const &ctx) {
+                                    gl::use_program(ogs->post_gauss3);
+                                    gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                                    gl::set_uniform_vector(
+                                        gl::uniform_location_id(1),
+                                        static_cast<size<2, float>>(ctx.viewport().size()));
+                                    gl::set_uniform_vector(gl::uniform_location_id(2), dir);
+
+                                    gl::set_active_texture_unit(0);
+                                    gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                     ctx.get_texture(src));
+                                    gl::draw_elements(gl::element_type::triangles,
+                                                      ogs->postmdl.num_indices,
+                                                      gl::index_type::uint32);
+                                });
+                };
+
+                add_blur_pass(occlusion, occlusion_blur, make_direction(1.0f, 0.0f));
+                add_blur_pass(occlusion_blur, occlusion, make_direction(0.0f, 1.0f));
+
+                composite_reads.push_back(occlusion);
+                occlusion_result = occlusion;
             }
 
-            gl::set_active_texture_unit(1);
-            gl::bind_texture(gl::texture_bind_target::texture_2d, *ogs->ssao_noise_texture);
+            // Composite opaque layers. Only the color attachment is overwritten; the depth buffer
+            // is still needed by the transparency pass.
+            rg.add_pass("opaque_composite",
+                        composite_reads,
+                        scene,
+                        render_graph_load_op::dont_care,
+                        [&](render_graph_context const &ctx) {
+                            gl::use_program(ogs->game_post_opaque_composite_program);
+                            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                            gl::set_uniform_integer(gl::uniform_location_id(1), 1);
+                            gl::set_uniform_integer(gl::uniform_location_id(2), 2);
+
+                            gl::set_active_texture_unit(2);
+                            if(occlusion_result.has_value()) {
+                                gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                 ctx.get_texture(*occlusion_result));
+                            }
+                            else {
+                                gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                                 gl::default_texture);
+                            }
 
-            gl::set_active_texture_unit(0);
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->gbuffer.depth_nrm_tex);
+                            gl::set_active_texture_unit(1);
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(emissive_tex));
 
-            gl::bind_vertex_array(ogs->postmdl.vao);
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
+                            gl::set_active_texture_unit(0);
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(color_tex));
 
-            // Blur SSAO:
-            gl::use_program(ogs->post_gauss3);
-            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                            gl::draw_elements(gl::element_type::triangles,
+                                              ogs->postmdl.num_indices,
+                                              gl::index_type::uint32);
+                        });
 
-            auto hdr_vp_size =
-                static_cast<size<2, float>>(ogs->screen_renderbuffer.viewport.size());
-            gl::set_uniform_vector(gl::uniform_location_id(1), hdr_vp_size);
+            rg.execute(&ogs->render_targets, get_gpu_profiler());
+        }
 
-            // - Horizontal:
-            gl::set_uniform_vector(gl::uniform_location_id(2), make_direction(1.0f, 0.0f));
+        void draw_game_gbuffer_pass(triangle_buffer_models *trimdl)
+        {
+            begin_benchmark_pass(benchmark_pass::geometry);
+            {
+                gl::debug_group group("gbuffer");
+                gl::timer_profiler_scope scope(get_gpu_profiler(), "gbuffer");
+                draw_game_opaque_into_gbuffer(trimdl);
+            }
+            end_benchmark_pass(benchmark_pass::geometry);
 
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_postbuffer1.fbo);
-            gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+            // Includes the opaque composite, which is negligible next to SSAO
+            begin_benchmark_pass(benchmark_pass::ssao);
+            {
+                gl::debug_group group("post_opaque");
+                draw_game_post_opaque_passes();
+            }
+            end_benchmark_pass(benchmark_pass::ssao);
+        }
 
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->ssao_occlusionbuffer->tex);
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
+        void draw_game_weighted_oit_pass(triangle_buffer_models *trimdl)
+        {
+            gl::debug_group group("weighted_oit");
+            auto const &oit = *ogs->oit_buffer;
 
-            // - Vertical:
-            gl::set_uniform_vector(gl::uniform_location_id(2), make_direction(0.0f, 1.0f));
+            gl::bind_framebuffer(gl::framebuffer_bind_target::any, oit.fbo);
+            gl::clear_buffer_color(0, color(0.0f, 0.0f, 0.0f, 1.0f));
+            gl::clear_buffer_color(1, color::zero());
+            gl::clear_buffer_color(2, color::zero());
 
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->ssao_occlusionbuffer->fbo);
-            gl::clear({gl::clear_flag::color, gl::clear_flag::depth});
+            // Accumulate transparent world geometry in any order. Opaque depth still occludes.
+            gl::enable(gl::capability::blend);
+            gl::enable(gl::capability::depth_test);
+            gl::set_depth_mask(false);
+            gl::disable(gl::capability::cull_face);
+            gl::set_blend_function_separate(gl::blend_function::one,
+                                            gl::blend_function::one,
+                                            gl::blend_function::zero,
+                                            gl::blend_function::one_minus_source_alpha);
+            gl::set_depth_function(gl::comparison_function::less);
 
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->screen_postbuffer1.tex);
-            gl::draw_elements(
-                gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
-        }
+            auto const &progs = ogs->game_oit_pass_programs;
+            begin_game_programs(progs);
+            gl::set_active_texture_unit(0);
+            current_pass_counters = &transparency_pass_counters;
 
-        void draw_game_opaque_composite()
-        {
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_renderbuffer.fbo);
-            gl::clear({gl::clear_flag::color});
+            gl::set_depth_range(weapon_depth_range, 1.0f);
+            draw_batch(progs,
+                       world_transparent_batch,
+                       &trimdl->world_transparent_trimdl,
+                       /*force opaque*/ false);
+            gl::set_depth_range(0.0f, 1.0f);
+
+            // Resolve over the opaque image. The composite outputs premultiplied color so that
+            // emitted light is added.
+            gl::bind_framebuffer(gl::framebuffer_bind_target::any,
+                                 ogs->get_scene_renderbuffer().fbo);
             gl::disable(gl::capability::depth_test);
+            gl::set_blend_function(gl::blend_function::one,
+                                   gl::blend_function::one_minus_source_alpha);
 
-            gl::use_program(ogs->game_post_opaque_composite_program);
+            gl::use_program(ogs->game_post_oit_composite_program);
             gl::set_uniform_integer(gl::uniform_location_id(0), 0);
             gl::set_uniform_integer(gl::uniform_location_id(1), 1);
             gl::set_uniform_integer(gl::uniform_location_id(2), 2);
 
             gl::set_active_texture_unit(2);
-            if(the_config->enable_ssao) {
-                gl::bind_texture(gl::texture_bind_target::texture_2d,
-                                 ogs->ssao_occlusionbuffer->tex);
-            }
-            else {
-                gl::bind_texture(gl::texture_bind_target::texture_2d, gl::default_texture);
-            }
-
+            gl::bind_texture(gl::texture_bind_target::texture_2d, oit.emissive_tex);
             gl::set_active_texture_unit(1);
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->gbuffer.emissive_tex);
-
+            gl::bind_texture(gl::texture_bind_target::texture_2d, oit.weight_tex);
             gl::set_active_texture_unit(0);
-            gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->gbuffer.color_tex);
+            gl::bind_texture(gl::texture_bind_target::texture_2d, oit.accum_tex);
 
             gl::bind_vertex_array(ogs->postmdl.vao);
             gl::draw_elements(
                 gl::element_type::triangles, ogs->postmdl.num_indices, gl::index_type::uint32);
+
+            current_program = nullptr;
         }
 
-        void draw_game_gbuffer_pass(triangle_buffer_models *trimdl, bool posterize_lighting)
+        void draw_game_transparency_pass(triangle_buffer_models *trimdl)
         {
-            draw_game_opaque_into_gbuffer(trimdl, posterize_lighting);
-
-            if(the_config->enable_ssao) {
-                draw_game_ssao_postprocess();
+            bool weighted_oit = (ogs->oit_buffer != nullptr);
+            if(weighted_oit) {
+                draw_game_weighted_oit_pass(trimdl);
             }
 
-            draw_game_opaque_composite();
-        }
-
-        void draw_game_transparency_pass(triangle_buffer_models *trimdl, bool posterize_lighting)
-        {
-            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_renderbuffer.fbo);
+            auto const &scene_renderbuffer = ogs->get_scene_renderbuffer();
+            gl::bind_framebuffer(gl::framebuffer_bind_target::any, scene_renderbuffer.fbo);
+            gl::set_viewport(scene_renderbuffer.viewport);
 
             // Draw batches
             gl::disable(gl::capability::blend);
@@ -1090,66 +1927,205 @@ namespace jkgm {
                                    gl::blend_function::one_minus_source_alpha);
             gl::set_depth_function(gl::comparison_function::less);
 
-            gl::use_program(ogs->game_transparency_pass_program);
-            gl::set_uniform_vector(gl::uniform_location_id(0),
-                                   static_cast<size<2, float>>(conf_scr_res));
-            gl::set_uniform_integer(gl::uniform_location_id(2), 0);
-            gl::set_uniform_integer(gl::uniform_location_id(4), 1);
-            gl::set_uniform_integer(gl::uniform_location_id(7), 2);
+            auto const &progs = ogs->game_transparency_pass_programs;
+            begin_game_programs(progs);
             gl::set_active_texture_unit(0);
+            current_pass_counters = &transparency_pass_counters;
 
-            // Draw third pass (transparent world geometry with alpha blending)
+            // Draw third pass (transparent world geometry with alpha blending). The opaque gun
+            // geometry is already in the depth buffer in front of the world depth range.
             gl::enable(gl::capability::blend);
             gl::set_depth_mask(false);
-            draw_batch(world_transparent_batch,
-                       &trimdl->world_transparent_trimdl,
-                       /*force opaque*/ false,
-                       posterize_lighting);
-
-            // Redraw gun overlay after z-clear
-            gl::set_depth_mask(true);
-            gl::clear({gl::clear_flag::depth});
-
-            draw_batch(gun_batch, &trimdl->gun_trimdl, /*force opaque*/ true, posterize_lighting);
-            draw_batch(gun_transparent_batch,
-                       &trimdl->gun_transparent_trimdl,
-                       /*force opaque*/ true,
-                       posterize_lighting);
+            if(!weighted_oit) {
+                gl::set_depth_range(weapon_depth_range, 1.0f);
+                draw_batch(progs,
+                           world_transparent_batch,
+                           &trimdl->world_transparent_trimdl,
+                           /*force opaque*/ false);
+            }
 
             // Draw gun transparency
-            draw_batch(gun_transparent_batch,
-                       &trimdl->gun_transparent_trimdl, /*force opaque*/
-                       false,
-                       posterize_lighting);
+            gl::set_depth_range(0.0f, weapon_depth_range);
+            draw_batch(progs,
+                       gun_transparent_batch,
+                       &trimdl->gun_transparent_trimdl,
+                       /*force opaque*/ false);
 
+            gl::set_depth_range(0.0f, 1.0f);
             gl::enable(gl::capability::depth_test);
             gl::enable(gl::capability::blend);
             gl::set_depth_mask(true);
         }
 
+        float get_fixed_render_scale() const
+        {
+            return std::clamp(quality.render_scale, min_render_scale, max_render_scale);
+        }
+
+        void set_quality_settings(quality_settings const &settings)
+        {
+            quality = settings;
+            parallax_enabled = settings.enable_parallax;
+
+            // Timer queries cannot nest, so the benchmark runs without dynamic resolution
+            dynamic_render_scale.reset();
+            if(the_config->enable_dynamic_render_scale && !benchmark.has_value()) {
+                dynamic_render_scale.emplace(std::clamp(the_config->min_render_scale,
+                                                        min_render_scale,
+                                                        max_render_scale),
+                                             get_fixed_render_scale(),
+                                             the_config->target_frame_time);
+            }
+        }
+
+        void initialize_automatic_quality()
+        {
+            auto_quality_profile.hardware_signature =
+                str(format(gl::get_string(gl::string_name::vendor),
+                           "\n",
+                           gl::get_string(gl::string_name::renderer),
+                           "\n",
+                           gl::get_string(gl::string_name::version)));
+            auto_quality_profile.resolution = the_config->resolution;
+            auto_quality_profile.target_frame_time = the_config->target_frame_time;
+
+            auto stored = load_quality_profile(auto_quality_profile);
+            if(stored.has_value()) {
+                LOG_INFO("Using stored quality profile");
+                set_quality_settings(*stored);
+                return;
+            }
+
+            LOG_INFO("Running quality benchmark");
+            benchmark.emplace();
+            set_quality_settings(quality_benchmark::get_benchmark_settings());
+        }
+
+        void finish_quality_benchmark()
+        {
+            auto_quality_profile.settings = benchmark->choose_settings(
+                std::clamp(the_config->min_render_scale, min_render_scale, max_render_scale),
+                the_config->target_frame_time);
+            benchmark.reset();
+
+            auto const &settings = auto_quality_profile.settings;
+            LOG_INFO("Quality benchmark chose bloom ",
+                     settings.enable_bloom,
+                     ", SSAO ",
+                     settings.enable_ssao,
+                     ", parallax ",
+                     settings.enable_parallax,
+                     ", anisotropy ",
+                     static_cast<int>(settings.max_anisotropy),
+                     "x, render scale ",
+                     static_cast<int>(settings.render_scale * 100.0f + 0.5f),
+                     "%");
+
+            save_quality_profile(auto_quality_profile);
+
+            // Parallax and anisotropy apply to textures loaded from now on
+            set_quality_settings(settings);
+        }
+
+        void begin_benchmark_pass(benchmark_pass pass)
+        {
+            if(benchmark.has_value()) {
+                benchmark->begin_pass(pass);
+            }
+        }
+
+        void end_benchmark_pass(benchmark_pass pass)
+        {
+            if(benchmark.has_value()) {
+                benchmark->end_pass(pass);
+            }
+        }
+
+        void draw_game_upscale_pass()
+        {
+            gl::disable(gl::capability::depth_test);
+            gl::disable(gl::capability::blend);
+            gl::bind_vertex_array(ogs->postmdl.vao);
+
+            render_graph rg;
+            auto scene_tex = rg.import_texture("scene", ogs->scene_renderbuffer->tex);
+            auto screen = rg.import_target("screen",
+                                           ogs->screen_renderbuffer.fbo,
+                                           ogs->screen_renderbuffer.viewport,
+                                           ogs->screen_renderbuffer.tex);
+            auto upscaled = rg.create_texture(
+                "upscaled",
+                render_graph_texture_desc{ogs->screen_renderbuffer.viewport.size(),
+                                          gl::texture_internal_format::rgba16f,
+                                          gl::texture_pixel_format::rgba});
+
+            rg.add_pass("upscale",
+                        {scene_tex},
+                        upscaled,
+                        render_graph_load_op::dont_care,
+                        [&](render_graph_context const &ctx) {
+                            gl::use_program(ogs->post_upscale);
+                            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+
+                            gl::set_active_texture_unit(0);
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(scene_tex));
+
+                            gl::draw_elements(gl::element_type::triangles,
+                                              ogs->postmdl.num_indices,
+                                              gl::index_type::uint32);
+                        });
+
+            rg.add_pass("sharpen",
+                        {upscaled},
+                        screen,
+                        render_graph_load_op::dont_care,
+                        [&](render_graph_context const &ctx) {
+                            gl::use_program(ogs->post_sharpen);
+                            gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+                            gl::set_uniform_float(
+                                gl::uniform_location_id(1),
+                                std::clamp(the_config->upscale_sharpness, 0.0f, 1.0f));
+
+                            gl::set_active_texture_unit(0);
+                            gl::bind_texture(gl::texture_bind_target::texture_2d,
+                                             ctx.get_texture(upscaled));
+
+                            gl::draw_elements(gl::element_type::triangles,
+                                              ogs->postmdl.num_indices,
+                                              gl::index_type::uint32);
+                        });
+
+            rg.execute(&ogs->render_targets, get_gpu_profiler());
+
+            // The HUD is drawn over the upscaled image at full resolution
+            gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_renderbuffer.fbo);
+            gl::set_viewport(ogs->screen_renderbuffer.viewport);
+        }
+
         void begin_game() override {}
 
         void end_game() override {}
 
-        static point<4, float> d3dtl_to_point(size<2, float> const &scr_scale,
-                                              direction<2, float> const &screen_offset,
-                                              D3DTLVERTEX const &p)
+        void execute_game_commands(span<D3DTLVERTEX const> vertex_span,
+                                   span<char const> cmd_span)
         {
-            // Reassign w for full-screen overlay vertices
-            float w = 1.0f;
-            if(p.rhw != 0.0f) {
-                w = 1.0f / p.rhw;
+            try {
+                translator.translate(
+                    make_span((d3d::tl_vertex const *)vertex_span.data(), vertex_span.size()),
+                    cmd_span,
+                    internal_scr_res_scale_f,
+                    internal_scr_offset_f);
+            }
+            catch(std::runtime_error const &e) {
+                LOG_ERROR("Dropped the rest of a malformed execute buffer: ", e.what());
             }
-
-            // Convert pretransformed vertex to phony view space
-            return make_point(w * ((p.sx * get<x>(scr_scale)) - 1.0f + get<x>(screen_offset)),
-                              w * ((-p.sy * get<y>(scr_scale)) + 1.0f - get<y>(screen_offset)),
-                              w * (-p.sz),
-                              w);
         }
 
         void execute_game(IDirect3DExecuteBuffer *cmdbuf, IDirect3DViewport *vp) override
         {
+            TRACE_SCOPE("execute_game");
+
             D3DEXECUTEDATA ed;
             cmdbuf->GetExecuteData(&ed);
 
@@ -1166,162 +2142,147 @@ namespace jkgm {
             auto cmd_span = make_span((char const *)ebd.lpData + ed.dwInstructionOffset,
                                       ed.dwInstructionLength);
 
-            while(!cmd_span.empty()) {
-                D3DINSTRUCTION inst = *(D3DINSTRUCTION const *)cmd_span.data();
-                cmd_span = cmd_span.subspan(sizeof(D3DINSTRUCTION), span_to_end);
-
-                for(size_t i = 0; i < inst.wCount; ++i) {
-                    switch(inst.bOpcode) {
-                    case D3DOP_EXIT:
-                        break;
-
-                    case D3DOP_PROCESSVERTICES: {
-                        auto const *payload = (D3DPROCESSVERTICES const *)cmd_span.data();
-                        if(payload->dwFlags != D3DPROCESSVERTICES_COPY || payload->wStart != 0 ||
-                           payload->wDest != 0) {
-                            report_unimplemented_function(str(format("Process vertices opcode: ",
-                                                                     payload->dwFlags,
-                                                                     " ",
-                                                                     payload->dwCount,
-                                                                     " ",
-                                                                     payload->wStart,
-                                                                     " ",
-                                                                     payload->wDest)));
-                        }
-                    } break;
-
-                    case D3DOP_STATERENDER: {
-                        auto const *payload = (D3DSTATE const *)cmd_span.data();
-                        switch(payload->drstRenderStateType) {
-                        case D3DRENDERSTATE_TEXTUREHANDLE:
-                            current_material = material_instance_id((size_t)payload->dwArg[0]);
-                            break;
-
-                        // Silently ignore some useless commands
-                        case D3DRENDERSTATE_ANTIALIAS:
-                        case D3DRENDERSTATE_TEXTUREPERSPECTIVE:
-                        case D3DRENDERSTATE_FILLMODE:
-                        case D3DRENDERSTATE_TEXTUREMAG:
-                        case D3DRENDERSTATE_TEXTUREMIN:
-                        case D3DRENDERSTATE_SRCBLEND:
-                        case D3DRENDERSTATE_WRAPU:
-                        case D3DRENDERSTATE_WRAPV:
-                        case D3DRENDERSTATE_DESTBLEND:
-                        case D3DRENDERSTATE_ALPHAFUNC:
-                        case D3DRENDERSTATE_DITHERENABLE:
-                        case D3DRENDERSTATE_FOGENABLE:
-                        case D3DRENDERSTATE_SUBPIXEL:
-                        case D3DRENDERSTATE_SUBPIXELX:
-                        case D3DRENDERSTATE_TEXTUREMAPBLEND:
-                        case D3DRENDERSTATE_STIPPLEDALPHA:
-                        case D3DRENDERSTATE_SHADEMODE:
-                        case D3DRENDERSTATE_ZENABLE:
-                        case D3DRENDERSTATE_SPECULARENABLE:
-                        case D3DRENDERSTATE_ALPHATESTENABLE:
-                        case D3DRENDERSTATE_CULLMODE:
-                        case D3DRENDERSTATE_ZFUNC:
-                        case D3DRENDERSTATE_MONOENABLE:
-                            break;
-
-                        case D3DRENDERSTATE_ALPHABLENDENABLE:
-                            is_transparent = (payload->dwArg[0] != 0);
-                            update_current_batch();
-                            break;
-
-                        case D3DRENDERSTATE_ZWRITEENABLE:
-                            if(!payload->dwArg[0]) {
-                                // ACTUALLY means drawing the weapon overlay.
-                                is_gun = true;
-                                update_current_batch();
-                            }
-                            break;
-
-                        default:
-                            LOG_WARNING("Ignored unknown state render opcode: ",
-                                        (int)payload->dtstTransformStateType);
-                            break;
-                        }
-                    } break;
-
-                    case D3DOP_TRIANGLE: {
-                        auto const *payload = (D3DTRIANGLE const *)cmd_span.data();
-
-                        auto const &v1 = vertex_span.data()[payload->v1];
-                        auto const &v2 = vertex_span.data()[payload->v2];
-                        auto const &v3 = vertex_span.data()[payload->v3];
-
-                        auto c1 = srgb_to_linear(
-                            to_float_color(color_rgba8((uint8_t)RGBA_GETRED(v1.color),
-                                                       (uint8_t)RGBA_GETGREEN(v1.color),
-                                                       (uint8_t)RGBA_GETBLUE(v1.color),
-                                                       (uint8_t)RGBA_GETALPHA(v1.color))));
-                        auto c2 = srgb_to_linear(
-                            to_float_color(color_rgba8((uint8_t)RGBA_GETRED(v2.color),
-                                                       (uint8_t)RGBA_GETGREEN(v2.color),
-                                                       (uint8_t)RGBA_GETBLUE(v2.color),
-                                                       (uint8_t)RGBA_GETALPHA(v2.color))));
-                        auto c3 = srgb_to_linear(
-                            to_float_color(color_rgba8((uint8_t)RGBA_GETRED(v3.color),
-                                                       (uint8_t)RGBA_GETGREEN(v3.color),
-                                                       (uint8_t)RGBA_GETBLUE(v3.color),
-                                                       (uint8_t)RGBA_GETALPHA(v3.color))));
-
-                        current_triangle_batch->insert(triangle(
-                            triangle_vertex(
-                                d3dtl_to_point(internal_scr_res_scale_f, internal_scr_offset_f, v1),
-                                make_point(v1.tu, v1.tv),
-                                extend(get<rgb>(c1) * get<a>(c1), get<a>(c1))),
-                            triangle_vertex(
-                                d3dtl_to_point(internal_scr_res_scale_f, internal_scr_offset_f, v2),
-                                make_point(v2.tu, v2.tv),
-                                extend(get<rgb>(c2) * get<a>(c2), get<a>(c2))),
-                            triangle_vertex(
-                                d3dtl_to_point(internal_scr_res_scale_f, internal_scr_offset_f, v3),
-                                make_point(v3.tu, v3.tv),
-                                extend(get<rgb>(c3) * get<a>(c3), get<a>(c3))),
-                            current_material));
-                    } break;
-
-                    default:
-                        LOG_WARNING(
-                            "Unimplemented execute buffer opcode ", inst.bOpcode, " was ignored");
-                    }
+            write_capture([&](capture_writer &cw) {
+                cw.write_execute_game(
+                    vertex_span.as_const_bytes(), cmd_span, make_span(&vpd, 1).as_const_bytes());
+            });
 
-                    cmd_span = cmd_span.subspan(inst.bSize, span_to_end);
-                }
+            if(!rthread.is_threaded()) {
+                execute_game_commands(vertex_span, cmd_span);
+                cmdbuf->Unlock();
+                return;
             }
 
+            // Copy the buffer contents so JK can refill the execute buffer while the render
+            // thread translates this one
+            std::vector<D3DTLVERTEX> vertices(vertex_span.data(),
+                                              vertex_span.data() + vertex_span.size());
+            std::vector<char> commands(cmd_span.data(), cmd_span.data() + cmd_span.size());
+
             cmdbuf->Unlock();
+
+            rthread.post([this, vertices = std::move(vertices), commands = std::move(commands)] {
+                execute_game_commands(make_span(vertices), make_span(commands));
+            });
         }
 
-        void present_game() override
+        void render_game_frame(span<uint16_t const> hud_buffer)
         {
             end_frame();
-            update_hud_texture();
+            is_building_game_frame = true;
+            update_hud_texture(hud_buffer);
 
             ogs->tribuf.swap_next();
             auto *trimdl = ogs->tribuf.get_current();
 
+            auto sort_begin = std::chrono::steady_clock::now();
+
             world_batch.sort();
-            world_transparent_batch.sort();
+            if(the_config->transparency_mode == transparency_mode::weighted_blended) {
+                // Blending is order-independent. Group by material only.
+                world_transparent_batch.triangle_batch::sort();
+            }
+            else {
+                world_transparent_batch.sort();
+            }
+
             gun_batch.sort();
             gun_transparent_batch.sort();
 
+            current_frame_stats.sort_time = std::chrono::duration<double, std::micro>(
+                                                std::chrono::steady_clock::now() - sort_begin)
+                                                .count();
+            current_frame_stats.world_triangles = world_batch.size();
+            current_frame_stats.world_transparent_triangles = world_transparent_batch.size();
+            current_frame_stats.gun_triangles = gun_batch.size();
+            current_frame_stats.gun_transparent_triangles = gun_transparent_batch.size();
+            current_frame_stats.num_batch_expansions =
+                world_batch.take_num_expansions() + world_transparent_batch.take_num_expansions() +
+                gun_batch.take_num_expansions() + gun_transparent_batch.take_num_expansions();
+
             fill_buffer(world_batch, &trimdl->world_trimdl);
             fill_buffer(world_transparent_batch, &trimdl->world_transparent_trimdl);
             fill_buffer(gun_batch, &trimdl->gun_trimdl);
             fill_buffer(gun_transparent_batch, &trimdl->gun_transparent_trimdl);
 
-            bool posterize_lighting = the_config->enable_posterized_lighting;
-            draw_game_gbuffer_pass(trimdl, posterize_lighting);
-            draw_game_transparency_pass(trimdl, posterize_lighting);
+            opaque_pass_counters = draw_counters();
+            transparency_pass_counters = draw_counters();
+
+            float render_scale = dynamic_render_scale.has_value()
+                                     ? dynamic_render_scale->get_scale()
+                                     : get_fixed_render_scale();
+            ogs->set_scene_resolution(get_scaled_resolution(conf_scr_res, render_scale));
+
+            if(dynamic_render_scale.has_value()) {
+                ogs->scene_timer->begin();
+            }
+
+            draw_game_gbuffer_pass(trimdl);
+
+            begin_benchmark_pass(benchmark_pass::transparency);
+            {
+                gl::debug_group group("transparency");
+                gl::timer_profiler_scope scope(get_gpu_profiler(), "transparency");
+                draw_game_transparency_pass(trimdl);
+            }
+            end_benchmark_pass(benchmark_pass::transparency);
+
+            if(ogs->is_scene_scaled()) {
+                gl::debug_group group("upscale");
+                draw_game_upscale_pass();
+            }
+
+            if(dynamic_render_scale.has_value()) {
+                ogs->scene_timer->end();
+
+                auto scene_time = ogs->scene_timer->poll();
+                if(scene_time.has_value()) {
+                    dynamic_render_scale->add_frame_time(*scene_time);
+                }
+            }
+
+            if(benchmark.has_value()) {
+                if(is_background_throttled) {
+                    // Throttled frames skip passes and would skew the results. Start over.
+                    benchmark.emplace();
+                }
+                else {
+                    benchmark->end_frame();
+                    if(benchmark->is_finished()) {
+                        finish_quality_benchmark();
+                    }
+                }
+            }
+
+            // Each submitted triangle is rasterized at most once per pass
+            LOG_TRACE("Submitted ",
+                      world_batch.size() + world_transparent_batch.size() + gun_batch.size() +
+                          gun_transparent_batch.size(),
+                      " triangles. Opaque pass: ",
+                      opaque_pass_counters.num_triangles,
+                      " triangles in ",
+                      opaque_pass_counters.num_draw_calls,
+                      " draws. Transparency pass: ",
+                      transparency_pass_counters.num_triangles,
+                      " triangles in ",
+                      transparency_pass_counters.num_draw_calls,
+                      " draws.");
+
+            current_frame_stats.num_opaque_draw_calls = opaque_pass_counters.num_draw_calls;
+            current_frame_stats.num_opaque_triangles_drawn = opaque_pass_counters.num_triangles;
+            current_frame_stats.num_transparent_draw_calls =
+                transparency_pass_counters.num_draw_calls;
+            current_frame_stats.num_transparent_triangles_drawn =
+                transparency_pass_counters.num_triangles;
 
             draw_hud();
 
-            // Reset state:
-            is_gun = false;
-            is_transparent = false;
-            current_triangle_batch = &world_batch;
+            reset_game_frame_state();
+        }
+
+        void reset_game_frame_state()
+        {
+            translator.reset();
             current_material = material_instance_id(0U);
 
             world_batch.clear();
@@ -1330,6 +2291,88 @@ namespace jkgm {
             gun_transparent_batch.clear();
         }
 
+        void reset_hud_buffer()
+        {
+            for(auto &em : ddraw1_backbuffer_surface.buffer) {
+                em = ddraw1_backbuffer_surface.color_key;
+            }
+        }
+
+        bool is_window_hidden()
+        {
+            if(window_is_minimized || IsIconic(hWnd)) {
+                return true;
+            }
+
+            // The clip region is empty when other windows cover the whole client area. hDC is
+            // used for presentation on the render thread, so query a separate cache DC. DCX_CACHE
+            // is needed because GetDC returns the same DC for CS_OWNDC windows.
+            HDC query_dc = GetDCEx(hWnd, NULL, DCX_CACHE);
+            if(query_dc == NULL) {
+                return false;
+            }
+
+            RECT r;
+            bool rv = (GetClipBox(query_dc, &r) == NULLREGION);
+            ReleaseDC(hWnd, query_dc);
+            return rv;
+        }
+
+        // Paces the game while its window is in the background. Returns true when the frame
+        // should be discarded instead of drawn.
+        bool throttle_in_background()
+        {
+            if(!background_limiter.has_value()) {
+                return false;
+            }
+
+            bool is_hidden = is_window_hidden();
+            if(window_has_focus && !is_hidden) {
+                is_background_throttled = false;
+                return false;
+            }
+
+            background_limiter->wait();
+
+            if(is_hidden || the_config->background_mode == background_mode::pause) {
+                return true;
+            }
+
+            is_background_throttled = true;
+            return false;
+        }
+
+        void present_game() override
+        {
+            // JK loads all level textures before presenting the level's first frame
+            end_level_load();
+
+            capture_present_game();
+
+            if(throttle_in_background()) {
+                // Commands for this frame were already translated. Drop them.
+                rthread.post([this] { reset_game_frame_state(); });
+                reset_hud_buffer();
+                return;
+            }
+
+            if(!rthread.is_threaded()) {
+                render_game_frame(make_span(ddraw1_backbuffer_surface.buffer));
+                reset_hud_buffer();
+                return;
+            }
+
+            // JK draws the next frame's HUD into the backbuffer while this frame renders
+            std::vector<uint16_t> hud_buffer = ddraw1_backbuffer_surface.buffer;
+            reset_hud_buffer();
+
+            rthread.post_frame(
+                [this, hud_buffer = std::move(hud_buffer)] {
+                    render_game_frame(make_span(hud_buffer));
+                },
+                max_pending_render_frames);
+        }
+
         void depth_clear_game() override
         {
             // JK calls this once per frame, immediately after present.
@@ -1422,6 +2465,9 @@ namespace jkgm {
         IDirectDrawSurface *
             get_directdraw_vidmem_texture_surface(DDSURFACEDESC const &desc) override
         {
+            // Queued frames read material state from these surfaces
+            synchronize();
+
             auto get_matching_buffer = [&] {
                 for(auto &tex : vidmem_texture_surfaces) {
                     if(tex->refct <= 0) {
@@ -1470,6 +2516,8 @@ namespace jkgm {
 
         std::optional<material const *> get_replacement_material(md5 const &sig) override
         {
+            // Each lookup follows a texture hash
+            ++num_pending_texture_hashes;
             return materials.get_material(sig);
         }
 
@@ -1492,9 +2540,27 @@ namespace jkgm {
             return std::nullopt;
         }
 
-        srgb_texture_id create_srgb_texture_from_buffer(size<2, int> const &dims,
-                                                        span<char const> data) override
+        srgb_texture_id create_srgb_texture_from_buffer_body(size<2, int> const &dims,
+                                                             span<char const> data)
         {
+            ++current_frame_stats.num_texture_uploads;
+            current_frame_stats.texture_upload_bytes += data.size();
+
+            auto *load_profiler = get_level_load_profiler();
+            level_load_phase_scope upload_phase(load_profiler, level_load_phase::texture_upload);
+            if(load_profiler) {
+                load_profiler->add_upload_bytes(data.size());
+            }
+
+            // Materials with partially transparent albedo maps need alpha testing when opaque
+            bool has_alpha = false;
+            for(size_t i = 3U; i < data.size(); i += 4U) {
+                if(static_cast<uint8_t>(data.data()[i]) != 0xFFU) {
+                    has_alpha = true;
+                    break;
+                }
+            }
+
             auto existing_buf = get_existing_free_srgb_texture(dims);
             if(existing_buf.has_value()) {
                 // Matching texture already exists. Refill it.
@@ -1507,8 +2573,10 @@ namespace jkgm {
                                      gl::texture_pixel_type::uint8,
                                      data);
                 gl::generate_mipmap(gl::texture_bind_target::texture_2d);
+                gl::set_object_label(em.handle, "game_texture");
 
                 ++em.refct;
+                em.has_alpha = has_alpha;
                 return *existing_buf;
             }
 
@@ -1518,6 +2586,7 @@ namespace jkgm {
 
             auto &em = ogs->srgb_textures.back();
             em.refct = 1;
+            em.has_alpha = has_alpha;
 
             gl::bind_texture(gl::texture_bind_target::texture_2d, em.handle);
             gl::tex_image_2d(gl::texture_bind_target::texture_2d,
@@ -1528,8 +2597,9 @@ namespace jkgm {
                              gl::texture_pixel_type::uint8,
                              data);
             gl::generate_mipmap(gl::texture_bind_target::texture_2d);
+            gl::set_object_label(em.handle, "game_texture");
             gl::set_texture_max_anisotropy(gl::texture_bind_target::texture_2d,
-                                           std::max(1.0f, the_config->max_anisotropy));
+                                           std::max(1.0f, quality.max_anisotropy));
             if(the_config->enable_texture_filtering) {
                 gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d,
                                            gl::mag_filter::linear);
@@ -1546,7 +2616,34 @@ namespace jkgm {
             return rv;
         }
 
-        srgb_texture_id get_srgb_texture_from_filename(fs::path const &file) override
+        // Reads and decodes separately, so that level load reports can tell them apart
+        std::unique_ptr<image> load_image_file(fs::path const &file)
+        {
+            auto *load_profiler = get_level_load_profiler();
+            memory_block encoded;
+
+            {
+                level_load_phase_scope phase(load_profiler, level_load_phase::file_read);
+                auto fs = make_file_input_block(file);
+                memory_output_block mob(&encoded);
+                fs->copy_to(&mob);
+            }
+
+            level_load_phase_scope phase(load_profiler, level_load_phase::image_decode);
+            return load_image(make_span(encoded));
+        }
+
+        // Replacement textures are named after their material directory and file. Textures
+        // filled from game data are relabeled when their storage is reused.
+        void label_replacement_texture(gl::texture_view tex, fs::path const &file)
+        {
+            if(gl::has_debug_annotation_support()) {
+                gl::set_object_label(
+                    tex, (file.parent_path().filename() / file.filename()).generic_string());
+            }
+        }
+
+        srgb_texture_id get_srgb_texture_from_filename_body(fs::path const &file)
         {
             auto it = ogs->file_to_srgb_texture_map.find(file);
             if(it != ogs->file_to_srgb_texture_map.end()) {
@@ -1556,22 +2653,38 @@ namespace jkgm {
                 return rv;
             }
 
-            auto fs = make_file_input_block(file);
-            auto img = load_image(fs.get());
+            TRACE_SCOPE("texture file load");
+            auto img = load_image_file(file);
 
-            auto rv = create_srgb_texture_from_buffer(img->dimensions,
-                                                      make_span(img->data).as_const_bytes());
+            auto rv = create_srgb_texture_from_buffer_body(img->dimensions,
+                                                           make_span(img->data).as_const_bytes());
 
             auto &em = at(ogs->srgb_textures, rv);
             em.origin_filename = file;
+            label_replacement_texture(em.handle, file);
             ogs->file_to_srgb_texture_map.emplace(file, rv.get());
 
             return rv;
         }
 
+        srgb_texture_id create_srgb_texture_from_buffer(size<2, int> const &dims,
+                                                        span<char const> data) override
+        {
+            srgb_texture_id rv(0U);
+            rthread.call([&] { rv = create_srgb_texture_from_buffer_body(dims, data); });
+            return rv;
+        }
+
+        srgb_texture_id get_srgb_texture_from_filename(fs::path const &file) override
+        {
+            srgb_texture_id rv(0U);
+            rthread.call([&] { rv = get_srgb_texture_from_filename_body(file); });
+            return rv;
+        }
+
         void release_srgb_texture(srgb_texture_id id) override
         {
-            --at(ogs->srgb_textures, id).refct;
+            rthread.post([this, id] { --at(ogs->srgb_textures, id).refct; });
         }
 
         std::optional<linear_texture_id> get_existing_free_linear_texture(size<2, int> const &dims)
@@ -1596,6 +2709,15 @@ namespace jkgm {
         linear_texture_id create_linear_texture_from_buffer(size<2, int> const &dims,
                                                             span<char const> data)
         {
+            ++current_frame_stats.num_texture_uploads;
+            current_frame_stats.texture_upload_bytes += data.size();
+
+            auto *load_profiler = get_level_load_profiler();
+            level_load_phase_scope upload_phase(load_profiler, level_load_phase::texture_upload);
+            if(load_profiler) {
+                load_profiler->add_upload_bytes(data.size());
+            }
+
             auto existing_buf = get_existing_free_linear_texture(dims);
             if(existing_buf.has_value()) {
                 // Matching texture already exists. Refill it.
@@ -1630,7 +2752,7 @@ namespace jkgm {
                              data);
             gl::generate_mipmap(gl::texture_bind_target::texture_2d);
             gl::set_texture_max_anisotropy(gl::texture_bind_target::texture_2d,
-                                           std::max(1.0f, the_config->max_anisotropy));
+                                           std::max(1.0f, quality.max_anisotropy));
             if(the_config->enable_texture_filtering) {
                 gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d,
                                            gl::mag_filter::linear);
@@ -1647,7 +2769,7 @@ namespace jkgm {
             return rv;
         }
 
-        linear_texture_id get_linear_texture_from_filename(fs::path const &file) override
+        linear_texture_id get_linear_texture_from_filename_body(fs::path const &file)
         {
             auto it = ogs->file_to_linear_texture_map.find(file);
             if(it != ogs->file_to_linear_texture_map.end()) {
@@ -1657,22 +2779,35 @@ namespace jkgm {
                 return rv;
             }
 
-            auto fs = make_file_input_block(file);
-            auto img = load_image(fs.get());
+            TRACE_SCOPE("texture file load");
+            auto img = load_image_file(file);
 
             auto rv = create_linear_texture_from_buffer(img->dimensions,
                                                         make_span(img->data).as_const_bytes());
 
             auto &em = at(ogs->linear_textures, rv);
             em.origin_filename = file;
+            label_replacement_texture(em.handle, file);
             ogs->file_to_linear_texture_map.emplace(file, rv.get());
 
             return rv;
         }
 
+        linear_texture_id get_linear_texture_from_filename(fs::path const &file) override
+        {
+            linear_texture_id rv(0U);
+            rthread.call([&] { rv = get_linear_texture_from_filename_body(file); });
+            return rv;
+        }
+
         void release_linear_texture(linear_texture_id id) override
         {
-            --at(ogs->linear_textures, id).refct;
+            rthread.post([this, id] { --at(ogs->linear_textures, id).refct; });
+        }
+
+        void synchronize() override
+        {
+            rthread.wait_idle();
         }
     };
 }
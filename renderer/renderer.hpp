@@ -4,8 +4,11 @@
 #include "base/id.hpp"
 #include "base/md5.hpp"
 #include "base/span.hpp"
+#include "common/capture_file.hpp"
 #include "common/config.hpp"
 #include "common/material.hpp"
+#include "core/frame_statistics.hpp"
+#include "level_load_profiler.hpp"
 #include "math/point.hpp"
 #include "math/size.hpp"
 #include "renderer_fwd.hpp"
@@ -72,6 +75,22 @@ namespace jkgm {
         virtual linear_texture_id get_linear_texture_from_filename(fs::path const &file) = 0;
         virtual void release_srgb_texture(srgb_texture_id id) = 0;
         virtual void release_linear_texture(linear_texture_id id) = 0;
+
+        // Blocks until all previously submitted rendering work has finished
+        virtual void synchronize() = 0;
+
+        // Returns the work done by the most recently presented frame
+        virtual frame_statistics get_frame_statistics() = 0;
+
+        // Returns null unless level load reports are enabled
+        virtual level_load_profiler *get_level_load_profiler() = 0;
+
+        // Records a texture load, when renderer inputs are being captured
+        virtual void capture_texture_load(capture_texture_info const &info,
+                                          span<char const> pixels) = 0;
+
+        // Called when the game exits through ExitProcess, before DLL detach
+        virtual void on_process_exit() = 0;
     };
 
     std::unique_ptr<renderer> create_renderer(HINSTANCE dll_instance, config const *the_config);
@@ -1,12 +1,12 @@
 #pragma once
 
 #include "base/id.hpp"
+#include "core/core_fwd.hpp"
 #include <cstddef>
 
 namespace jkgm {
     MAKE_ID_TYPE(srgb_texture, size_t);
     MAKE_ID_TYPE(linear_texture, size_t);
-    MAKE_ID_TYPE(material_instance, size_t);
 
     class renderer;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "base/file_block.hpp"
 #include "base/log.hpp"
 #include "base/md5.hpp"
+#include "base/trace.hpp"
 #include "common/error_reporter.hpp"
 #include "common/image.hpp"
 #include "dxguids.hpp"
@@ -32,32 +33,67 @@ HRESULT WINAPI jkgm::vidmem_texture::GetHandle(LPDIRECT3DDEVICE a, LPD3DTEXTUREH
 
 HRESULT WINAPI jkgm::vidmem_texture::Load(LPDIRECT3DTEXTURE a)
 {
+    TRACE_SCOPE("vidmem_texture::Load");
+
     // Copy the input texture to the OpenGL surface
     auto *cast_tex = dynamic_cast<sysmem_texture *>(a);
     if(!cast_tex) {
         report_unimplemented_function("Direct3DTexture(vidmem)::Load with a non-sysmem texture");
     }
 
+    // Queued frames may still read this material. Wait for them before changing it.
+    surf->r->synchronize();
+
     // Reset material to default state
     surf->clear();
 
     auto *src = cast_tex->surf;
 
+    auto *load_profiler = surf->r->get_level_load_profiler();
+    if(load_profiler) {
+        load_profiler->begin_texture();
+    }
+
+    // Captures hold the texture JK loaded. Replays do not have material packs.
+    surf->r->capture_texture_load(
+        capture_texture_info{static_cast<uint32_t>(surf->material_id.get()),
+                             static_cast<uint32_t>(src->desc.dwWidth),
+                             static_cast<uint32_t>(src->desc.dwHeight),
+                             (src->desc.ddpfPixelFormat.dwRGBAlphaBitMask != 0U) ? 1U : 0U},
+        make_span(src->buffer).as_const_bytes());
+
     // Compute and report texture signature
     uint32_t bound_width = src->desc.dwWidth;
     uint32_t bound_height = src->desc.dwHeight;
 
     md5_hasher mh;
-    mh.add(make_span(&bound_width, 1).as_const_bytes());
-    mh.add(make_span(&bound_height, 1).as_const_bytes());
-    mh.add(make_span(src->buffer).as_const_bytes());
+
+    {
+        TRACE_SCOPE("texture hash");
+        level_load_phase_scope phase(load_profiler, level_load_phase::md5);
+        mh.add(make_span(&bound_width, 1).as_const_bytes());
+        mh.add(make_span(&bound_height, 1).as_const_bytes());
+        mh.add(make_span(src->buffer).as_const_bytes());
+    }
 
     auto sig = mh.finish();
     LOG_DEBUG("Loaded texture with signature ", static_cast<std::string>(sig));
 
-    auto repl_map = surf->r->get_replacement_material(sig);
+    std::optional<material const *> repl_map;
+
+    {
+        TRACE_SCOPE("texture lookup");
+        level_load_phase_scope phase(load_profiler, level_load_phase::material_lookup);
+        repl_map = surf->r->get_replacement_material(sig);
+    }
+
+    if(load_profiler) {
+        load_profiler->add_replacement_lookup(repl_map.has_value());
+    }
 
     if(repl_map.has_value()) {
+        TRACE_SCOPE("texture upload");
+
         LOG_DEBUG("Found replacement");
         if((*repl_map)->albedo_map.has_value()) {
             surf->albedo_map = surf->r->get_srgb_texture_from_filename(*(*repl_map)->albedo_map);
@@ -91,21 +127,26 @@ HRESULT WINAPI jkgm::vidmem_texture::Load(LPDIRECT3DTEXTURE a)
     // No replacements found. Create standard material.
     uint16_t const *in_em = (uint16_t const *)src->buffer.data();
 
-    for(auto &out_em : src->conv_buffer) {
-        // Convert from indexed to RGB888
-        if(src->desc.ddpfPixelFormat.dwRGBAlphaBitMask) {
-            // Convert from RGBA5551 to RGBA8888
-            out_em = rgba5551_to_srgb_a8(*in_em);
-            surf->alpha_mode = material_alpha_mode::blend;
+    {
+        TRACE_SCOPE("texture decode");
+        level_load_phase_scope phase(load_profiler, level_load_phase::srgb_conversion);
+        for(auto &out_em : src->conv_buffer) {
+            // Convert from indexed to RGB888
+            if(src->desc.ddpfPixelFormat.dwRGBAlphaBitMask) {
+                // Convert from RGBA5551 to RGBA8888
+                out_em = rgba5551_to_srgb_a8(*in_em);
+                surf->alpha_mode = material_alpha_mode::blend;
+            }
+            else {
+                // Convert from RGB565 to RGBA8888
+                out_em = rgb565_to_srgb_a8(*in_em);
+            }
+
+            ++in_em;
         }
-        else {
-            // Convert from RGB565 to RGBA8888
-            out_em = rgb565_to_srgb_a8(*in_em);
-        }
-
-        ++in_em;
     }
 
+    TRACE_SCOPE("texture upload");
     surf->albedo_map = surf->r->create_srgb_texture_from_buffer(
         make_size((int)src->desc.dwWidth, (int)src->desc.dwHeight),
         make_span(src->conv_buffer).as_const_bytes());
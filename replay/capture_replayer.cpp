@@ -0,0 +1,457 @@
+#include "capture_replayer.hpp"
+#include "base/log.hpp"
+#include "glutil/debug.hpp"
+#include "glutil/framebuffer.hpp"
+#include "glutil/gl.hpp"
+#include "glutil/vertex_array.hpp"
+#include "math/color_conv.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace jkgm {
+    namespace {
+        // These match the renderer
+        constexpr uint16_t hud_color_key = 0xF81FU;
+        constexpr float weapon_depth_range = 0.01f;
+        constexpr size_t menu_num_pixels = 640U * 480U;
+        constexpr size_t menu_palette_size = 256U;
+
+        [[noreturn]] void throw_corrupt_record(capture_record const &rec)
+        {
+            throw std::runtime_error(str(format(
+                "Renderer capture record of type ", static_cast<int>(rec.type), " is corrupt")));
+        }
+
+        double to_microseconds(std::chrono::steady_clock::duration d)
+        {
+            return std::chrono::duration<double, std::micro>(d).count();
+        }
+    }
+}
+
+jkgm::capture_replayer::capture_replayer(config const *the_config, capture_header const &header)
+    : the_config(the_config)
+    , header(header)
+    , world_transparent_batch(&jobs,
+                              the_config->transparency_sort,
+                              the_config->enable_temporal_transparency_sort)
+    , gun_transparent_batch(&jobs,
+                            the_config->transparency_sort,
+                            the_config->enable_temporal_transparency_sort)
+    , translator(this,
+                 game_triangle_batches{
+                     &world_batch, &world_transparent_batch, &gun_batch, &gun_transparent_batch})
+    , hud_buffer(static_cast<size_t>(volume(header.internal_screen_res)), hud_color_key)
+    , menu_palette(menu_palette_size, color_rgba8::zero())
+{
+    ogs = std::make_unique<opengl_state>(
+        header.screen_res, header.internal_screen_res, header.display_area, the_config);
+}
+
+std::optional<jkgm::replay_frame_timing>
+    jkgm::capture_replayer::replay_record(capture_record const &rec)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    switch(rec.type) {
+    case capture_record_type::execute_game:
+        execute_game(rec);
+        break;
+
+    case capture_record_type::texture_load:
+        load_texture(rec);
+        break;
+
+    case capture_record_type::hud:
+        if(rec.chunks.size() != 1U ||
+           rec.chunks[0].size() != hud_buffer.size() * sizeof(uint16_t)) {
+            throw_corrupt_record(rec);
+        }
+
+        std::memcpy(hud_buffer.data(), rec.chunks[0].data(), rec.chunks[0].size());
+        break;
+
+    case capture_record_type::menu_palette:
+        if(rec.chunks.size() != 1U ||
+           rec.chunks[0].size() != menu_palette.size() * sizeof(color_rgba8)) {
+            throw_corrupt_record(rec);
+        }
+
+        std::memcpy(menu_palette.data(), rec.chunks[0].data(), rec.chunks[0].size());
+        break;
+
+    case capture_record_type::menu_source:
+        if(rec.chunks.size() != 1U ||
+           (!rec.chunks[0].empty() && rec.chunks[0].size() != menu_num_pixels)) {
+            throw_corrupt_record(rec);
+        }
+
+        menu_source.assign(rec.chunks[0].begin(), rec.chunks[0].end());
+        break;
+
+    case capture_record_type::present_game:
+    case capture_record_type::present_menu: {
+        bool is_game = (rec.type == capture_record_type::present_game);
+
+        // Timestamp pairs, as in the GPU profiler. Some drivers report a bogus first elapsed time.
+        gl::query_timestamp(frame_begin_query);
+        if(is_game) {
+            present_game();
+        }
+        else {
+            present_menu();
+        }
+        gl::query_timestamp(frame_end_query);
+
+        // The query result waits for the GPU. Stop the CPU clock first.
+        pending_cpu_time += std::chrono::steady_clock::now() - begin;
+
+        replay_frame_timing rv = current_frame;
+        rv.frame_index = num_frames++;
+        rv.kind = is_game ? replay_frame_kind::game : replay_frame_kind::menu;
+        rv.cpu_time = to_microseconds(pending_cpu_time);
+
+        auto begin_time = gl::get_query_result(frame_begin_query);
+        auto end_time = gl::get_query_result(frame_end_query);
+        if(end_time > begin_time) {
+            rv.gpu_time = static_cast<double>(end_time - begin_time) / 1000.0;
+        }
+
+        current_frame = replay_frame_timing();
+        pending_cpu_time = std::chrono::steady_clock::duration::zero();
+        return rv;
+    }
+
+    default:
+        LOG_WARNING("Ignored unknown capture record type ", static_cast<int>(rec.type));
+        break;
+    }
+
+    pending_cpu_time += std::chrono::steady_clock::now() - begin;
+    return std::nullopt;
+}
+
+void jkgm::capture_replayer::load_texture(capture_record const &rec)
+{
+    auto info = get_capture_texture_info(rec);
+    auto dims = make_size(static_cast<int>(info.width), static_cast<int>(info.height));
+
+    size_t num_pixels = static_cast<size_t>(info.width) * static_cast<size_t>(info.height);
+    auto const &pixels = rec.chunks[1];
+    if(pixels.size() < num_pixels * sizeof(uint16_t)) {
+        throw_corrupt_record(rec);
+    }
+
+    std::vector<color_rgba8> conv_buffer(num_pixels, color_rgba8::zero());
+    bool has_alpha = false;
+    for(size_t i = 0; i < num_pixels; ++i) {
+        uint16_t in_em;
+        std::memcpy(&in_em, pixels.data() + (i * sizeof(uint16_t)), sizeof(uint16_t));
+
+        auto &out_em = conv_buffer[i];
+        out_em = info.has_alpha ? rgba5551_to_srgb_a8(in_em) : rgb565_to_srgb_a8(in_em);
+        has_alpha = has_alpha || (get<a>(out_em) != 0xFFU);
+    }
+
+    // JK reuses material ids when it loads a new level
+    auto &mat = materials[info.material_id];
+    mat.albedo_map = gl::texture();
+    mat.has_alpha = has_alpha;
+
+    gl::bind_texture(gl::texture_bind_target::texture_2d, mat.albedo_map);
+    gl::tex_image_2d(gl::texture_bind_target::texture_2d,
+                     /*level*/ 0,
+                     gl::texture_internal_format::srgb_a8,
+                     dims,
+                     gl::texture_pixel_format::rgba,
+                     gl::texture_pixel_type::uint8,
+                     make_span(conv_buffer).as_const_bytes());
+    gl::generate_mipmap(gl::texture_bind_target::texture_2d);
+    gl::set_texture_max_anisotropy(gl::texture_bind_target::texture_2d,
+                                   std::max(1.0f, the_config->max_anisotropy));
+    if(the_config->enable_texture_filtering) {
+        gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::linear);
+        gl::set_texture_min_filter(gl::texture_bind_target::texture_2d,
+                                   gl::min_filter::linear_mipmap_linear);
+    }
+    else {
+        gl::set_texture_mag_filter(gl::texture_bind_target::texture_2d, gl::mag_filter::nearest);
+        gl::set_texture_min_filter(gl::texture_bind_target::texture_2d,
+                                   gl::min_filter::nearest_mipmap_linear);
+    }
+
+    ++current_frame.num_texture_uploads;
+}
+
+void jkgm::capture_replayer::execute_game(capture_record const &rec)
+{
+    // The renderer does not use the viewport, so neither does the replay
+    if(rec.chunks.size() != 3U) {
+        throw_corrupt_record(rec);
+    }
+
+    auto const &vertices = rec.chunks[0];
+    translator.translate(make_span(reinterpret_cast<d3d::tl_vertex const *>(vertices.data()),
+                                   vertices.size() / sizeof(d3d::tl_vertex)),
+                         make_span(rec.chunks[1]),
+                         header.internal_screen_scale,
+                         header.internal_screen_offset);
+}
+
+size_t jkgm::capture_replayer::get_material_shader_variant(material_instance_id /*id*/)
+{
+    // Replays only draw the textures JK loaded
+    return 0U;
+}
+
+bool jkgm::capture_replayer::get_material_has_alpha(material_instance_id id)
+{
+    auto it = materials.find(id.get());
+    return (it != materials.end()) && it->second.has_alpha;
+}
+
+void jkgm::capture_replayer::fill_buffer(triangle_batch const &tb, triangle_buffer_model *mdl)
+{
+    mdl->maybe_grow_buffers(tb.capacity() * 3, /*unsynchronized*/ false);
+
+    mdl->num_vertices = static_cast<int>(pack_triangle_buffer(tb, mdl->mmio));
+    mdl->update_buffers();
+}
+
+void jkgm::capture_replayer::bind_material(game_program_set const &progs,
+                                           material_instance_id id)
+{
+    auto const *prog = &progs.at(0U);
+    if(prog != current_program) {
+        gl::use_program(*prog);
+        current_program = prog;
+    }
+
+    gl::texture_view albedo_map = gl::default_texture;
+    auto it = materials.find(id.get());
+    if(it != materials.end()) {
+        albedo_map = it->second.albedo_map;
+    }
+
+    gl::set_active_texture_unit(1);
+    gl::bind_texture(gl::texture_bind_target::texture_2d, gl::default_texture);
+    gl::set_active_texture_unit(0);
+    gl::bind_texture(gl::texture_bind_target::texture_2d, albedo_map);
+
+    // Enable features
+    gl::set_uniform_vector(gl::uniform_location_id(1),
+                           make_point((it != materials.end()) ? 1.0f : 0.0f,
+                                      /*has emissive map*/ 0.0f));
+
+    // Albedo factor
+    gl::set_uniform_vector(gl::uniform_location_id(3), color::fill(1.0f));
+
+    // Emissive factor
+    gl::set_uniform_vector(gl::uniform_location_id(5), color_rgb::zero());
+}
+
+void jkgm::capture_replayer::draw_batch(game_program_set const &progs,
+                                        triangle_batch const &tb,
+                                        triangle_buffer_model *trimdl,
+                                        game_program_set const *alpha_test_progs)
+{
+    gl::bind_vertex_array(trimdl->vao);
+
+    size_t curr_offset = 0U;
+    size_t num_verts = 0U;
+
+    material_instance_id bound_material(0U);
+    bind_material(progs, bound_material);
+    bool current_alpha_test = false;
+
+    for(auto const &tri : tb) {
+        bool alpha_test = tri.alpha_test && (alpha_test_progs != nullptr);
+        if(bound_material != tri.material || current_alpha_test != alpha_test) {
+            // Draw pending elements from previous material
+            if(num_verts > 0) {
+                gl::draw_arrays(gl::element_type::triangles, curr_offset, num_verts);
+                ++current_frame.num_draw_calls;
+
+                curr_offset += num_verts;
+                num_verts = 0U;
+            }
+
+            bind_material(alpha_test ? *alpha_test_progs : progs, tri.material);
+            bound_material = tri.material;
+            current_alpha_test = alpha_test;
+        }
+
+        num_verts += 3;
+    }
+
+    if(num_verts > 0) {
+        gl::draw_arrays(gl::element_type::triangles, curr_offset, num_verts);
+        ++current_frame.num_draw_calls;
+    }
+}
+
+void jkgm::capture_replayer::draw_overlay(std::string_view name,
+                                          gl::texture_view tex,
+                                          gl::vertex_array_view vao,
+                                          unsigned int num_indices)
+{
+    gl::debug_group group(name);
+
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->screen_renderbuffer.fbo);
+    gl::set_viewport(ogs->screen_renderbuffer.viewport);
+
+    gl::enable(gl::capability::blend);
+    gl::disable(gl::capability::depth_test);
+
+    gl::set_active_texture_unit(0);
+    gl::bind_texture(gl::texture_bind_target::texture_2d, tex);
+
+    gl::use_program(ogs->menu_program);
+    gl::set_uniform_integer(gl::uniform_location_id(0), 0);
+    current_program = nullptr;
+
+    gl::bind_vertex_array(vao);
+    gl::draw_elements(gl::element_type::triangles, num_indices, gl::index_type::uint32);
+    ++current_frame.num_draw_calls;
+}
+
+void jkgm::capture_replayer::present_game()
+{
+    // HUD
+    for(size_t i = 0; i < hud_buffer.size(); ++i) {
+        auto in_em = hud_buffer[i];
+        ogs->hud_texture_data[i] = rgb565_key_to_srgb_a8(in_em, in_em == hud_color_key);
+    }
+
+    gl::set_active_texture_unit(0);
+    gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->hud_texture);
+    gl::tex_image_2d(gl::texture_bind_target::texture_2d,
+                     /*level*/ 0,
+                     gl::texture_internal_format::srgb_a8,
+                     header.internal_screen_res,
+                     gl::texture_pixel_format::rgba,
+                     gl::texture_pixel_type::uint8,
+                     make_span(ogs->hud_texture_data).as_const_bytes());
+
+    // Sort and stream geometry
+    world_batch.sort();
+    if(the_config->transparency_mode == transparency_mode::weighted_blended) {
+        world_transparent_batch.triangle_batch::sort();
+    }
+    else {
+        world_transparent_batch.sort();
+    }
+
+    gun_batch.sort();
+    gun_transparent_batch.sort();
+
+    current_frame.num_triangles = world_batch.size() + world_transparent_batch.size() +
+                                  gun_batch.size() + gun_transparent_batch.size();
+
+    ogs->tribuf.swap_next();
+    auto *trimdl = ogs->tribuf.get_current();
+
+    fill_buffer(world_batch, &trimdl->world_trimdl);
+    fill_buffer(world_transparent_batch, &trimdl->world_transparent_trimdl);
+    fill_buffer(gun_batch, &trimdl->gun_trimdl);
+    fill_buffer(gun_transparent_batch, &trimdl->gun_transparent_trimdl);
+
+    auto screen_res = static_cast<size<2, float>>(header.screen_res);
+    auto begin_game_programs = [&](game_program_set const &progs) {
+        for(auto const &prog : progs) {
+            gl::use_program(prog);
+            gl::set_uniform_vector(gl::uniform_location_id(0), screen_res);
+        }
+
+        current_program = nullptr;
+    };
+
+    // G-buffer pass
+    gl::push_debug_group("gbuffer");
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, ogs->gbuffer->fbo);
+    gl::set_viewport(ogs->gbuffer->viewport);
+    gl::clear_buffer_depth(1.0f);
+    gl::clear_buffer_color(0, color::zero());
+    gl::clear_buffer_color(1, color::zero());
+    gl::clear_buffer_color(2, color::zero());
+
+    gl::disable(gl::capability::blend);
+    gl::enable(gl::capability::depth_test);
+    gl::set_depth_mask(true);
+    gl::disable(gl::capability::cull_face);
+    gl::set_depth_function(gl::comparison_function::less);
+
+    auto const &opaque_progs = ogs->game_opaque_pass_programs;
+    auto const &at_progs = ogs->game_alpha_test_pass_programs;
+    begin_game_programs(opaque_progs);
+    begin_game_programs(at_progs);
+
+    gl::set_depth_range(weapon_depth_range, 1.0f);
+    draw_batch(opaque_progs, world_batch, &trimdl->world_trimdl, &at_progs);
+    draw_batch(at_progs, world_transparent_batch, &trimdl->world_transparent_trimdl);
+
+    gl::set_depth_range(0.0f, weapon_depth_range);
+    draw_batch(opaque_progs, gun_batch, &trimdl->gun_trimdl, &at_progs);
+    draw_batch(at_progs, gun_transparent_batch, &trimdl->gun_transparent_trimdl);
+    gl::pop_debug_group();
+
+    // Transparency pass. Weighted blended transparency is drawn as sorted.
+    gl::push_debug_group("transparency");
+    auto const &scene_renderbuffer = ogs->get_scene_renderbuffer();
+    gl::bind_framebuffer(gl::framebuffer_bind_target::any, scene_renderbuffer.fbo);
+    gl::set_viewport(scene_renderbuffer.viewport);
+
+    gl::enable(gl::capability::blend);
+    gl::set_blend_function(gl::blend_function::one, gl::blend_function::one_minus_source_alpha);
+    gl::set_depth_mask(false);
+
+    auto const &trns_progs = ogs->game_transparency_pass_programs;
+    begin_game_programs(trns_progs);
+
+    gl::set_depth_range(weapon_depth_range, 1.0f);
+    draw_batch(trns_progs, world_transparent_batch, &trimdl->world_transparent_trimdl);
+
+    gl::set_depth_range(0.0f, weapon_depth_range);
+    draw_batch(trns_progs, gun_transparent_batch, &trimdl->gun_transparent_trimdl);
+
+    gl::set_depth_range(0.0f, 1.0f);
+    gl::set_depth_mask(true);
+    gl::pop_debug_group();
+
+    draw_overlay("hud", ogs->hud_texture, ogs->hudmdl.vao, ogs->hudmdl.num_indices);
+
+    reset_game_frame_state();
+}
+
+void jkgm::capture_replayer::present_menu()
+{
+    if(menu_source.empty()) {
+        return;
+    }
+
+    for(size_t idx = 0U; idx < ogs->menu_texture_data.size(); ++idx) {
+        ogs->menu_texture_data[idx] = menu_palette[menu_source[idx]];
+    }
+
+    gl::set_active_texture_unit(0);
+    gl::bind_texture(gl::texture_bind_target::texture_2d, ogs->menu_texture);
+    gl::tex_sub_image_2d(gl::texture_bind_target::texture_2d,
+                         0,
+                         make_box(make_point(0, 0), make_point(640, 480)),
+                         gl::texture_pixel_format::rgba,
+                         gl::texture_pixel_type::uint8,
+                         make_span(ogs->menu_texture_data).as_const_bytes());
+
+    draw_overlay("menu", ogs->menu_texture, ogs->menumdl.vao, ogs->menumdl.num_indices);
+}
+
+void jkgm::capture_replayer::reset_game_frame_state()
+{
+    translator.reset();
+
+    world_batch.clear();
+    world_transparent_batch.clear();
+    gun_batch.clear();
+    gun_transparent_batch.clear();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "base/job_system.hpp"
+#include "base/span.hpp"
+#include "common/capture_file.hpp"
+#include "common/config.hpp"
+#include "core/execute_buffer_translator.hpp"
+#include "core/triangle_batch.hpp"
+#include "glutil/program.hpp"
+#include "glutil/query.hpp"
+#include "glutil/texture.hpp"
+#include "renderer/opengl_state.hpp"
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jkgm {
+    enum class replay_frame_kind { game, menu };
+
+    // Cost of one replayed frame. Times are in microseconds.
+    class replay_frame_timing {
+    public:
+        size_t frame_index = 0U;
+        replay_frame_kind kind = replay_frame_kind::game;
+
+        // Translation, sorting, buffer filling and GL submission, including the texture loads
+        // and execute buffers received since the previous frame
+        double cpu_time = 0.0;
+        double gpu_time = 0.0;
+
+        size_t num_triangles = 0U;
+        size_t num_draw_calls = 0U;
+        size_t num_texture_uploads = 0U;
+    };
+
+    // Feeds captured renderer inputs through the renderer's translation, sorting and geometry
+    // passes. Requires a current OpenGL context.
+    //
+    // Only the passes that consume captured geometry are replayed: the G-buffer pass, the
+    // transparency pass, the HUD and menus. Replacement materials are not available, so every
+    // texture is drawn as JK loaded it.
+    class capture_replayer : public execute_buffer_materials {
+    private:
+        struct replay_material {
+            gl::texture albedo_map;
+            bool has_alpha = false;
+        };
+
+        config const *the_config;
+        capture_header header;
+        std::unique_ptr<opengl_state> ogs;
+
+        job_system jobs;
+
+        triangle_batch world_batch;
+        sorted_triangle_batch world_transparent_batch;
+        triangle_batch gun_batch;
+        sorted_triangle_batch gun_transparent_batch;
+        execute_buffer_translator translator;
+
+        gl::program const *current_program = nullptr;
+
+        std::unordered_map<size_t, replay_material> materials;
+
+        std::vector<uint16_t> hud_buffer;
+        std::vector<color_rgba8> menu_palette;
+        std::vector<uint8_t> menu_source;
+
+        gl::query frame_begin_query;
+        gl::query frame_end_query;
+        size_t num_frames = 0U;
+        std::chrono::steady_clock::duration pending_cpu_time =
+            std::chrono::steady_clock::duration::zero();
+        replay_frame_timing current_frame;
+
+        void load_texture(capture_record const &rec);
+        void execute_game(capture_record const &rec);
+
+        size_t get_material_shader_variant(material_instance_id id) override;
+        bool get_material_has_alpha(material_instance_id id) override;
+
+        void fill_buffer(triangle_batch const &tb, triangle_buffer_model *mdl);
+        void bind_material(game_program_set const &progs, material_instance_id id);
+        void draw_batch(game_program_set const &progs,
+                        triangle_batch const &tb,
+                        triangle_buffer_model *trimdl,
+                        game_program_set const *alpha_test_progs = nullptr);
+        void draw_overlay(std::string_view name,
+                          gl::texture_view tex,
+                          gl::vertex_array_view vao,
+                          unsigned int num_indices);
+
+        void present_game();
+        void present_menu();
+        void reset_game_frame_state();
+
+    public:
+        capture_replayer(config const *the_config, capture_header const &header);
+
+        // Returns the timing of the frame the record presents, if it presents one
+        std::optional<replay_frame_timing> replay_record(capture_record const &rec);
+    };
+}
@@ -0,0 +1,70 @@
+#include "headless_context.hpp"
+#include "base/log.hpp"
+#include "glad/gl.h"
+#include "glutil/gl.hpp"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdexcept>
+#include <string>
+
+jkgm::headless_context::headless_context()
+{
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(!get_platform_display) {
+        throw std::runtime_error("EGL does not support platform displays");
+    }
+
+    EGLDisplay dpy =
+        get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if(dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) {
+        throw std::runtime_error("Failed to initialize surfaceless EGL display");
+    }
+
+    display = dpy;
+
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(dpy);
+        throw std::runtime_error("EGL does not support desktop OpenGL");
+    }
+
+    EGLint const context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                      3,
+                                      EGL_CONTEXT_MINOR_VERSION,
+                                      3,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                      EGL_NONE};
+
+    // Surfaceless contexts do not need a config
+    EGLContext ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+    if(ctx == EGL_NO_CONTEXT) {
+        eglTerminate(dpy);
+        throw std::runtime_error("Failed to create OpenGL 3.3 core context");
+    }
+
+    context = ctx;
+
+    if(!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        eglDestroyContext(dpy, ctx);
+        eglTerminate(dpy);
+        throw std::runtime_error("Failed to make OpenGL context current");
+    }
+
+    if(!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(dpy, ctx);
+        eglTerminate(dpy);
+        throw std::runtime_error("Failed to load OpenGL functions");
+    }
+
+    LOG_INFO("OpenGL renderer: ", gl::get_string(gl::string_name::renderer));
+    LOG_INFO("OpenGL version: ", gl::get_string(gl::string_name::version));
+}
+
+jkgm::headless_context::~headless_context()
+{
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
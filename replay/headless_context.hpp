@@ -0,0 +1,20 @@
+#pragma once
+
+namespace jkgm {
+    // An OpenGL 3.3 core context without a window, on Mesa's surfaceless EGL platform. Everything
+    // is drawn into framebuffer objects. Throws when no such context can be created.
+    class headless_context {
+    private:
+        void *display = nullptr;
+        void *context = nullptr;
+
+    public:
+        headless_context();
+        ~headless_context();
+
+        headless_context(headless_context const &) = delete;
+        headless_context(headless_context &&) = delete;
+        headless_context &operator=(headless_context const &) = delete;
+        headless_context &operator=(headless_context &&) = delete;
+    };
+}
@@ -0,0 +1,167 @@
+#include "base/file_stream.hpp"
+#include "base/log.hpp"
+#include "base/range.hpp"
+#include "base/std_output_log_backend.hpp"
+#include "capture_replayer.hpp"
+#include "common/capture_file.hpp"
+#include "common/config.hpp"
+#include "common/json_incl.hpp"
+#include "headless_context.hpp"
+#include "program/options.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace jkgm {
+    namespace {
+        // Returns the sample at or below which the given fraction of samples fall
+        double get_percentile(std::vector<double> const &sorted_samples, double fraction)
+        {
+            if(sorted_samples.empty()) {
+                return 0.0;
+            }
+
+            auto idx = static_cast<size_t>(fraction * static_cast<double>(sorted_samples.size()));
+            return sorted_samples[std::min(idx, sorted_samples.size() - 1U)];
+        }
+
+        json::json summarize(std::vector<double> samples)
+        {
+            std::sort(samples.begin(), samples.end());
+
+            double total = 0.0;
+            for(double em : samples) {
+                total += em;
+            }
+
+            json::json rv;
+            rv["mean"] = samples.empty() ? 0.0 : (total / static_cast<double>(samples.size()));
+            rv["p50"] = get_percentile(samples, 0.5);
+            rv["p95"] = get_percentile(samples, 0.95);
+            rv["p99"] = get_percentile(samples, 0.99);
+            rv["max"] = samples.empty() ? 0.0 : samples.back();
+            return rv;
+        }
+
+        char const *to_string(replay_frame_kind kind)
+        {
+            switch(kind) {
+            case replay_frame_kind::game:
+                return "game";
+            case replay_frame_kind::menu:
+                return "menu";
+            }
+
+            return "unknown";
+        }
+
+        class replay_program {
+        private:
+            options opts;
+
+            std::string capture_path;
+            std::string output_path;
+            std::string data_path;
+
+        public:
+            replay_program()
+            {
+                opts.insert(make_value_option("capture", capture_path));
+                opts.insert(make_value_option("output", output_path));
+                opts.insert(make_value_option("data", data_path, std::string("assets")));
+
+                opts.emplace_constraint<required_option>(std::vector<std::string>{"capture"});
+            }
+
+            int start(range<char **> const &args)
+            {
+                try {
+                    opts.load_from_arg_list(args);
+                    return run();
+                }
+                catch(std::exception const &e) {
+                    LOG_ERROR("Exception thrown: ", e.what());
+                    return EXIT_FAILURE;
+                }
+            }
+
+            int run()
+            {
+                // Replays use the same options as the game, but load shaders from the tree
+                auto the_config = load_config_file();
+                the_config->data_path = data_path;
+
+                capture_reader reader(make_file_input_stream(capture_path));
+                auto const &header = reader.get_header();
+                LOG_INFO("Replaying ",
+                         get<x>(header.screen_res),
+                         "x",
+                         get<y>(header.screen_res),
+                         " capture ",
+                         capture_path);
+
+                headless_context context;
+                capture_replayer replayer(the_config.get(), header);
+
+                std::vector<replay_frame_timing> frames;
+                while(auto rec = reader.read_record()) {
+                    auto frame = replayer.replay_record(*rec);
+                    if(frame.has_value()) {
+                        frames.push_back(*frame);
+                    }
+                }
+
+                json::json frames_json = json::json::array();
+                std::vector<double> cpu_times;
+                std::vector<double> gpu_times;
+                for(auto const &em : frames) {
+                    json::json j;
+                    j["frame"] = em.frame_index;
+                    j["kind"] = to_string(em.kind);
+                    j["cpu_us"] = em.cpu_time;
+                    j["gpu_us"] = em.gpu_time;
+                    j["triangles"] = em.num_triangles;
+                    j["draw_calls"] = em.num_draw_calls;
+                    j["texture_uploads"] = em.num_texture_uploads;
+                    frames_json.push_back(std::move(j));
+
+                    cpu_times.push_back(em.cpu_time);
+                    gpu_times.push_back(em.gpu_time);
+                }
+
+                json::json summary;
+                summary["frames"] = frames.size();
+                summary["cpu_us"] = summarize(cpu_times);
+                summary["gpu_us"] = summarize(gpu_times);
+
+                LOG_INFO("Replayed ",
+                         frames.size(),
+                         " frames: CPU p50 ",
+                         static_cast<int>(summary["cpu_us"]["p50"].get<double>()),
+                         " us, GPU p50 ",
+                         static_cast<int>(summary["gpu_us"]["p50"].get<double>()),
+                         " us");
+
+                if(!output_path.empty()) {
+                    json::json doc;
+                    doc["summary"] = summary;
+                    doc["frames"] = frames_json;
+
+                    auto os = make_file_output_stream(output_path);
+                    os->write(make_span(doc.dump(4)));
+                }
+
+                return EXIT_SUCCESS;
+            }
+        };
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // Replays run in CI. Only errors, warnings and the summary go to standard output.
+    jkgm::emplace_log_backend<jkgm::std_output_log_backend>(
+        {jkgm::log_level::error, jkgm::log_level::warning, jkgm::log_level::info});
+
+    jkgm::replay_program program;
+    return program.start(jkgm::make_range(argv + 1, argv + argc));
+}
@@ -0,0 +1,219 @@
+#include "base/memory_block.hpp"
+#include "common/capture_file.hpp"
+#include "test_runner.hpp"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    namespace {
+        capture_header make_test_header()
+        {
+            capture_header rv;
+            rv.screen_res = make_size(1920, 1080);
+            rv.internal_screen_res = make_size(640, 480);
+            rv.display_area = make_box(make_point(240, 0), make_size(1440, 1080));
+            rv.internal_screen_scale = make_size(2.0f / 640.0f, 2.0f / 480.0f);
+            rv.internal_screen_offset = make_direction(0.25f, -0.5f);
+            return rv;
+        }
+
+        std::vector<char> make_bytes(std::string const &value)
+        {
+            return std::vector<char>(value.begin(), value.end());
+        }
+
+        std::unique_ptr<capture_reader> make_reader(memory_block const *mb)
+        {
+            return std::make_unique<capture_reader>(std::make_unique<memory_input_block>(mb));
+        }
+
+        // Writes a capture with a single execute buffer, then returns its bytes
+        std::vector<char> make_test_capture()
+        {
+            memory_block mb;
+            capture_writer writer(std::make_unique<memory_output_block>(&mb), make_test_header());
+            writer.write_execute_game(make_span(make_bytes("vertices")),
+                                      make_span(make_bytes("instructions")),
+                                      make_span(make_bytes("viewport")));
+            return std::vector<char>(mb.data(), mb.data() + mb.size());
+        }
+
+        void set_block(memory_block *mb, std::vector<char> const &bytes)
+        {
+            mb->str(std::string_view(bytes.data(), bytes.size()));
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("capture_file", "round trips the header")
+{
+    memory_block mb;
+    capture_writer writer(std::make_unique<memory_output_block>(&mb), make_test_header());
+
+    auto reader = make_reader(&mb);
+    auto const &header = reader->get_header();
+    auto expected = make_test_header();
+    CHECK(header.screen_res == expected.screen_res);
+    CHECK(header.internal_screen_res == expected.internal_screen_res);
+    CHECK(header.display_area == expected.display_area);
+    CHECK(header.internal_screen_scale == expected.internal_screen_scale);
+    CHECK(header.internal_screen_offset == expected.internal_screen_offset);
+    CHECK(!reader->read_record().has_value());
+}
+
+TEST_CASE("capture_file", "round trips every record type")
+{
+    memory_block mb;
+    capture_writer writer(std::make_unique<memory_output_block>(&mb), make_test_header());
+
+    auto vertices = make_bytes("vertices");
+    auto instructions = make_bytes("instructions");
+    auto viewport = make_bytes("viewport");
+    writer.write_execute_game(make_span(vertices), make_span(instructions), make_span(viewport));
+
+    capture_texture_info info{17U, 64U, 32U, 1U};
+    auto pixels = make_bytes("pixels");
+    writer.write_texture_load(info, make_span(pixels));
+
+    auto hud = make_bytes("hud");
+    writer.write_present_game(make_span(hud));
+
+    auto palette = make_bytes("palette");
+    auto source = make_bytes("source");
+    writer.write_present_menu(make_span(palette), make_span(source));
+
+    auto reader = make_reader(&mb);
+
+    auto rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::execute_game);
+    CHECK((rec->chunks == std::vector<std::vector<char>>{vertices, instructions, viewport}));
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::texture_load);
+    CHECK(rec->chunks.size() == 2U);
+    CHECK(rec->chunks[1] == pixels);
+
+    auto read_info = get_capture_texture_info(*rec);
+    CHECK(read_info.material_id == 17U);
+    CHECK(read_info.width == 64U);
+    CHECK(read_info.height == 32U);
+    CHECK(read_info.has_alpha == 1U);
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::hud);
+    CHECK((rec->chunks == std::vector<std::vector<char>>{hud}));
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::present_game);
+    CHECK(rec->chunks.empty());
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::menu_palette);
+    CHECK((rec->chunks == std::vector<std::vector<char>>{palette}));
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::menu_source);
+    CHECK((rec->chunks == std::vector<std::vector<char>>{source}));
+
+    rec = reader->read_record();
+    CHECK(rec.has_value());
+    CHECK(rec->type == capture_record_type::present_menu);
+    CHECK(rec->chunks.empty());
+
+    CHECK(!reader->read_record().has_value());
+}
+
+TEST_CASE("capture_file", "writes HUD and menu contents only when they change")
+{
+    memory_block mb;
+    capture_writer writer(std::make_unique<memory_output_block>(&mb), make_test_header());
+
+    auto hud = make_bytes("hud");
+    writer.write_present_game(make_span(hud));
+    writer.write_present_game(make_span(hud));
+
+    auto palette = make_bytes("palette");
+    auto source = make_bytes("source");
+    writer.write_present_menu(make_span(palette), make_span(source));
+    writer.write_present_menu(make_span(palette), make_span(source));
+
+    auto reader = make_reader(&mb);
+    std::vector<capture_record_type> types;
+    while(auto rec = reader->read_record()) {
+        types.push_back(rec->type);
+    }
+
+    CHECK((types == std::vector<capture_record_type>{capture_record_type::hud,
+                                                     capture_record_type::present_game,
+                                                     capture_record_type::present_game,
+                                                     capture_record_type::menu_palette,
+                                                     capture_record_type::menu_source,
+                                                     capture_record_type::present_menu,
+                                                     capture_record_type::present_menu}));
+}
+
+TEST_CASE("capture_file", "rejects files that are not captures")
+{
+    auto bytes = make_test_capture();
+    memory_block mb;
+
+    // Wrong magic
+    auto bad_magic = bytes;
+    bad_magic[0] = 'X';
+    set_block(&mb, bad_magic);
+    CHECK_THROWS(std::runtime_error, make_reader(&mb));
+
+    // Unsupported version
+    auto bad_version = bytes;
+    bad_version[4] = 2;
+    set_block(&mb, bad_version);
+    CHECK_THROWS(std::runtime_error, make_reader(&mb));
+
+    // Header cut off
+    set_block(&mb, std::vector<char>(bytes.begin(), bytes.begin() + 20));
+    CHECK_THROWS(std::runtime_error, make_reader(&mb));
+
+    // Empty file
+    mb.clear();
+    CHECK_THROWS(std::runtime_error, make_reader(&mb));
+}
+
+TEST_CASE("capture_file", "rejects truncated and corrupt records")
+{
+    auto bytes = make_test_capture();
+    memory_block mb;
+
+    // Every cut inside the record fails. The 56 byte file header is followed by the record.
+    constexpr size_t header_size = 56U;
+    for(size_t len = header_size + 1U; len < bytes.size(); ++len) {
+        set_block(&mb, std::vector<char>(bytes.begin(), bytes.begin() + len));
+        auto reader = make_reader(&mb);
+        CHECK_THROWS(std::runtime_error, reader->read_record());
+    }
+
+    // A cut at a record boundary is the end of the capture
+    set_block(&mb, std::vector<char>(bytes.begin(), bytes.begin() + header_size));
+    CHECK(!make_reader(&mb)->read_record().has_value());
+
+    // Implausible chunk count
+    auto bad_count = bytes;
+    bad_count[header_size + 4U] = 100;
+    set_block(&mb, bad_count);
+    CHECK_THROWS(std::runtime_error, make_reader(&mb)->read_record());
+
+    // Texture record without its info chunk
+    capture_record rec;
+    rec.type = capture_record_type::texture_load;
+    rec.chunks = {make_bytes("info"), make_bytes("pixels")};
+    CHECK_THROWS(std::runtime_error, get_capture_texture_info(rec));
+}
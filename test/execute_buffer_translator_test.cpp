@@ -0,0 +1,195 @@
+#include "base/span.hpp"
+#include "core/execute_buffer_translator.hpp"
+#include "test_runner.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace jkgm {
+    namespace {
+        class test_materials : public execute_buffer_materials {
+        public:
+            size_t get_material_shader_variant(material_instance_id /*id*/) override
+            {
+                return 0U;
+            }
+
+            bool get_material_has_alpha(material_instance_id /*id*/) override
+            {
+                return false;
+            }
+        };
+
+        class test_batches {
+        public:
+            triangle_batch world;
+            triangle_batch world_transparent;
+            triangle_batch gun;
+            triangle_batch gun_transparent;
+
+            game_triangle_batches get()
+            {
+                return game_triangle_batches{&world, &world_transparent, &gun, &gun_transparent};
+            }
+        };
+
+        class execute_buffer_builder {
+        public:
+            std::vector<char> commands;
+
+            template <class T>
+            void append(T const &value)
+            {
+                auto offset = commands.size();
+                commands.resize(offset + sizeof(T));
+                std::memcpy(commands.data() + offset, &value, sizeof(T));
+            }
+
+            void append_state(uint32_t type, uint32_t arg)
+            {
+                append(d3d::instruction{d3d::opcode::state_render, sizeof(d3d::state), 1U});
+                append(d3d::state{type, arg});
+            }
+
+            void append_triangle(uint16_t v1, uint16_t v2, uint16_t v3)
+            {
+                append(d3d::instruction{d3d::opcode::triangle, sizeof(d3d::triangle_indices), 1U});
+                append(d3d::triangle_indices{v1, v2, v3, 0U});
+            }
+        };
+
+        std::vector<d3d::tl_vertex> make_test_vertices()
+        {
+            std::vector<d3d::tl_vertex> rv;
+            for(size_t i = 0; i < 3U; ++i) {
+                rv.push_back(d3d::tl_vertex{100.0f * static_cast<float>(i),
+                                            50.0f,
+                                            0.5f,
+                                            0.5f,
+                                            0xFFFFFFFFU,
+                                            0U,
+                                            0.0f,
+                                            0.0f});
+            }
+
+            return rv;
+        }
+
+        void translate(execute_buffer_translator *translator,
+                       std::vector<d3d::tl_vertex> const &vertices,
+                       std::vector<char> const &commands)
+        {
+            translator->translate(make_span(vertices),
+                                  make_span(commands),
+                                  make_size(2.0f / 640.0f, 2.0f / 480.0f),
+                                  make_direction(0.0f, 0.0f));
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("execute_buffer_translator", "routes triangles by blend and depth write state")
+{
+    test_materials materials;
+    test_batches batches;
+    execute_buffer_translator translator(&materials, batches.get());
+
+    execute_buffer_builder eb;
+    eb.append_state(d3d::render_state::texture_handle, 7U);
+    eb.append_triangle(0U, 1U, 2U);
+    eb.append_state(d3d::render_state::alpha_blend_enable, 1U);
+    eb.append_triangle(0U, 1U, 2U);
+    eb.append_state(d3d::render_state::z_write_enable, 0U);
+    eb.append_triangle(0U, 1U, 2U);
+    eb.append_state(d3d::render_state::alpha_blend_enable, 0U);
+    eb.append_triangle(0U, 1U, 2U);
+    eb.append(d3d::instruction{d3d::opcode::exit, 0U, 0U});
+
+    translate(&translator, make_test_vertices(), eb.commands);
+
+    CHECK(batches.world.size() == 1U);
+    CHECK(batches.world_transparent.size() == 1U);
+    CHECK(batches.gun_transparent.size() == 1U);
+    CHECK(batches.gun.size() == 1U);
+
+    auto const &tri = *batches.world.begin();
+    CHECK(tri.material == material_instance_id(7U));
+
+    // Screen x 100 maps to eye space x = w * (100 * 2 / 640 - 1), with w = 1 / rhw
+    CHECK(get<w>(tri.v1.pos) == 2.0f);
+    CHECK(get<x>(tri.v1.pos) == 2.0f * ((100.0f * 2.0f / 640.0f) - 1.0f));
+}
+
+TEST_CASE("execute_buffer_translator", "rejects truncated instructions")
+{
+    test_materials materials;
+    test_batches batches;
+    execute_buffer_translator translator(&materials, batches.get());
+    auto vertices = make_test_vertices();
+
+    // Partial instruction header
+    execute_buffer_builder header_eb;
+    header_eb.append_triangle(0U, 1U, 2U);
+    header_eb.commands.resize(header_eb.commands.size() + 2U, '\0');
+    CHECK_THROWS(std::runtime_error, translate(&translator, vertices, header_eb.commands));
+
+    // Count promises more triangles than the buffer holds
+    execute_buffer_builder count_eb;
+    count_eb.append(d3d::instruction{d3d::opcode::triangle, sizeof(d3d::triangle_indices), 2U});
+    count_eb.append(d3d::triangle_indices{0U, 1U, 2U, 0U});
+    CHECK_THROWS(std::runtime_error, translate(&translator, vertices, count_eb.commands));
+
+    // Declared size is smaller than the payload
+    execute_buffer_builder size_eb;
+    size_eb.append(d3d::instruction{d3d::opcode::state_render, 4U, 1U});
+    size_eb.append(d3d::state{d3d::render_state::texture_handle, 1U});
+    CHECK_THROWS(std::runtime_error, translate(&translator, vertices, size_eb.commands));
+
+    // Payload cut off partway
+    execute_buffer_builder payload_eb;
+    payload_eb.append_state(d3d::render_state::texture_handle, 1U);
+    payload_eb.commands.resize(payload_eb.commands.size() - 3U);
+    CHECK_THROWS(std::runtime_error, translate(&translator, vertices, payload_eb.commands));
+}
+
+TEST_CASE("execute_buffer_translator", "rejects out of range vertex indices")
+{
+    test_materials materials;
+    test_batches batches;
+    execute_buffer_translator translator(&materials, batches.get());
+
+    execute_buffer_builder eb;
+    eb.append_triangle(0U, 1U, 3U);
+    CHECK_THROWS(std::runtime_error, translate(&translator, make_test_vertices(), eb.commands));
+    CHECK(batches.world.size() == 0U);
+
+    // An empty buffer is valid and produces nothing
+    translate(&translator, make_test_vertices(), {});
+    CHECK(batches.world.size() == 0U);
+}
+
+TEST_CASE("execute_buffer_translator", "numbers source vertices across the frame")
+{
+    test_materials materials;
+    test_batches batches;
+    execute_buffer_translator translator(&materials, batches.get());
+    auto vertices = make_test_vertices();
+
+    execute_buffer_builder eb;
+    eb.append_triangle(2U, 1U, 0U);
+
+    // Vertices of later execute buffers follow those of earlier ones
+    translate(&translator, vertices, eb.commands);
+    translate(&translator, vertices, eb.commands);
+    CHECK(batches.world.size() == 2U);
+    CHECK((batches.world.begin()->source_vertices == std::array<uint32_t, 3>{2U, 1U, 0U}));
+    CHECK(((batches.world.begin() + 1)->source_vertices ==
+           std::array<uint32_t, 3>{5U, 4U, 3U}));
+
+    // Numbering restarts with the next frame
+    translator.reset();
+    translate(&translator, vertices, eb.commands);
+    CHECK(((batches.world.begin() + 2)->source_vertices ==
+           std::array<uint32_t, 3>{2U, 1U, 0U}));
+}
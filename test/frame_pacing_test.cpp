@@ -0,0 +1,88 @@
+#include "core/frame_pacing.hpp"
+#include "test_runner.hpp"
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        constexpr int test_window_frames = 600;
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("frame_pacing", "waits for a full window")
+{
+    frame_pacing_accumulator acc;
+    CHECK(!acc.take_stats().has_value());
+
+    for(int i = 1; i < test_window_frames; ++i) {
+        acc.add_frame(16667.0);
+    }
+
+    CHECK(!acc.take_stats().has_value());
+
+    acc.add_frame(16667.0);
+    auto rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(rv->num_frames == test_window_frames);
+}
+
+TEST_CASE("frame_pacing", "reports the distribution of a window")
+{
+    // Alternating frames 5 ms either side of 15 ms
+    frame_pacing_accumulator acc;
+    for(int i = 0; i < test_window_frames; ++i) {
+        acc.add_frame((i % 2 == 0) ? 10000.0 : 20000.0);
+    }
+
+    auto rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(std::fabs(rv->mean_frame_time - 15000.0) < 0.001);
+    CHECK(std::fabs(rv->frame_time_stddev - 5000.0) < 0.001);
+    CHECK(rv->min_frame_time == 10000.0);
+    CHECK(rv->max_frame_time == 20000.0);
+}
+
+TEST_CASE("frame_pacing", "keeps small deviations around a large mean")
+{
+    // One microsecond either side of ten seconds
+    frame_pacing_accumulator acc;
+    for(int i = 0; i < test_window_frames; ++i) {
+        acc.add_frame((i % 2 == 0) ? 9999999.0 : 10000001.0);
+    }
+
+    auto rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(std::fabs(rv->frame_time_stddev - 1.0) < 0.001);
+
+    for(int i = 0; i < test_window_frames; ++i) {
+        acc.add_frame(10000000.0);
+    }
+
+    rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(rv->frame_time_stddev == 0.0);
+}
+
+TEST_CASE("frame_pacing", "starts a new window after taking stats")
+{
+    frame_pacing_accumulator acc;
+    for(int i = 0; i < test_window_frames; ++i) {
+        acc.add_frame((i == 0) ? 50000.0 : 16000.0);
+    }
+
+    auto rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(rv->max_frame_time == 50000.0);
+
+    for(int i = 0; i < test_window_frames; ++i) {
+        acc.add_frame((i == 0) ? 8000.0 : 17000.0);
+    }
+
+    rv = acc.take_stats();
+    CHECK(rv.has_value());
+    CHECK(rv->num_frames == test_window_frames);
+    CHECK(rv->min_frame_time == 8000.0);
+    CHECK(rv->max_frame_time == 17000.0);
+    CHECK(std::fabs(rv->mean_frame_time - (8000.0 + 17000.0 * 599.0) / 600.0) < 0.001);
+}
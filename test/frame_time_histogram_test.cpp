@@ -0,0 +1,93 @@
+#include "core/frame_time_histogram.hpp"
+#include "test_runner.hpp"
+
+namespace jkgm {
+    namespace {
+        constexpr double test_hitch_threshold = 50000.0;
+
+        frame_statistics make_test_frame(double frame_time)
+        {
+            frame_statistics rv;
+            rv.frame_time = frame_time;
+            return rv;
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("frame_time_histogram", "reports percentiles of a known distribution")
+{
+    frame_time_histogram hist(test_hitch_threshold);
+    CHECK(hist.get_percentile(0.5) == 0.0);
+
+    // One frame in the middle of each of the first 100 buckets
+    for(size_t i = 0; i < 100U; ++i) {
+        hist.add_frame(i, make_test_frame(static_cast<double>(i) * 100.0 + 50.0));
+    }
+
+    // Percentiles report the upper edge of the bucket
+    CHECK(hist.get_num_frames() == 100U);
+    CHECK(hist.get_percentile(0.0) == 100.0);
+    CHECK(hist.get_percentile(0.5) == 5000.0);
+    CHECK(hist.get_percentile(0.95) == 9500.0);
+    CHECK(hist.get_percentile(0.99) == 9900.0);
+}
+
+TEST_CASE("frame_time_histogram", "clamps percentiles to the longest frame")
+{
+    frame_time_histogram hist(test_hitch_threshold);
+    hist.add_frame(0U, make_test_frame(1234.0));
+    CHECK(hist.get_percentile(0.5) == 1234.0);
+
+    hist.add_frame(1U, make_test_frame(9950.0));
+    CHECK(hist.get_percentile(1.0) == 9950.0);
+}
+
+TEST_CASE("frame_time_histogram", "collects long frames in the overflow bucket")
+{
+    // The last regular bucket ends at half a second
+    frame_time_histogram hist(test_hitch_threshold);
+    hist.add_frame(0U, make_test_frame(499950.0));
+    hist.add_frame(1U, make_test_frame(600000.0));
+    CHECK(hist.get_percentile(0.5) == 500000.0);
+    CHECK(hist.get_percentile(1.0) == 600000.0);
+
+    // A frame of exactly half a second is past the last regular bucket, so its percentile is
+    // the longest frame observed
+    hist.reset();
+    hist.add_frame(0U, make_test_frame(500000.0));
+    hist.add_frame(1U, make_test_frame(600000.0));
+    CHECK(hist.get_percentile(0.5) == 600000.0);
+}
+
+TEST_CASE("frame_time_histogram", "records a limited number of hitches")
+{
+    frame_time_histogram hist(test_hitch_threshold);
+    for(size_t i = 0; i < 100U; ++i) {
+        // Every other frame is a hitch
+        auto stats = make_test_frame((i % 2U == 0U) ? test_hitch_threshold : 1000.0);
+        stats.num_texture_uploads = i;
+        hist.add_frame(i, stats);
+    }
+
+    auto const &hitches = hist.get_hitches();
+    CHECK(hitches.size() == 50U);
+    CHECK(hitches[1].frame_index == 2U);
+    CHECK(hitches[1].stats.num_texture_uploads == 2U);
+    CHECK(hist.get_num_unrecorded_hitches() == 0U);
+
+    // Only the first 64 hitches are annotated
+    for(size_t i = 100; i < 120U; ++i) {
+        hist.add_frame(i, make_test_frame(test_hitch_threshold * 2.0));
+    }
+
+    CHECK(hist.get_hitches().size() == 64U);
+    CHECK(hist.get_hitches().back().frame_index == 113U);
+    CHECK(hist.get_num_unrecorded_hitches() == 6U);
+
+    hist.reset();
+    CHECK(hist.get_num_frames() == 0U);
+    CHECK(hist.get_hitches().empty());
+    CHECK(hist.get_num_unrecorded_hitches() == 0U);
+}
@@ -0,0 +1,176 @@
+#include "base/job_system.hpp"
+#include "test_runner.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace jkgm {
+    namespace {
+        constexpr size_t num_test_workers = 3U;
+
+        // Spins until pred holds, with a deadline so that a scheduler bug fails instead of hangs
+        template <class PredT>
+        bool spin_until(PredT const &pred)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while(!pred()) {
+                if(std::chrono::steady_clock::now() > deadline) {
+                    return false;
+                }
+
+                std::this_thread::yield();
+            }
+
+            return true;
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("job_system", "dependencies run before dependents")
+{
+    job_system jobs(num_test_workers);
+
+    std::mutex order_lock;
+    std::vector<int> order;
+    auto record = [&](int value) {
+        return [&order_lock, &order, value] {
+            std::lock_guard<std::mutex> lk(order_lock);
+            order.push_back(value);
+        };
+    };
+
+    // Diamond: 0 before 1 and 2, which are both before 3
+    auto t0 = jobs.submit(record(0));
+    auto t1 = jobs.submit(record(1), {t0});
+    auto t2 = jobs.submit(record(2), {t0});
+    auto t3 = jobs.submit(record(3), {t1, t2});
+    jobs.wait(t3);
+
+    CHECK(order.size() == 4U);
+    CHECK(order.front() == 0);
+    CHECK(order.back() == 3);
+    CHECK(t0.is_finished() && t1.is_finished() && t2.is_finished());
+
+    // A dependency that has already finished does not hold its dependent back
+    auto t4 = jobs.submit(record(4), {t3});
+    jobs.wait(t4);
+    CHECK(order.back() == 4);
+}
+
+TEST_CASE("job_system", "parallel_for covers every index once")
+{
+    job_system jobs(num_test_workers);
+
+    constexpr size_t num_items = 10007U;
+    for(size_t grain_size : {size_t(0U), size_t(1U), size_t(64U), num_items, num_items * 2U}) {
+        std::vector<std::atomic<int>> counts(num_items);
+        jobs.parallel_for(5U, num_items, grain_size, [&](size_t first, size_t last) {
+            CHECK(first < last);
+            CHECK(grain_size == 0U || (last - first) <= grain_size);
+            for(size_t i = first; i < last; ++i) {
+                ++counts[i];
+            }
+        });
+
+        for(size_t i = 0; i < num_items; ++i) {
+            CHECK(counts[i] == ((i < 5U) ? 0 : 1));
+        }
+    }
+
+    bool called = false;
+    jobs.parallel_for(10U, 10U, 1U, [&](size_t, size_t) { called = true; });
+    CHECK(!called);
+}
+
+TEST_CASE("job_system", "idle threads steal queued work")
+{
+    job_system jobs(num_test_workers);
+
+    constexpr size_t num_children = 64U;
+    std::atomic<size_t> num_finished = 0U;
+    std::atomic<size_t> num_stolen = 0U;
+    bool all_finished = false;
+
+    // Children are queued on the deque of the worker running the parent. The parent does not
+    // run them, so they finish only if other workers steal them.
+    auto parent = jobs.submit([&] {
+        auto parent_thread = std::this_thread::get_id();
+        for(size_t i = 0; i < num_children; ++i) {
+            jobs.submit([&, parent_thread] {
+                if(std::this_thread::get_id() != parent_thread) {
+                    ++num_stolen;
+                }
+
+                ++num_finished;
+            });
+        }
+
+        all_finished = spin_until([&] { return num_finished == num_children; });
+    });
+
+    // Waiting with jobs.wait could run the parent on this thread, outside of any worker
+    CHECK(spin_until([&] { return parent.is_finished(); }));
+    jobs.wait(parent);
+    CHECK(all_finished);
+    CHECK(num_stolen == num_children);
+}
+
+TEST_CASE("job_system", "shutdown finishes queued work")
+{
+    constexpr size_t num_tasks = 1000U;
+    std::atomic<size_t> num_run = 0U;
+
+    {
+        job_system jobs(num_test_workers);
+        for(size_t i = 0; i < num_tasks; ++i) {
+            jobs.submit([&] { ++num_run; });
+        }
+    }
+
+    CHECK(num_run == num_tasks);
+
+    // Idle workers wake and exit
+    for(size_t i = 0; i < 16U; ++i) {
+        job_system jobs(num_test_workers);
+    }
+
+    // A single worker and the waiting thread complete all of the work
+    job_system inline_jobs(1U);
+    std::atomic<size_t> num_inline = 0U;
+    inline_jobs.parallel_for(0U, 100U, 1U, [&](size_t, size_t) { ++num_inline; });
+    CHECK(num_inline == 100U);
+}
+
+TEST_CASE("job_system", "exceptions propagate to waiters")
+{
+    job_system jobs(num_test_workers);
+
+    auto failed = jobs.submit([] { throw std::runtime_error("task failed"); });
+    CHECK_THROWS(std::runtime_error, jobs.wait(failed));
+    CHECK(failed.is_finished());
+
+    // Dependents inherit the exception instead of running
+    bool dependent_ran = false;
+    auto dependent = jobs.submit([&] { dependent_ran = true; }, {failed});
+    CHECK_THROWS(std::runtime_error, jobs.wait(dependent));
+    CHECK(!dependent_ran);
+
+    std::atomic<size_t> num_run = 0U;
+    CHECK_THROWS(std::runtime_error, jobs.parallel_for(0U, 64U, 1U, [&](size_t first, size_t) {
+        ++num_run;
+        if(first == 7U) {
+            throw std::runtime_error("range failed");
+        }
+    }));
+
+    // Every range still ran, and the system is still usable
+    CHECK(num_run == 64U);
+    auto ok = jobs.submit([] {});
+    jobs.wait(ok);
+    CHECK(ok.is_finished());
+}
@@ -0,0 +1,63 @@
+#include "common/quality_profile.hpp"
+#include "test_runner.hpp"
+#include <cstdio>
+
+namespace jkgm {
+    namespace {
+        // The profile is stored in the working directory
+        constexpr char const *quality_profile_filename = "jkgm_quality.json";
+
+        quality_profile make_test_profile()
+        {
+            quality_profile rv;
+            rv.hardware_signature = "Test vendor|Test renderer|1.0";
+            rv.resolution = std::make_tuple(1920, 1080);
+            rv.target_frame_time = 16.0f;
+            rv.settings.max_anisotropy = 8.0f;
+            rv.settings.enable_bloom = true;
+            rv.settings.enable_ssao = false;
+            rv.settings.enable_parallax = false;
+            rv.settings.render_scale = 0.85f;
+            return rv;
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("quality_profile", "round trips settings")
+{
+    std::remove(quality_profile_filename);
+    CHECK(!load_quality_profile(make_test_profile()).has_value());
+
+    save_quality_profile(make_test_profile());
+    auto rv = load_quality_profile(make_test_profile());
+    std::remove(quality_profile_filename);
+
+    CHECK(rv.has_value());
+    CHECK(rv->max_anisotropy == 8.0f);
+    CHECK(rv->enable_bloom);
+    CHECK(!rv->enable_ssao);
+    CHECK(!rv->enable_parallax);
+    CHECK(rv->render_scale == 0.85f);
+}
+
+TEST_CASE("quality_profile", "rejects profiles chosen for other conditions")
+{
+    save_quality_profile(make_test_profile());
+
+    auto expected = make_test_profile();
+    expected.hardware_signature = "Test vendor|Other renderer|1.0";
+    CHECK(!load_quality_profile(expected).has_value());
+
+    expected = make_test_profile();
+    expected.resolution = std::make_tuple(1280, 720);
+    CHECK(!load_quality_profile(expected).has_value());
+
+    expected = make_test_profile();
+    expected.target_frame_time = 8.0f;
+    CHECK(!load_quality_profile(expected).has_value());
+
+    CHECK(load_quality_profile(make_test_profile()).has_value());
+    std::remove(quality_profile_filename);
+}
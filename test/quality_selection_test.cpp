@@ -0,0 +1,96 @@
+#include "core/quality_selection.hpp"
+#include "test_runner.hpp"
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        quality_pass_times make_test_times(double ssao, double bloom)
+        {
+            quality_pass_times rv;
+            rv.geometry = 4.0;
+            rv.ssao = ssao;
+            rv.transparency = 1.0;
+            rv.bloom = bloom;
+            return rv;
+        }
+
+        bool is_scale(quality_settings const &settings, float scale)
+        {
+            return std::fabs(settings.render_scale - scale) < 0.001f;
+        }
+    }
+}
+
+using namespace jkgm;
+
+// The budget is 80% of the target. With every option enabled, the test scene costs 8 ms at full
+// scale plus 2 ms of bloom.
+
+TEST_CASE("quality_selection", "enables everything when it fits")
+{
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.5f, 16.0);
+    CHECK(rv.max_anisotropy == 16.0f);
+    CHECK(rv.enable_bloom);
+    CHECK(rv.enable_ssao);
+    CHECK(rv.enable_parallax);
+    CHECK(is_scale(rv, 1.0f));
+}
+
+TEST_CASE("quality_selection", "lowers render scale before dropping options")
+{
+    // 8 ms * 0.85^2 + 2 ms fits in 8 ms. 0.9 does not.
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.5f, 10.0);
+    CHECK(rv.max_anisotropy == 16.0f);
+    CHECK(rv.enable_bloom);
+    CHECK(rv.enable_ssao);
+    CHECK(is_scale(rv, 0.85f));
+}
+
+TEST_CASE("quality_selection", "drops the more expensive effect first")
+{
+    // SSAO costs more than bloom. 5 ms * 0.85^2 + 2 ms fits in 6 ms.
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.5f, 7.5);
+    CHECK(rv.max_anisotropy == 8.0f);
+    CHECK(rv.enable_bloom);
+    CHECK(!rv.enable_ssao);
+    CHECK(rv.enable_parallax);
+    CHECK(is_scale(rv, 0.85f));
+
+    // Bloom costs more than SSAO
+    rv = choose_quality_settings(make_test_times(1.0, 3.0), 0.5f, 7.5);
+    CHECK(rv.max_anisotropy == 8.0f);
+    CHECK(!rv.enable_bloom);
+    CHECK(rv.enable_ssao);
+    CHECK(is_scale(rv, 1.0f));
+}
+
+TEST_CASE("quality_selection", "keeps richer tiers above the configured minimum scale")
+{
+    // The first tier would need 0.85, which is below the configured minimum
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.9f, 10.0);
+    CHECK(rv.max_anisotropy == 8.0f);
+    CHECK(rv.enable_bloom);
+    CHECK(!rv.enable_ssao);
+    CHECK(is_scale(rv, 1.0f));
+}
+
+TEST_CASE("quality_selection", "uses the cheapest tier down to the minimum scale")
+{
+    // 5 ms * 0.6^2 fits in 2 ms
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.5f, 2.5);
+    CHECK(rv.max_anisotropy == 4.0f);
+    CHECK(!rv.enable_bloom);
+    CHECK(!rv.enable_ssao);
+    CHECK(rv.enable_parallax);
+    CHECK(is_scale(rv, 0.6f));
+}
+
+TEST_CASE("quality_selection", "falls back to the cheapest settings when nothing fits")
+{
+    auto rv = choose_quality_settings(make_test_times(3.0, 2.0), 0.5f, 1.0);
+    CHECK(rv.max_anisotropy == 1.0f);
+    CHECK(!rv.enable_bloom);
+    CHECK(!rv.enable_ssao);
+    CHECK(!rv.enable_parallax);
+    CHECK(is_scale(rv, 0.5f));
+}
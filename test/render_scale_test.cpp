@@ -0,0 +1,124 @@
+#include "core/render_scale.hpp"
+#include "test_runner.hpp"
+#include <cmath>
+
+namespace jkgm {
+    namespace {
+        // Frames to wait after a change
+        constexpr int test_cooldown_frames = 30;
+
+        bool is_scale(render_scale_controller const &rsc, float scale)
+        {
+            return std::fabs(rsc.get_scale() - scale) < 0.001f;
+        }
+
+        void add_frame_times(render_scale_controller *rsc, double frame_time, int num_frames)
+        {
+            for(int i = 0; i < num_frames; ++i) {
+                rsc->add_frame_time(frame_time);
+            }
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("render_scale", "rounds changes to whole steps")
+{
+    // Ideal scale is sqrt(10 / 20) = 0.707
+    render_scale_controller rsc(0.25f, 1.0f, 10.0);
+    CHECK(is_scale(rsc, 1.0f));
+    rsc.add_frame_time(20.0);
+    CHECK(is_scale(rsc, 0.7f));
+}
+
+TEST_CASE("render_scale", "moves at least one step")
+{
+    // Ideal scale is 0.99, which rounds to the current scale
+    render_scale_controller rsc(0.25f, 1.0f, 10.0);
+    rsc.add_frame_time(10.2);
+    CHECK(is_scale(rsc, 0.95f));
+
+    // Within the headroom band nothing changes
+    add_frame_times(&rsc, 9.0, 100);
+    CHECK(is_scale(rsc, 0.95f));
+
+    // Below the headroom band the scale grows back, up to the maximum
+    add_frame_times(&rsc, 8.4, 100);
+    CHECK(is_scale(rsc, 1.0f));
+}
+
+TEST_CASE("render_scale", "clamps to the scale range")
+{
+    render_scale_controller rsc(0.5f, 1.0f, 10.0);
+
+    // Already at the maximum
+    add_frame_times(&rsc, 1.0, 100);
+    CHECK(is_scale(rsc, 1.0f));
+
+    rsc.add_frame_time(1000.0);
+    CHECK(is_scale(rsc, 0.5f));
+
+    // Already at the minimum
+    add_frame_times(&rsc, 1000.0, 100);
+    CHECK(is_scale(rsc, 0.5f));
+
+    // A minimum above the maximum is lowered to it
+    render_scale_controller inverted(0.9f, 0.8f, 10.0);
+    CHECK(is_scale(inverted, 0.8f));
+    inverted.add_frame_time(1000.0);
+    CHECK(is_scale(inverted, 0.8f));
+}
+
+TEST_CASE("render_scale", "waits after each change")
+{
+    render_scale_controller rsc(0.25f, 1.0f, 10.0);
+    rsc.add_frame_time(10.2);
+    CHECK(is_scale(rsc, 0.95f));
+
+    add_frame_times(&rsc, 20.0, test_cooldown_frames);
+    CHECK(is_scale(rsc, 0.95f));
+
+    rsc.add_frame_time(20.0);
+    CHECK(rsc.get_scale() < 0.95f);
+}
+
+TEST_CASE("render_scale", "discards history measured at the previous scale")
+{
+    render_scale_controller rsc(0.25f, 1.0f, 10.0);
+    rsc.add_frame_time(40.0);
+    CHECK(is_scale(rsc, 0.5f));
+
+    // Had the 40 ms frame been kept, the smoothed time would still be above the target here
+    add_frame_times(&rsc, 9.0, test_cooldown_frames + 1);
+    CHECK(is_scale(rsc, 0.5f));
+}
+
+TEST_CASE("render_scale", "converges on the target")
+{
+    // GPU time proportional to pixel count
+    for(double full_scale_time : {13.0, 20.0, 35.0, 5.0}) {
+        render_scale_controller rsc(0.25f, 1.0f, 10.0);
+        double frame_time = 0.0;
+        for(int i = 0; i < 1000; ++i) {
+            auto scale = static_cast<double>(rsc.get_scale());
+            frame_time = full_scale_time * scale * scale;
+            rsc.add_frame_time(frame_time);
+        }
+
+        if(full_scale_time > 10.0) {
+            CHECK(frame_time <= 10.0);
+            CHECK(frame_time >= 8.5);
+        }
+        else {
+            CHECK(is_scale(rsc, 1.0f));
+        }
+    }
+}
+
+TEST_CASE("render_scale", "scales resolution to at least one pixel")
+{
+    CHECK(get_scaled_resolution(make_size(1920, 1080), 0.5f) == make_size(960, 540));
+    CHECK(get_scaled_resolution(make_size(1919, 1079), 0.5f) == make_size(960, 540));
+    CHECK(get_scaled_resolution(make_size(1, 1), 0.25f) == make_size(1, 1));
+}
@@ -0,0 +1,77 @@
+#include "test_runner.hpp"
+#include "base/format.hpp"
+#include "base/log.hpp"
+#include "base/std_output_log_backend.hpp"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    namespace {
+        struct test_case {
+            std::string suite;
+            std::string name;
+            std::function<void()> fn;
+        };
+
+        // Registration runs during static initialization, so the list is created on first use
+        std::vector<test_case> &get_test_cases()
+        {
+            static std::vector<test_case> rv;
+            return rv;
+        }
+
+        int run_suite(std::string const &suite)
+        {
+            size_t num_run = 0U;
+            size_t num_failed = 0U;
+            for(auto const &tc : get_test_cases()) {
+                if(tc.suite != suite) {
+                    continue;
+                }
+
+                ++num_run;
+                try {
+                    tc.fn();
+                }
+                catch(std::exception const &e) {
+                    LOG_ERROR(tc.suite, ".", tc.name, " failed: ", e.what());
+                    ++num_failed;
+                }
+            }
+
+            if(num_run == 0U) {
+                LOG_ERROR("No tests in suite ", suite);
+                return EXIT_FAILURE;
+            }
+
+            LOG_INFO(suite, ": ", num_run - num_failed, " of ", num_run, " tests passed");
+            return (num_failed == 0U) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+}
+
+jkgm::test_registration::test_registration(char const *suite,
+                                           char const *name,
+                                           std::function<void()> fn)
+{
+    get_test_cases().push_back(test_case{suite, name, std::move(fn)});
+}
+
+void jkgm::fail_check(char const *file, int line, char const *expr)
+{
+    throw test_failure(str(format(file, ":", line, ": check failed: ", expr)));
+}
+
+int main(int argc, char **argv)
+{
+    jkgm::emplace_log_backend<jkgm::std_output_log_backend>(
+        {jkgm::log_level::error, jkgm::log_level::warning, jkgm::log_level::info});
+
+    if(argc != 2) {
+        LOG_ERROR("Usage: tests <suite>");
+        return EXIT_FAILURE;
+    }
+
+    return jkgm::run_suite(argv[1]);
+}
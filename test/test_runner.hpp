@@ -0,0 +1,50 @@
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+
+namespace jkgm {
+    class test_failure : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Adds a test case to a suite during static initialization. The test executable runs one
+    // suite per invocation, so that each suite is a separate ctest test.
+    class test_registration {
+    public:
+        test_registration(char const *suite, char const *name, std::function<void()> fn);
+    };
+
+    [[noreturn]] void fail_check(char const *file, int line, char const *expr);
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST_CASE(suite, name)                                                                     \
+    static void TEST_CONCAT(test_case_, __LINE__)();                                               \
+    static ::jkgm::test_registration TEST_CONCAT(test_registration_, __LINE__)(                    \
+        suite, name, &TEST_CONCAT(test_case_, __LINE__));                                          \
+    static void TEST_CONCAT(test_case_, __LINE__)()
+
+#define CHECK(expr)                                                                                \
+    do {                                                                                           \
+        if(!(expr)) {                                                                              \
+            ::jkgm::fail_check(__FILE__, __LINE__, #expr);                                         \
+        }                                                                                          \
+    } while(false)
+
+#define CHECK_THROWS(type, expr)                                                                   \
+    do {                                                                                           \
+        bool threw = false;                                                                        \
+        try {                                                                                      \
+            expr;                                                                                  \
+        }                                                                                          \
+        catch(type const &) {                                                                      \
+            threw = true;                                                                          \
+        }                                                                                          \
+        if(!threw) {                                                                               \
+            ::jkgm::fail_check(__FILE__, __LINE__, "throws " #type ": " #expr);                    \
+        }                                                                                          \
+    } while(false)
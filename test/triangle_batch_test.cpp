@@ -0,0 +1,264 @@
+#include "base/job_system.hpp"
+#include "core/triangle_batch.hpp"
+#include "test_runner.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jkgm {
+    namespace {
+        // Vertices are given in eye space with depth in the third component, and stored the way
+        // the execute buffer translator stores them
+        triangle_vertex make_test_vertex(point<3, float> const &p)
+        {
+            return triangle_vertex(make_point(get<x>(p), get<y>(p), -get<z>(p), get<z>(p)),
+                                   make_point(0.0f, 0.0f),
+                                   color_rgba8(uint8_t(0xFFU),
+                                               uint8_t(0xFFU),
+                                               uint8_t(0xFFU),
+                                               uint8_t(0x80U)));
+        }
+
+        // Each test triangle has its own material and source vertices, which identify it in the
+        // sorted batch and across frames.
+        // Vertices are wound clockwise on screen, as Direct3D front faces are. The sorters'
+        // overlap tests assume this winding.
+        triangle make_test_triangle(size_t id,
+                                    point<3, float> const &v0,
+                                    point<3, float> const &v1,
+                                    point<3, float> const &v2,
+                                    bool alpha_test = true)
+        {
+            triangle rv(make_test_vertex(v0),
+                        make_test_vertex(v1),
+                        make_test_vertex(v2),
+                        material_instance_id(id),
+                        /*shader variant*/ 0U,
+                        alpha_test);
+
+            auto first_vertex = static_cast<uint32_t>(id * 3U);
+            rv.source_vertices = {first_vertex, first_vertex + 1U, first_vertex + 2U};
+            return rv;
+        }
+
+        // Faces the eye, centered on (cx, cy) in eye space
+        triangle make_flat_triangle(size_t id,
+                                    float cx,
+                                    float cy,
+                                    float depth,
+                                    float extent,
+                                    bool alpha_test = true)
+        {
+            return make_test_triangle(id,
+                                      make_point(cx - extent, cy - extent, depth),
+                                      make_point(cx + extent, cy - extent, depth),
+                                      make_point(cx, cy + extent, depth),
+                                      alpha_test);
+        }
+
+        std::vector<size_t> get_draw_order(triangle_batch const &tb)
+        {
+            std::vector<size_t> rv;
+            for(auto const &tri : tb) {
+                rv.push_back(tri.material.get());
+            }
+
+            return rv;
+        }
+
+        size_t get_draw_position(std::vector<size_t> const &order, size_t id)
+        {
+            return static_cast<size_t>(std::find(order.begin(), order.end(), id) - order.begin());
+        }
+
+        void sort_scene(triangle_batch *tb, std::vector<triangle> const &scene)
+        {
+            tb->clear();
+            for(auto const &tri : scene) {
+                tb->insert(tri);
+            }
+
+            tb->sort();
+        }
+
+        std::string get_mode_name(transparency_sort_mode mode)
+        {
+            return (mode == transparency_sort_mode::partition) ? "partition" : "bucketed";
+        }
+
+        struct translucent_sorter {
+            std::string name;
+            std::unique_ptr<sorted_triangle_batch> batch;
+        };
+
+        std::vector<translucent_sorter> make_translucent_sorters(job_system *jobs)
+        {
+            std::vector<translucent_sorter> rv;
+            for(bool temporal : {false, true}) {
+                for(auto mode : {transparency_sort_mode::partition,
+                                 transparency_sort_mode::bucketed}) {
+                    for(auto *sorter_jobs : {static_cast<job_system *>(nullptr), jobs}) {
+                        rv.push_back(translucent_sorter{
+                            get_mode_name(mode) + (temporal ? " temporal" : "") +
+                                (sorter_jobs ? " parallel" : ""),
+                            std::make_unique<sorted_triangle_batch>(sorter_jobs, mode, temporal)});
+                    }
+                }
+            }
+
+            return rv;
+        }
+
+        // Checks that triangles in order_ids are drawn in that order, with sorter_name in the
+        // failure message
+        void check_draw_order(std::string const &sorter_name,
+                              triangle_batch const &tb,
+                              std::vector<size_t> const &order_ids)
+        {
+            auto order = get_draw_order(tb);
+            for(size_t i = 1; i < order_ids.size(); ++i) {
+                if(get_draw_position(order, order_ids[i - 1]) >=
+                   get_draw_position(order, order_ids[i])) {
+                    throw test_failure(sorter_name + ": triangle " +
+                                       std::to_string(order_ids[i]) + " is drawn before " +
+                                       std::to_string(order_ids[i - 1]));
+                }
+            }
+        }
+    }
+}
+
+using namespace jkgm;
+
+TEST_CASE("triangle_batch", "material sort groups runs front to back")
+{
+    triangle_batch tb;
+    sort_scene(&tb,
+               {make_flat_triangle(1, 0.0f, 0.0f, 30.0f, 1.0f, /*alpha test*/ false),
+                make_flat_triangle(2, 0.0f, 0.0f, 20.0f, 1.0f, /*alpha test*/ false),
+                make_test_triangle(3,
+                                   make_point(-1.0f, -1.0f, 1.0f),
+                                   make_point(1.0f, -1.0f, 1.0f),
+                                   make_point(0.0f, 1.0f, 1.0f),
+                                   /*alpha test*/ true),
+                make_flat_triangle(1, 0.0f, 0.0f, 10.0f, 1.0f, /*alpha test*/ false),
+                make_flat_triangle(2, 0.0f, 0.0f, 5.0f, 1.0f, /*alpha test*/ false)});
+
+    // Opaque runs are ordered by their nearest triangle. Alpha tested runs are drawn last.
+    CHECK((get_draw_order(tb) == std::vector<size_t>{2U, 2U, 1U, 1U, 3U}));
+
+    std::vector<float> depths;
+    for(auto const &tri : tb) {
+        depths.push_back(get<w>(tri.v0.pos));
+    }
+
+    CHECK((depths == std::vector<float>{5.0f, 20.0f, 10.0f, 30.0f, 1.0f}));
+}
+
+TEST_CASE("triangle_batch", "translucent sorters draw stacked triangles back to front")
+{
+    job_system jobs(2U);
+    for(auto &sorter : make_translucent_sorters(&jobs)) {
+        sort_scene(sorter.batch.get(),
+                   {make_flat_triangle(1, 0.0f, 0.0f, 10.0f, 2.0f),
+                    make_flat_triangle(2, 0.5f, 0.0f, 30.0f, 2.0f),
+                    make_flat_triangle(3, 0.0f, 0.5f, 20.0f, 2.0f)});
+        check_draw_order(sorter.name, *sorter.batch, {2U, 3U, 1U});
+    }
+}
+
+TEST_CASE("triangle_batch", "translucent sorters order slanted triangles by overlap")
+{
+    // Triangle 1 is slanted. Its farthest vertex is behind triangle 2, but its near vertices lie
+    // over triangle 2 and in front of it, so triangle 2 must be drawn first. Triangle 3 is behind
+    // both.
+    std::vector<triangle> scene{make_test_triangle(1,
+                                                   make_point(-5.0f, -5.0f, 10.0f),
+                                                   make_point(40.0f, 0.0f, 50.0f),
+                                                   make_point(-5.0f, 5.0f, 10.0f)),
+                                make_flat_triangle(2, 0.0f, 0.0f, 35.0f, 20.0f),
+                                make_flat_triangle(3, 0.0f, 0.0f, 60.0f, 8.0f)};
+
+    job_system jobs(2U);
+    for(auto &sorter : make_translucent_sorters(&jobs)) {
+        sort_scene(sorter.batch.get(), scene);
+        check_draw_order(sorter.name, *sorter.batch, {3U, 2U, 1U});
+    }
+}
+
+TEST_CASE("triangle_batch", "temporal sorter repairs triangles that swap depth")
+{
+    // Enough separate triangles that a repair of two is accepted instead of a full sort
+    std::vector<triangle> scene;
+    for(size_t i = 0; i < 30U; ++i) {
+        scene.push_back(make_flat_triangle(100U + i,
+                                           -15.0f + static_cast<float>(i),
+                                           -15.0f,
+                                           15.0f + static_cast<float>(i % 7U),
+                                           0.3f));
+    }
+
+    // Triangle 1's vertices lie over triangle 2
+    scene.push_back(make_flat_triangle(1, 0.0f, 0.0f, 10.0f, 2.0f));
+    scene.push_back(make_flat_triangle(2, 0.5f, 0.5f, 20.0f, 4.0f));
+
+    job_system jobs(2U);
+    for(auto mode : {transparency_sort_mode::partition, transparency_sort_mode::bucketed}) {
+        sorted_triangle_batch tb(&jobs, mode, /*temporal*/ true);
+        std::string name = get_mode_name(mode);
+        auto frame = scene;
+
+        sort_scene(&tb, frame);
+        check_draw_order(name, tb, {2U, 1U});
+
+        // Same triangles, so last frame's order is reused. The pair now overlaps the other way.
+        std::swap(frame[30].v0, frame[31].v0);
+        std::swap(frame[30].v1, frame[31].v1);
+        std::swap(frame[30].v2, frame[31].v2);
+        sort_scene(&tb, frame);
+        check_draw_order(name + " swapped", tb, {1U, 2U});
+
+        sort_scene(&tb, frame);
+        check_draw_order(name + " unchanged", tb, {1U, 2U});
+    }
+}
+
+TEST_CASE("triangle_batch", "temporal sorter repairs a layer that moves through a stack")
+{
+    // Nearer layers are smaller, so their vertices lie over every layer behind them. The stack
+    // is deeper than the repair window.
+    std::vector<triangle> scene;
+    for(size_t i = 0; i < 100U; ++i) {
+        scene.push_back(make_flat_triangle(100U + i,
+                                           -50.0f + static_cast<float>(i),
+                                           -50.0f,
+                                           50.0f,
+                                           0.3f));
+    }
+
+    for(size_t i = 1; i <= 12U; ++i) {
+        auto depth = 10.0f + static_cast<float>(i);
+        scene.push_back(make_flat_triangle(i, 0.0f, 0.0f, depth, 0.5f * depth));
+    }
+
+    job_system jobs(2U);
+    for(auto mode : {transparency_sort_mode::partition, transparency_sort_mode::bucketed}) {
+        sorted_triangle_batch tb(&jobs, mode, /*temporal*/ true);
+        std::string name = get_mode_name(mode);
+        auto frame = scene;
+
+        sort_scene(&tb, frame);
+        check_draw_order(name, tb, {12U, 11U, 10U, 9U, 8U, 7U, 6U, 5U, 4U, 3U, 2U, 1U});
+
+        // The farthest layer moves in front of the whole stack
+        auto &moved = frame.back();
+        for(auto *v : {&moved.v0, &moved.v1, &moved.v2}) {
+            get<z>(v->pos) = -5.0f;
+            get<w>(v->pos) = 5.0f;
+        }
+
+        sort_scene(&tb, frame);
+        check_draw_order(name + " moved", tb, {11U, 10U, 9U, 8U, 7U, 6U, 5U, 4U, 3U, 2U, 1U, 12U});
+    }
+}
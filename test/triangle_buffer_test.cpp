@@ -0,0 +1,61 @@
+#include "core/triangle_buffer.hpp"
+#include "test_runner.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace jkgm;
+
+TEST_CASE("triangle_buffer", "vertex layout matches the vertex array")
+{
+    // The renderer's vertex array reads these offsets with a 28 byte stride
+    CHECK(offsetof(triangle_buffer_vertex, pos) == 0U);
+    CHECK(offsetof(triangle_buffer_vertex, texcoords) == 16U);
+    CHECK(offsetof(triangle_buffer_vertex, col) == 24U);
+    CHECK(sizeof(triangle_buffer_vertex) == 28U);
+}
+
+TEST_CASE("triangle_buffer", "packs three vertices per triangle in batch order")
+{
+    auto make_vertex = [](float base) {
+        return triangle_vertex(make_point(base, base + 1.0f, base + 2.0f, base + 3.0f),
+                               make_point(base + 4.0f, base + 5.0f),
+                               color_rgba8(static_cast<uint8_t>(base),
+                                           uint8_t(1U),
+                                           uint8_t(2U),
+                                           uint8_t(3U)));
+    };
+
+    triangle_batch tb;
+    for(size_t i = 0; i < 2U; ++i) {
+        float base = 10.0f * static_cast<float>(i);
+        tb.insert(triangle(make_vertex(base),
+                           make_vertex(base + 100.0f),
+                           make_vertex(base + 200.0f),
+                           material_instance_id(i),
+                           /*shader variant*/ 0U,
+                           /*alpha test*/ false));
+    }
+
+    std::vector<triangle_buffer_vertex> buffer(
+        7U,
+        triangle_buffer_vertex{
+            point<4, float>::zero(), point<2, float>::zero(), color_rgba8::zero()});
+    CHECK(pack_triangle_buffer(tb, make_span(buffer)) == 6U);
+
+    float expected_bases[6] = {0.0f, 100.0f, 200.0f, 10.0f, 110.0f, 210.0f};
+    for(size_t i = 0; i < 6U; ++i) {
+        auto const &vx = buffer[i];
+        float base = expected_bases[i];
+        CHECK(vx.pos == make_point(base, base + 1.0f, base + 2.0f, base + 3.0f));
+        CHECK(vx.texcoords == make_point(base + 4.0f, base + 5.0f));
+        CHECK(get<r>(vx.col) == static_cast<uint8_t>(base));
+        CHECK(get<a>(vx.col) == 3U);
+    }
+
+    // Vertices past the batch are untouched
+    CHECK((buffer[6].pos == point<4, float>::zero()));
+
+    std::vector<triangle_buffer_vertex> small_buffer(5U, buffer[6]);
+    CHECK_THROWS(std::logic_error, pack_triangle_buffer(tb, make_span(small_buffer)));
+}